@@ -46,6 +46,13 @@ License version 3 and version 2.1 along with this program.  If not, see
    sending the message on dbus */
 #define MAX_PROPERTIES_TO_QUEUE  100
 
+/* The cached layout file, bump the version when the format
+   changes so old files get ignored */
+#define LAYOUT_CACHE_VERSION     1
+#define LAYOUT_CACHE_TYPE        "(usss(ia{sv}av))"
+/* How long to wait after a change before writing it out */
+#define LAYOUT_CACHE_SAVE_DELAY  2
+
 /* Properties */
 enum {
 	PROP_0,
@@ -53,7 +60,11 @@ enum {
 	PROP_DBUSNAME,
 	PROP_STATUS,
 	PROP_TEXT_DIRECTION,
-	PROP_GROUP_EVENTS
+	PROP_GROUP_EVENTS,
+	PROP_LAYOUT_PROPERTIES,
+	PROP_LAYOUT_CACHE,
+	PROP_LAYOUT_DEPTH,
+	PROP_PAGE_SIZE
 };
 
 /* Signals */
@@ -64,6 +75,8 @@ enum {
 	ITEM_ACTIVATE,
 	EVENT_RESULT,
 	ICON_THEME_DIRS,
+	PLACEHOLDER_CHANGED,
+	MORE_CHILDREN_CHANGED,
 	LAST_SIGNAL
 };
 
@@ -91,7 +104,29 @@ struct _DbusmenuClientPrivate
 	GCancellable * menuproxy_cancel;
 
 	GCancellable * layoutcall;
+	gint layoutcall_parent;
+	gint layoutcall_revision;
+	gint layoutcall_depth;
+	gboolean layoutcall_all; /* Asked for every property, not just layout_props */
 	GVariant * layout_props;
+	gboolean layout_realize; /* New items are realized from the layout alone */
+	gboolean layout_trusted; /* Recycled items already have current properties */
+
+	gboolean layout_cache;
+	gchar * cache_hash;      /* Layout the cached tree came from, until the live one comes */
+	gchar * layout_hash;     /* Last full layout, NULL once the tree changed another way */
+	guint cache_save;
+
+	guint layout_depth;          /* Levels of submenus to get with the layout, 0 for all */
+	GHashTable * placeholders;   /* type: id, submenus whose children we haven't got */
+	GQueue * placeholder_fetches; /* type: id, waiting for the current layout call */
+
+	guint page_size;             /* Children to get at a time for placeholders, 0 for all */
+	gboolean paged_children;     /* The server has GetLayoutPage */
+	GHashTable * pages;          /* type: id -> total, submenus with children still to get */
+	GHashTable * page_revisions; /* type: id -> revision, of the first page of those in pages */
+	guint layoutcall_offset;
+	gboolean page_parsing;
 
 	gint current_revision;
 	gint my_revision;
@@ -100,7 +135,6 @@ struct _DbusmenuClientPrivate
 
 	GHashTable * type_handlers;
 
-	GArray * delayed_property_list;
 	GArray * delayed_property_listeners;
 	gint delayed_idle;
 
@@ -114,6 +148,16 @@ struct _DbusmenuClientPrivate
 
 	guint about_to_show_idle;
 	GQueue * about_to_show_to_go; /* type: about_to_show_t * */
+
+	GHashTable * lookup_cache; /* type: id -> DbusmenuMenuitem * */
+
+	/* Counters for dbusmenu_client_get_stats() */
+	guint layout_calls;
+	guint64 layout_bytes;
+	gint64 reconcile_time; /* us */
+	guint group_calls;
+	guint property_signals;
+	guint property_entries;
 };
 
 typedef struct _newItemPropData newItemPropData;
@@ -161,6 +205,9 @@ struct _properties_callback_t {
 #define DBUSMENU_CLIENT_GET_PRIVATE(o) (DBUSMENU_CLIENT(o)->priv)
 #define DBUSMENU_INTERFACE  "com.canonical.dbusmenu"
 
+/* The server has GetLayoutPage when its Capabilities have this */
+#define DBUSMENU_CAPABILITY_PAGED_CHILDREN  "paged-children"
+
 /* GObject Stuff */
 static void dbusmenu_client_class_init (DbusmenuClientClass *klass);
 static void dbusmenu_client_init       (DbusmenuClient *self);
@@ -171,23 +218,33 @@ static void get_property (GObject * obj, guint id, GValue * value, GParamSpec *
 /* Private Funcs */
 static void layout_update (GDBusProxy * proxy, guint revision, gint parent, DbusmenuClient * client);
 static void id_prop_update (GDBusProxy * proxy, gint id, gchar * property, GVariant * value, DbusmenuClient * client);
+static void id_props_update (DbusmenuClient * client, gint id, GVariant * props);
 static void id_update (GDBusProxy * proxy, gint id, DbusmenuClient * client);
 static void build_proxies (DbusmenuClient * client);
-static DbusmenuMenuitem * parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem * item, DbusmenuMenuitem * parent, GDBusProxy * proxy);
-static gint parse_layout (DbusmenuClient * client, GVariant * layout);
+static DbusmenuMenuitem * parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem * item, DbusmenuMenuitem * parent, GDBusProxy * proxy, gint depth);
+static gint parse_layout (DbusmenuClient * client, GVariant * layout, gint depth);
 static void update_layout_cb (GObject * proxy, GAsyncResult * res, gpointer data);
 static void update_layout (DbusmenuClient * client);
+static void update_layout_parent (DbusmenuClient * client, gint parent);
+static void layout_fetch_next (DbusmenuClient * client);
+static void layout_fetch_placeholder (DbusmenuClient * client, gint id);
+static void layout_fetch_page (DbusmenuClient * client, gint id, guint offset, guint count);
+static void layout_more_set (DbusmenuClient * client, DbusmenuMenuitem * item, guint total);
 static void menuitem_get_properties_cb (GVariant * properties, GError * error, gpointer data);
-static void get_properties_globber (DbusmenuClient * client, gint id, const gchar ** properties, properties_func callback, gpointer user_data);
+static void get_properties_globber (DbusmenuClient * client, gint id, properties_func callback, gpointer user_data);
 static GQuark error_domain (void);
 static void item_activated (GDBusProxy * proxy, gint id, guint timestamp, DbusmenuClient * client);
 static void menuproxy_build_cb (GObject * object, GAsyncResult * res, gpointer user_data);
 static void menuproxy_prop_changed_cb (GDBusProxy * proxy, GVariant * properties, GStrv invalidated, gpointer user_data);
+static void menuproxy_capabilities (DbusmenuClient * client, GVariant * capabilities);
 static void menuproxy_name_changed_cb (GObject * object, GParamSpec * pspec, gpointer user_data);
 static void menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVariant * params, gpointer user_data);
 static void type_handler_destroy (gpointer user_data);
 static void event_data_end (event_data_t * eventd, GError * error);
 static void about_to_show_finish_pntr (gpointer data, gpointer user_data);
+static void layout_cache_load (DbusmenuClient * client);
+static void layout_cache_save (DbusmenuClient * client);
+static void layout_cache_dirty (DbusmenuClient * client, gboolean structure);
 
 /* Globals */
 static GDBusNodeInfo *            dbusmenu_node_info = NULL;
@@ -305,6 +362,40 @@ dbusmenu_client_class_init (DbusmenuClientClass *klass)
 	                                        NULL, NULL,
 	                                        _dbusmenu_client_marshal_VOID__POINTER,
 	                                        G_TYPE_NONE, 1, G_TYPE_POINTER);
+	/**
+		DbusmenuClient::placeholder-changed:
+		@arg0: The #DbusmenuClient object
+		@arg1: The #DbusmenuMenuitem that changed
+		@arg2: Whether its children still have to be fetched
+
+		Signaled when a submenu becomes a placeholder because the
+		layout stopped above its children, and again when they
+		have been fetched.  See #DbusmenuClient:layout-depth.
+	*/
+	signals[PLACEHOLDER_CHANGED] = g_signal_new(DBUSMENU_CLIENT_SIGNAL_PLACEHOLDER_CHANGED,
+	                                        G_TYPE_FROM_CLASS (klass),
+	                                        G_SIGNAL_RUN_LAST,
+	                                        G_STRUCT_OFFSET (DbusmenuClientClass, placeholder_changed),
+	                                        NULL, NULL,
+	                                        _dbusmenu_client_marshal_VOID__OBJECT_BOOLEAN,
+	                                        G_TYPE_NONE, 2, G_TYPE_OBJECT, G_TYPE_BOOLEAN);
+	/**
+		DbusmenuClient::more-children-changed:
+		@arg0: The #DbusmenuClient object
+		@arg1: The #DbusmenuMenuitem that changed
+		@arg2: Whether it has children that haven't been fetched
+
+		Signaled when only the first pages of the children of a
+		submenu have been fetched, and again once all of them are
+		in.  See #DbusmenuClient:page-size.
+	*/
+	signals[MORE_CHILDREN_CHANGED] = g_signal_new(DBUSMENU_CLIENT_SIGNAL_MORE_CHILDREN_CHANGED,
+	                                        G_TYPE_FROM_CLASS (klass),
+	                                        G_SIGNAL_RUN_LAST,
+	                                        G_STRUCT_OFFSET (DbusmenuClientClass, more_children_changed),
+	                                        NULL, NULL,
+	                                        _dbusmenu_client_marshal_VOID__OBJECT_BOOLEAN,
+	                                        G_TYPE_NONE, 2, G_TYPE_OBJECT, G_TYPE_BOOLEAN);
 
 	g_object_class_install_property (object_class, PROP_DBUSOBJECT,
 	                                 g_param_spec_string(DBUSMENU_CLIENT_PROP_DBUS_OBJECT, "DBus Object we represent",
@@ -330,6 +421,22 @@ dbusmenu_client_class_init (DbusmenuClientClass *klass)
 	                                 g_param_spec_boolean(DBUSMENU_CLIENT_PROP_GROUP_EVENTS, "Whether or not multiple events should be grouped",
 	                                              "Event grouping lowers the number of messages on DBus and will be set automatically based on the version to optimize traffic.  It can be disabled for testing or other purposes.",
 	                                              FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_LAYOUT_PROPERTIES,
+	                                 g_param_spec_boxed(DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES, "Properties to get with the layout",
+	                                              "The properties asked for when getting the layout, an empty list asks for all of them.  When set, new menu items are realized straight from the layout without asking for the rest of their properties.  Setting it to NULL goes back to the default.",
+	                                              G_TYPE_STRV, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_LAYOUT_CACHE,
+	                                 g_param_spec_boolean(DBUSMENU_CLIENT_PROP_LAYOUT_CACHE, "Whether to keep the layout in a cache on disk",
+	                                              "When set the last tree seen for this name and object is shown right away and reconciled with the server when it answers.  The whole layout is then asked for with all of the properties, and if none of them changed the cached items are kept without asking for them again.  The cached items are realized when this is set, so add type handlers first.",
+	                                              FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_LAYOUT_DEPTH,
+	                                 g_param_spec_uint(DBUSMENU_CLIENT_PROP_LAYOUT_DEPTH, "Levels of submenus to get with the layout",
+	                                              "How many levels of submenus are fetched with the layout, zero fetches all of them.  Submenus below that are placeholders until they are about to be shown, then their children are fetched.  The child-display property needs to be one of the layout properties.",
+	                                              0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_PAGE_SIZE,
+	                                 g_param_spec_uint(DBUSMENU_CLIENT_PROP_PAGE_SIZE, "Children to get at a time for a submenu",
+	                                              "How many children of a placeholder are fetched when it is about to be shown, zero fetches all of them.  The rest are fetched with dbusmenu_client_fetch_more_children().  Only used with the layout-depth property and servers that can send pages of children.",
+	                                              0, G_MAXUINT, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
 	if (dbusmenu_node_info == NULL) {
 		GError * error = NULL;
@@ -354,6 +461,22 @@ dbusmenu_client_class_init (DbusmenuClientClass *klass)
 
 #define LAYOUT_PROPS_COUNT  6
 
+/* The properties we get along with the layout unless we've
+   been told otherwise, the rest come when the items are new */
+static GVariant *
+layout_props_default (void)
+{
+	const gchar * layout_props[LAYOUT_PROPS_COUNT + 1];
+	layout_props[0] = DBUSMENU_MENUITEM_PROP_TYPE;
+	layout_props[1] = DBUSMENU_MENUITEM_PROP_LABEL;
+	layout_props[2] = DBUSMENU_MENUITEM_PROP_VISIBLE;
+	layout_props[3] = DBUSMENU_MENUITEM_PROP_ENABLED;
+	layout_props[4] = DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY;
+	layout_props[5] = DBUSMENU_MENUITEM_PROP_ACCESSIBLE_DESC;
+	layout_props[LAYOUT_PROPS_COUNT] = NULL;
+	return g_variant_ref_sink(g_variant_new_strv(layout_props, LAYOUT_PROPS_COUNT));
+}
+
 static void
 dbusmenu_client_init (DbusmenuClient *self)
 {
@@ -373,28 +496,47 @@ dbusmenu_client_init (DbusmenuClient *self)
 	priv->menuproxy_cancel = NULL;
 
 	priv->layoutcall = NULL;
-
-	gchar * layout_props[LAYOUT_PROPS_COUNT + 1];
-	layout_props[0] = DBUSMENU_MENUITEM_PROP_TYPE;
-	layout_props[1] = DBUSMENU_MENUITEM_PROP_LABEL;
-	layout_props[2] = DBUSMENU_MENUITEM_PROP_VISIBLE;
-	layout_props[3] = DBUSMENU_MENUITEM_PROP_ENABLED;
-	layout_props[4] = DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY;
-	layout_props[5] = DBUSMENU_MENUITEM_PROP_ACCESSIBLE_DESC;
-	layout_props[LAYOUT_PROPS_COUNT] = NULL;
-	priv->layout_props = g_variant_new_strv((const gchar * const *)layout_props, LAYOUT_PROPS_COUNT);
-	g_variant_ref_sink(priv->layout_props);
+	priv->layoutcall_parent = 0;
+	priv->layoutcall_revision = 0;
+	priv->layoutcall_depth = -1;
+	priv->layoutcall_all = FALSE;
+
+	priv->layout_props = layout_props_default();
+	priv->layout_realize = FALSE;
+	priv->layout_trusted = FALSE;
+
+	priv->layout_cache = FALSE;
+	priv->cache_hash = NULL;
+	priv->layout_hash = NULL;
+	priv->cache_save = 0;
+
+	priv->layout_depth = 0;
+	priv->placeholders = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->placeholder_fetches = g_queue_new();
+
+	priv->page_size = 0;
+	priv->paged_children = FALSE;
+	priv->pages = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->page_revisions = g_hash_table_new(g_direct_hash, g_direct_equal);
+	priv->layoutcall_offset = 0;
+	priv->page_parsing = FALSE;
 
 	priv->current_revision = 0;
 	priv->my_revision = 0;
 
 	priv->dbusproxy = 0;
 
+	priv->layout_calls = 0;
+	priv->layout_bytes = 0;
+	priv->reconcile_time = 0;
+	priv->group_calls = 0;
+	priv->property_signals = 0;
+	priv->property_entries = 0;
+
 	priv->type_handlers = g_hash_table_new_full(g_str_hash, g_str_equal,
 	                                            g_free, type_handler_destroy);
 
 	priv->delayed_idle = 0;
-	priv->delayed_property_list = g_array_new(TRUE, FALSE, sizeof(gchar *));
 	priv->delayed_property_listeners = g_array_new(FALSE, FALSE, sizeof(properties_listener_t));
 
 	priv->text_direction = DBUSMENU_TEXT_DIRECTION_NONE;
@@ -408,6 +550,8 @@ dbusmenu_client_init (DbusmenuClient *self)
 	priv->about_to_show_idle = 0;
 	priv->about_to_show_to_go = NULL;
 
+	priv->lookup_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_object_unref);
+
 	return;
 }
 
@@ -416,6 +560,13 @@ dbusmenu_client_dispose (GObject *object)
 {
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(object);
 
+	/* Get the last changes out while we still have a tree */
+	if (priv->cache_save != 0) {
+		g_source_remove(priv->cache_save);
+		priv->cache_save = 0;
+		layout_cache_save(DBUSMENU_CLIENT(object));
+	}
+
 	if (priv->delayed_idle != 0) {
 		g_source_remove(priv->delayed_idle);
 		priv->delayed_idle = 0;
@@ -447,16 +598,6 @@ dbusmenu_client_dispose (GObject *object)
 		priv->about_to_show_to_go = NULL;
 	}
 
-	/* Only used for queueing up a new command, so we can
-	   just drop this array. */
-	if (priv->delayed_property_list != NULL) {
-		gchar ** dataregion = (gchar **)g_array_free(priv->delayed_property_list, FALSE);
-		if (dataregion != NULL) {
-			g_strfreev(dataregion);
-		}
-		priv->delayed_property_list = NULL;
-	}
-
 	if (priv->delayed_property_listeners != NULL) {
 		gint i;
 		GError * localerror = NULL;
@@ -523,6 +664,23 @@ dbusmenu_client_dispose (GObject *object)
 		priv->session_bus = NULL;
 	}
 
+	if (priv->lookup_cache != NULL) {
+		g_hash_table_remove_all(priv->lookup_cache);
+	}
+
+	if (priv->placeholders != NULL) {
+		g_hash_table_remove_all(priv->placeholders);
+	}
+
+	if (priv->placeholder_fetches != NULL) {
+		g_queue_clear(priv->placeholder_fetches);
+	}
+
+	if (priv->pages != NULL) {
+		g_hash_table_remove_all(priv->pages);
+		g_hash_table_remove_all(priv->page_revisions);
+	}
+
 	if (priv->root != NULL) {
 		g_object_unref(G_OBJECT(priv->root));
 		priv->root = NULL;
@@ -539,6 +697,8 @@ dbusmenu_client_finalize (GObject *object)
 
 	g_free(priv->dbus_name);
 	g_free(priv->dbus_object);
+	g_free(priv->cache_hash);
+	g_free(priv->layout_hash);
 
 	if (priv->type_handlers != NULL) {
 		g_hash_table_destroy(priv->type_handlers);
@@ -549,6 +709,28 @@ dbusmenu_client_finalize (GObject *object)
 		priv->icon_dirs = NULL;
 	}
 
+	if (priv->lookup_cache != NULL) {
+		g_hash_table_destroy(priv->lookup_cache);
+		priv->lookup_cache = NULL;
+	}
+
+	if (priv->placeholders != NULL) {
+		g_hash_table_destroy(priv->placeholders);
+		priv->placeholders = NULL;
+	}
+
+	if (priv->placeholder_fetches != NULL) {
+		g_queue_free(priv->placeholder_fetches);
+		priv->placeholder_fetches = NULL;
+	}
+
+	if (priv->pages != NULL) {
+		g_hash_table_destroy(priv->pages);
+		priv->pages = NULL;
+		g_hash_table_destroy(priv->page_revisions);
+		priv->page_revisions = NULL;
+	}
+
 	G_OBJECT_CLASS (dbusmenu_client_parent_class)->finalize (object);
 	return;
 }
@@ -578,6 +760,34 @@ set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 	case PROP_GROUP_EVENTS:
 		priv->group_events = g_value_get_boolean(value);
 		break;
+	case PROP_LAYOUT_PROPERTIES: {
+		const gchar * const * props = g_value_get_boxed(value);
+
+		g_variant_unref(priv->layout_props);
+		if (props == NULL) {
+			priv->layout_props = layout_props_default();
+			priv->layout_realize = FALSE;
+		} else {
+			priv->layout_props = g_variant_ref_sink(g_variant_new_strv(props, -1));
+			priv->layout_realize = TRUE;
+		}
+		break;
+	}
+	case PROP_LAYOUT_CACHE:
+		priv->layout_cache = g_value_get_boolean(value);
+		if (priv->layout_cache) {
+			layout_cache_load(DBUSMENU_CLIENT(obj));
+		} else if (priv->cache_save != 0) {
+			g_source_remove(priv->cache_save);
+			priv->cache_save = 0;
+		}
+		break;
+	case PROP_LAYOUT_DEPTH:
+		priv->layout_depth = g_value_get_uint(value);
+		break;
+	case PROP_PAGE_SIZE:
+		priv->page_size = g_value_get_uint(value);
+		break;
 	default:
 		g_warning("Unknown property %d.", id);
 		return;
@@ -607,6 +817,18 @@ get_property (GObject * obj, guint id, GValue * value, GParamSpec * pspec)
 	case PROP_GROUP_EVENTS:
 		g_value_set_boolean(value, priv->group_events);
 		break;
+	case PROP_LAYOUT_PROPERTIES:
+		g_value_take_boxed(value, g_variant_dup_strv(priv->layout_props, NULL));
+		break;
+	case PROP_LAYOUT_CACHE:
+		g_value_set_boolean(value, priv->layout_cache);
+		break;
+	case PROP_LAYOUT_DEPTH:
+		g_value_set_uint(value, priv->layout_depth);
+		break;
+	case PROP_PAGE_SIZE:
+		g_value_set_uint(value, priv->page_size);
+		break;
 	default:
 		g_warning("Unknown property %d.", id);
 		return;
@@ -705,6 +927,8 @@ get_properties_callback (GObject *obj, GAsyncResult * res, gpointer user_data)
 		}
 		g_variant_unref(parent);
 		g_variant_unref(params);
+
+		layout_cache_dirty(cbdata->client, FALSE);
 	}
 
 	/* Provide errors for those who we can't */
@@ -758,12 +982,9 @@ get_properties_idle (gpointer user_data)
 
 	GVariant * variant_ids = g_variant_builder_end(&builder);
 
-	/* Build up a prop list to pass */
-	GVariantType * type = g_variant_type_new("as");
-	g_variant_builder_init(&builder, type);
-	g_variant_type_free(type);
-	/* TODO: need to use delayed property list here */
-	GVariant * variant_props = g_variant_builder_end(&builder);
+	/* An empty prop list gets us all of the properties, every
+	   caller needs all of them */
+	GVariant * variant_props = g_variant_new_strv(NULL, 0);
 
 	/* Combine them into a value for the parameter */
 	g_variant_builder_init(&builder, G_VARIANT_TYPE_TUPLE);
@@ -784,13 +1005,7 @@ get_properties_idle (gpointer user_data)
 	                  NULL, /* cancellable */
 	                  get_properties_callback,
 	                  cbdata);
-
-	/* Free properties */
-	gchar ** dataregion = (gchar **)g_array_free(priv->delayed_property_list, FALSE);
-	if (dataregion != NULL) {
-		g_strfreev(dataregion);
-	}
-	priv->delayed_property_list = g_array_new(TRUE, FALSE, sizeof(gchar *));
+	priv->group_calls++;
 
 	/* Rebuild the listeners */
 	priv->delayed_property_listeners = g_array_new(FALSE, FALSE, sizeof(properties_listener_t));
@@ -821,9 +1036,11 @@ get_properties_flush (DbusmenuClient * client)
 }
 
 /* A function to group all the get_properties commands to make them
-   more efficient over dbus. */
+   more efficient over dbus.  Everyone gets all of the properties
+   of their item, the layout and the property signals cover the
+   cases where only some of them are needed. */
 static void
-get_properties_globber (DbusmenuClient * client, gint id, const gchar ** properties, properties_func callback, gpointer user_data)
+get_properties_globber (DbusmenuClient * client, gint id, properties_func callback, gpointer user_data)
 {
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
 	if (find_listener(priv->delayed_property_listeners, 0, id) != NULL) {
@@ -835,23 +1052,6 @@ get_properties_globber (DbusmenuClient * client, gint id, const gchar ** propert
 		return;
 	}
 
-	if (properties == NULL || properties[0] == NULL) {
-		/* get all case */
-		if (priv->delayed_property_list->len != 0) {
-			/* If there are entries in the list, then we'll need to
-			   remove them all, and start over */
-			gchar ** dataregion = (gchar **)g_array_free(priv->delayed_property_list, FALSE);
-			if (dataregion != NULL) {
-				g_strfreev(dataregion);
-			}
-			priv->delayed_property_list = g_array_new(TRUE, FALSE, sizeof(gchar *));
-		}
-	} else {
-		/* there could be a list we care about */
-		/* TODO: No one uses this today */
-		/* TODO: Copy them into the list */
-	}
-
 	properties_listener_t listener = {0};
 	listener.id = id;
 	listener.callback = callback;
@@ -874,6 +1074,61 @@ get_properties_globber (DbusmenuClient * client, gint id, const gchar ** propert
 	return;
 }
 
+/* Find a menuitem in our tree by its ID using the lookup
+   cache instead of walking the whole tree. */
+static DbusmenuMenuitem *
+lookup_menuitem_by_id (DbusmenuClient * client, gint id)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	DbusmenuMenuitem * res = (DbusmenuMenuitem *) g_hash_table_lookup(priv->lookup_cache, GINT_TO_POINTER(id));
+	if (res == NULL && id == 0) {
+		return priv->root;
+	}
+
+	return res;
+}
+
+/* Drop the entries for an item and all of its children from the
+   lookup cache.  An entry is only removed if it still points at
+   this item, as a replacement item with the same ID may have
+   already been added. */
+static void
+cache_remove_entries_for_menuitem (GHashTable * cache, DbusmenuMenuitem * item)
+{
+	gpointer key = GINT_TO_POINTER(dbusmenu_menuitem_get_id(item));
+	if (g_hash_table_lookup(cache, key) == item) {
+		g_hash_table_remove(cache, key);
+	}
+
+	GList *child, *children = dbusmenu_menuitem_get_children(item);
+	for (child = children; child != NULL; child = child->next) {
+		cache_remove_entries_for_menuitem(cache, child->data);
+	}
+}
+
+/* Forgets that @item and the items below it were placeholders
+   or had pages of children still to get, before they leave the
+   tree.  An ID that's already been given to another item is
+   left alone. */
+static void
+layout_forget_subtree (DbusmenuClient * client, DbusmenuMenuitem * item)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gpointer key = GINT_TO_POINTER(dbusmenu_menuitem_get_id(item));
+
+	if (g_hash_table_lookup(priv->lookup_cache, key) == item) {
+		g_hash_table_remove(priv->placeholders, key);
+		g_hash_table_remove(priv->pages, key);
+		g_hash_table_remove(priv->page_revisions, key);
+	}
+
+	GList *child, *children = dbusmenu_menuitem_get_children(item);
+	for (child = children; child != NULL; child = child->next) {
+		layout_forget_subtree(client, child->data);
+	}
+}
+
 /* Called when a server item wants to activate the menu */
 static void
 item_activated (GDBusProxy * proxy, gint id, guint timestamp, DbusmenuClient * client)
@@ -887,7 +1142,7 @@ item_activated (GDBusProxy * proxy, gint id, guint timestamp, DbusmenuClient * c
 		return;
 	}
 
-	DbusmenuMenuitem * menuitem = dbusmenu_menuitem_find_id(priv->root, id);
+	DbusmenuMenuitem * menuitem = lookup_menuitem_by_id(client, id);
 	if (menuitem == NULL) {
 		g_warning("Unable to find menu item %d to activate.", id);
 		return;
@@ -898,15 +1153,35 @@ item_activated (GDBusProxy * proxy, gint id, guint timestamp, DbusmenuClient * c
 	return;
 }
 
-/* Annoying little wrapper to make the right function update */
+/* Annoying little wrapper to make the right function update.  If
+   we were up to date with every earlier revision and the server
+   tells us only one subtree changed, we only fetch that subtree. */
 static void
 layout_update (GDBusProxy * proxy, guint revision, gint parent, DbusmenuClient * client)
 {
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	gboolean subtree = parent > 0
+		&& priv->root != NULL
+		&& priv->layoutcall == NULL
+		&& priv->my_revision >= priv->current_revision
+		&& lookup_menuitem_by_id(client, parent) != NULL;
+
 	priv->current_revision = revision;
-	if (priv->current_revision > priv->my_revision) {
-		update_layout(client);
+	if (priv->current_revision <= priv->my_revision) {
+		return;
+	}
+
+	/* A submenu we've only got some pages of, get those again
+	   rather than all of its children */
+	if (subtree && priv->page_size > 0 && priv->paged_children
+			&& g_hash_table_contains(priv->pages, GINT_TO_POINTER(parent))) {
+		DbusmenuMenuitem * item = lookup_menuitem_by_id(client, parent);
+		layout_fetch_page(client, parent, 0, _dbusmenu_menuitem_get_n_children(item));
+		return;
 	}
+
+	update_layout_parent(client, subtree ? parent : 0);
 	return;
 }
 
@@ -919,7 +1194,7 @@ id_prop_update (GDBusProxy * proxy, gint id, gchar * property, GVariant * value,
 
 	g_return_if_fail(priv->root != NULL);
 
-	DbusmenuMenuitem * menuitem = dbusmenu_menuitem_find_id(priv->root, id);
+	DbusmenuMenuitem * menuitem = lookup_menuitem_by_id(client, id);
 	if (menuitem == NULL) {
 		#ifdef MASSIVEDEBUGGING
 		g_debug("Property update '%s' on id %d which couldn't be found", property, id);
@@ -927,7 +1202,57 @@ id_prop_update (GDBusProxy * proxy, gint id, gchar * property, GVariant * value,
 		return;
 	}
 
-	dbusmenu_menuitem_property_set_variant(menuitem, property, value);
+	/* The name came in a GVariant so it's fine already */
+	_dbusmenu_menuitem_property_set_unchecked(menuitem, property, value);
+
+	return;
+}
+
+/* All the properties of one item in an ItemsPropertiesUpdated
+   signal, set together so the item only signals once */
+static void
+id_props_update (DbusmenuClient * client, gint id, GVariant * props)
+{
+	DbusmenuMenuitem * menuitem = lookup_menuitem_by_id(client, id);
+	if (menuitem == NULL) {
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Properties update on id %d which couldn't be found", id);
+		#endif
+		return;
+	}
+
+	GVariantIter properties;
+	gchar * property;
+	GVariant * value;
+	gboolean boxed = FALSE;
+
+	/* Some servers box the values one more time than they should */
+	g_variant_iter_init(&properties, props);
+	while (!boxed && g_variant_iter_next(&properties, "{&sv}", &property, &value)) {
+		boxed = g_variant_is_of_type(value, G_VARIANT_TYPE_VARIANT);
+		g_variant_unref(value);
+	}
+
+	if (G_LIKELY(!boxed)) {
+		dbusmenu_menuitem_properties_set_many(menuitem, props);
+		return;
+	}
+
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+	g_variant_iter_init(&properties, props);
+	while (g_variant_iter_loop(&properties, "{sv}", &property, &value)) {
+		if (g_variant_is_of_type(value, G_VARIANT_TYPE_VARIANT)) {
+			GVariant * internalvalue = g_variant_get_variant(value);
+			g_variant_builder_add(&builder, "{sv}", property, internalvalue);
+			g_variant_unref(internalvalue);
+		} else {
+			g_variant_builder_add(&builder, "{sv}", property, value);
+		}
+	}
+
+	dbusmenu_menuitem_properties_set_many(menuitem, g_variant_builder_end(&builder));
 
 	return;
 }
@@ -944,12 +1269,13 @@ id_update (GDBusProxy * proxy, gint id, DbusmenuClient * client)
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
 	g_return_if_fail(priv->root != NULL);
 
-	DbusmenuMenuitem * menuitem = dbusmenu_menuitem_find_id(priv->root, id);
+	DbusmenuMenuitem * menuitem = lookup_menuitem_by_id(client, id);
 	g_return_if_fail(menuitem != NULL);
 
+	/* The signal doesn't say what changed, so it's all of them */
 	g_debug("Getting properties");
 	g_object_ref(menuitem);
-	get_properties_globber(client, id, NULL, menuitem_get_properties_cb, menuitem);
+	get_properties_globber(client, id, menuitem_get_properties_cb, menuitem);
 	return;
 }
 
@@ -1000,6 +1326,13 @@ proxy_destroyed (GObject * gobj_proxy, gpointer userdata)
 {
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(userdata);
 
+	g_hash_table_remove_all(priv->lookup_cache);
+	g_hash_table_remove_all(priv->placeholders);
+	g_queue_clear(priv->placeholder_fetches);
+	g_hash_table_remove_all(priv->pages);
+	g_hash_table_remove_all(priv->page_revisions);
+	priv->paged_children = FALSE;
+
 	if (priv->root != NULL) {
 		g_object_unref(G_OBJECT(priv->root));
 		priv->root = NULL;
@@ -1210,6 +1543,14 @@ menuproxy_build_cb (GObject * object, GAsyncResult * res, gpointer user_data)
 		version = NULL;
 	}
 
+	/* See what the server can do beyond the basics */
+	GVariant * capabilities = g_dbus_proxy_get_cached_property(priv->menuproxy, "Capabilities");
+	menuproxy_capabilities(client, capabilities);
+	if (capabilities != NULL) {
+		g_variant_unref(capabilities);
+		capabilities = NULL;
+	}
+
 	/* If we get here, we don't need the DBus proxy */
 	if (priv->dbusproxy != 0) {
 		g_bus_unwatch_name(priv->dbusproxy);
@@ -1229,6 +1570,30 @@ menuproxy_build_cb (GObject * object, GAsyncResult * res, gpointer user_data)
 	return;
 }
 
+/* Look through the Capabilities of the server for the
+   features that we know how to use */
+static void
+menuproxy_capabilities (DbusmenuClient * client, GVariant * capabilities)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	priv->paged_children = FALSE;
+
+	if (capabilities == NULL || !g_variant_is_of_type(capabilities, G_VARIANT_TYPE_STRING_ARRAY)) {
+		return;
+	}
+
+	GVariantIter iter;
+	const gchar * capability;
+	g_variant_iter_init(&iter, capabilities);
+	while (g_variant_iter_next(&iter, "&s", &capability)) {
+		if (g_strcmp0(capability, DBUSMENU_CAPABILITY_PAGED_CHILDREN) == 0) {
+			priv->paged_children = TRUE;
+		}
+	}
+
+	return;
+}
+
 /* Handle the properites changing */
 static void
 menuproxy_prop_changed_cb (GDBusProxy * proxy, GVariant * properties, GStrv invalidated, gpointer user_data)
@@ -1255,6 +1620,9 @@ menuproxy_prop_changed_cb (GDBusProxy * proxy, GVariant * properties, GStrv inva
 				priv->icon_dirs = NULL;
 			}
 		}
+		if (g_strcmp0(invalid, "Capabilities") == 0) {
+			menuproxy_capabilities(DBUSMENU_CLIENT(user_data), NULL);
+		}
 	}
 
 	/* Check updates */
@@ -1302,6 +1670,9 @@ menuproxy_prop_changed_cb (GDBusProxy * proxy, GVariant * properties, GStrv inva
 				priv->group_events = FALSE;
 			}
 		}
+		if (g_strcmp0(key, "Capabilities") == 0) {
+			menuproxy_capabilities(DBUSMENU_CLIENT(user_data), value);
+		}
 	}
 
 	if (olddir != priv->text_direction) {
@@ -1353,6 +1724,8 @@ menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVarian
 	} else if (priv->root == NULL) {
 		/* Drop out here, all the rest of these really need to have a root
 		   node so we can just ignore them if there isn't one. */
+	} else if (g_strcmp0(signal, "LayoutEdits") == 0) {
+		layout_edits(client, params);
 	} else if (g_strcmp0(signal, "ItemsPropertiesUpdated") == 0) {
 		/* Remove before adding just incase there is a duplicate, against the
 		   rules, but we can handle it so let's do it. */
@@ -1360,12 +1733,15 @@ menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVarian
 		GVariant * ritemsv = g_variant_get_child_value(params, 1);
 		g_variant_iter_init(&ritems, ritemsv);
 
+		priv->property_signals++;
+		priv->property_entries += g_variant_n_children(ritemsv);
+
 		GVariant * ritem;
 		while ((ritem = g_variant_iter_next_value(&ritems)) != NULL) {
 			GVariant * idv = g_variant_get_child_value(ritem, 0);
 			gint id = g_variant_get_int32(idv);
 			g_variant_unref(idv);
-			DbusmenuMenuitem * menuitem = dbusmenu_menuitem_find_id(priv->root, id);
+			DbusmenuMenuitem * menuitem = lookup_menuitem_by_id(client, id);
 
 			if (menuitem == NULL) {
 				continue;
@@ -1388,6 +1764,7 @@ menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVarian
 		GVariantIter items;
 		GVariant * itemsv = g_variant_get_child_value(params, 0);
 		g_variant_iter_init(&items, itemsv);
+		priv->property_entries += g_variant_n_children(itemsv);
 
 		GVariant * item;
 		while ((item = g_variant_iter_next_value(&items)) != NULL) {
@@ -1395,37 +1772,22 @@ menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVarian
 			gint id = g_variant_get_int32(idv);
 			g_variant_unref(idv);
 
-			GVariantIter properties;
 			GVariant * propv = g_variant_get_child_value(item, 1);
-			g_variant_iter_init(&properties, propv);
-			gchar * property;
-			GVariant * value;
-
-			while (g_variant_iter_loop(&properties, "{sv}", &property, &value)) {
-				GVariant * internalvalue = value;
-				if (G_LIKELY(g_variant_is_of_type(value, G_VARIANT_TYPE_VARIANT))) {
-					/* Unboxing if needed */
-					internalvalue = g_variant_get_variant(value);
-				}
-
-				id_prop_update(proxy, id, property, internalvalue, client);
-
-				if (internalvalue != value) {
-					/* If we unboxed, we need to drop it, otherwise the
-					   iter_loop function will unref for us */
-					g_variant_unref(internalvalue);
-				}
-			}
+			id_props_update(client, id, propv);
 			g_variant_unref(propv);
 			g_variant_unref(item);
 		}
 		g_variant_unref(itemsv);
+
+		layout_cache_dirty(client, TRUE);
 	} else if (g_strcmp0(signal, "ItemPropertyUpdated") == 0) {
 		gint id; gchar * property; GVariant * value;
 		g_variant_get(params, "(isv)", &id, &property, &value);
 		id_prop_update(proxy, id, property, value, client);
 		g_free(property);
 		g_variant_unref(value);
+
+		layout_cache_dirty(client, TRUE);
 	} else if (g_strcmp0(signal, "ItemUpdated") == 0) {
 		gint id;
 		g_variant_get(params, "(i)", &id);
@@ -1442,10 +1804,8 @@ menuproxy_signal_cb (GDBusProxy * proxy, gchar * sender, gchar * signal, GVarian
 }
 
 /* This is the callback for the properties on a menu item.  There
-   should be all of them in the Hash, and they we use foreach to
-   copy them into the menuitem.
-   This isn't the most efficient way.  We can optimize this by
-   somehow removing the foreach.  But that is for later.  */
+   should be all of them in the dictionary, and they all get set
+   on the menuitem with a single properties-changed signal. */
 static void
 menuitem_get_properties_cb (GVariant * properties, GError * error, gpointer data)
 {
@@ -1466,15 +1826,7 @@ menuitem_get_properties_cb (GVariant * properties, GError * error, gpointer data
 		goto out;
 	}
 
-	GVariantIter iter;
-	gchar * key;
-	GVariant * value;
-
-	g_variant_iter_init(&iter, properties);
-
-	while (g_variant_iter_loop(&iter, "{sv}", &key, &value)) {
-		dbusmenu_menuitem_property_set_variant(item, key, value);
-	}
+	dbusmenu_menuitem_properties_set_many(item, properties);
 
 out:
 	g_object_unref(data);
@@ -1482,57 +1834,35 @@ out:
 	return;
 }
 
-/* This function is called to refresh the properites on an item that
-   is getting recycled with the update, but we think might have prop
-   changes. */
+/* Now that the item has its properties hand it off to the type
+   handler, or to whoever is listening for new items */
 static void
-menuitem_get_properties_replace_cb (GVariant * properties, GError * error, gpointer data)
+menuitem_realize (DbusmenuClient * client, DbusmenuMenuitem * item, DbusmenuMenuitem * parent)
 {
-	g_return_if_fail(DBUSMENU_IS_MENUITEM(data));
-	gboolean have_error = FALSE;
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gboolean handled = FALSE;
 
-	if (error != NULL) {
-		g_warning("Unable to replace properties on %d: %s", dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(data)), error->message);
-		have_error = TRUE;
-	}
+	const gchar * type;
+	type_handler_t * th = NULL;
 	
-	if (properties == NULL) {
-		have_error = TRUE;
+	type = dbusmenu_menuitem_property_get(item, DBUSMENU_MENUITEM_PROP_TYPE);
+	if (type != NULL) {
+		th = (type_handler_t *)g_hash_table_lookup(priv->type_handlers, type);
+	} else {
+		th = (type_handler_t *)g_hash_table_lookup(priv->type_handlers, DBUSMENU_CLIENT_TYPES_DEFAULT);
 	}
 
-	/* Get the list of the current properties */
-	GList * current_props = dbusmenu_menuitem_properties_list(DBUSMENU_MENUITEM(data));
-	GList * tmp = NULL;
-
-	if (!have_error && g_variant_is_of_type(properties, G_VARIANT_TYPE("a{sv}"))) {
-		GVariantIter iter;
-		g_variant_iter_init(&iter, properties);
-		gchar * name; GVariant * value;
-
-		/* Remove the entries from the current list that we have new
-		   values for.  This way we don't create signals of them being
-		   removed with the duplication of the value being changed. */
-		while (g_variant_iter_loop(&iter, "{sv}", &name, &value)) {
-			for (tmp = current_props; tmp != NULL; tmp = g_list_next(tmp)) {
-				if (g_strcmp0((gchar *)tmp->data, name) == 0) {
-					current_props = g_list_delete_link(current_props, tmp);
-					break;
-				}
-			}
-		}
+	if (th != NULL && th->cb != NULL) {
+		handled = th->cb(item, parent, client, th->user_data);
 	}
 
-	/* Remove all entries that we're not getting values for, we can
-	   assume that they no longer exist */
-	for (tmp = current_props; tmp != NULL && have_error == FALSE; tmp = g_list_next(tmp)) {
-		dbusmenu_menuitem_property_remove(DBUSMENU_MENUITEM(data), (const gchar *)tmp->data);
-	}
-	g_list_free(current_props);
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client has realized a menuitem: %d", dbusmenu_menuitem_get_id(item));
+	#endif
+	dbusmenu_menuitem_set_realized(item);
 
-	if (!have_error) {
-		menuitem_get_properties_cb(properties, error, data);
-	} else {
-		g_object_unref(data);
+	if (!handled) {
+		g_signal_emit(G_OBJECT(client), signals[NEW_MENUITEM], 0, item, TRUE);
 	}
 
 	return;
@@ -1556,36 +1886,11 @@ menuitem_get_properties_new_cb (GVariant * properties, GError * error, gpointer
 		goto out;
 	}
 
-	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(propdata->client);
-
 	/* Extra ref as get_properties will unref once itself */
 	g_object_ref(propdata->item);
 	menuitem_get_properties_cb (properties, error, propdata->item);
 
-	gboolean handled = FALSE;
-
-	const gchar * type;
-	type_handler_t * th = NULL;
-	
-	type = dbusmenu_menuitem_property_get(propdata->item, DBUSMENU_MENUITEM_PROP_TYPE);
-	if (type != NULL) {
-		th = (type_handler_t *)g_hash_table_lookup(priv->type_handlers, type);
-	} else {
-		th = (type_handler_t *)g_hash_table_lookup(priv->type_handlers, DBUSMENU_CLIENT_TYPES_DEFAULT);
-	}
-
-	if (th != NULL && th->cb != NULL) {
-		handled = th->cb(propdata->item, propdata->parent, propdata->client, th->user_data);
-	}
-
-	#ifdef MASSIVEDEBUGGING
-	g_debug("Client has realized a menuitem: %d", dbusmenu_menuitem_get_id(propdata->item));
-	#endif
-	dbusmenu_menuitem_set_realized(propdata->item);
-
-	if (!handled) {
-		g_signal_emit(G_OBJECT(propdata->client), signals[NEW_MENUITEM], 0, propdata->item, TRUE);
-	}
+	menuitem_realize(propdata->client, propdata->item, propdata->parent);
 
 out:
 	g_object_unref(propdata->item);
@@ -2021,6 +2326,9 @@ dbusmenu_client_send_about_to_show(DbusmenuClient * client, gint id, void (*cb)(
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
 	g_return_if_fail(priv != NULL);
 
+	/* The children of a placeholder are needed now */
+	layout_fetch_placeholder(client, id);
+
 	about_to_show_t * data = g_new0(about_to_show_t, 1);
 	data->id = id;
 	data->client = client;
@@ -2076,7 +2384,18 @@ parse_layout_new_child (gint id, DbusmenuClient * client, DbusmenuMenuitem * par
 		dbusmenu_menuitem_set_root(item, TRUE);
 	}
 
-	/* Get the properties queued up for this item */
+	/* Track it by ID so that signals can find it quickly */
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	g_hash_table_insert(priv->lookup_cache, GINT_TO_POINTER(id), g_object_ref(item));
+
+	/* Its properties will come with the layout, the caller
+	   realizes it once they're set */
+	if (priv->layout_realize) {
+		return item;
+	}
+
+	/* Get the properties queued up for this item, it doesn't
+	   have any of the ones outside of the layout yet */
 	/* Not happy allocating about this, but I need these :( */
 	newItemPropData * propdata = g_new0(newItemPropData, 1);
 	if (propdata != NULL) {
@@ -2085,7 +2404,7 @@ parse_layout_new_child (gint id, DbusmenuClient * client, DbusmenuMenuitem * par
 		propdata->parent  = parent;
 
 		g_object_ref(item);
-		get_properties_globber(client, id, NULL, menuitem_get_properties_new_cb, propdata);
+		get_properties_globber(client, id, menuitem_get_properties_new_cb, propdata);
 	} else {
 		g_warning("Unable to allocate memory to get properties for menuitem.  This menuitem will never be realized.");
 	}
@@ -2093,54 +2412,246 @@ parse_layout_new_child (gint id, DbusmenuClient * client, DbusmenuMenuitem * par
 	return item;
 }
 
-/* Refresh the properties on this item */
+/* Set the properties that came in a layout node on the
+   menuitem that it represents */
 static void
-parse_layout_update (DbusmenuMenuitem * item, DbusmenuClient * client)
+parse_layout_props (DbusmenuMenuitem * item, GVariant * layout)
 {
-	g_object_ref(item);
-	get_properties_globber(client, dbusmenu_menuitem_get_id(item), NULL, menuitem_get_properties_replace_cb, item);
+	GVariant * props = g_variant_get_child_value(layout, 1);
+
+	/* This sets the type first as it can manage the behavior
+	   of all the other properties. */
+	dbusmenu_menuitem_properties_set_many(item, props);
+	g_variant_unref(props);
+
 	return;
 }
 
-/* Parse recursively through the XML and make it into
-   objects as need be */
-static DbusmenuMenuitem *
-parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem * item, DbusmenuMenuitem * parent, GDBusProxy * proxy)
+/* Remove the properties that we asked for with the layout
+   but that didn't come back for this node, they're gone */
+static void
+parse_layout_props_prune (DbusmenuClient * client, DbusmenuMenuitem * item, GVariant * layout)
 {
-	if (layout == NULL) {
-		return NULL;
-	}
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	GVariant * props = g_variant_get_child_value(layout, 1);
+	GVariant * value;
 
-	/* First verify and figure out what we've got */
-	GVariant * idv = g_variant_get_child_value(layout, 0);
-	gint id = g_variant_get_int32(idv);
-	g_variant_unref(idv);
-	if (id < 0) {
-		return NULL;
-	}
-	#ifdef MASSIVEDEBUGGING
-	g_debug("Client looking at node with id: %d", id);
-	#endif
+	if (priv->layoutcall_all || g_variant_n_children(priv->layout_props) == 0) {
+		GList * current = dbusmenu_menuitem_properties_list(item);
+		GList * tmp;
 
-	g_return_val_if_fail(item != NULL, NULL);
-	g_return_val_if_fail(id == dbusmenu_menuitem_get_id(item), NULL);
+		for (tmp = current; tmp != NULL; tmp = g_list_next(tmp)) {
+			value = g_variant_lookup_value(props, (const gchar *)tmp->data, NULL);
+			if (value != NULL) {
+				g_variant_unref(value);
+			} else {
+				dbusmenu_menuitem_property_remove(item, (const gchar *)tmp->data);
+			}
+		}
+		g_list_free(current);
+	} else {
+		GVariantIter iter;
+		const gchar * name;
 
-	/* Some variables */
-	GVariantIter children;
+		g_variant_iter_init(&iter, priv->layout_props);
+		while (g_variant_iter_next(&iter, "&s", &name)) {
+			value = g_variant_lookup_value(props, name, NULL);
+			if (value != NULL) {
+				g_variant_unref(value);
+			} else {
+				dbusmenu_menuitem_property_remove(item, name);
+			}
+		}
+	}
+
+	g_variant_unref(props);
+	return;
+}
+
+/* A child node from a layout along with the menuitem that
+   it is being matched up with */
+typedef struct _layout_child_t layout_child_t;
+struct _layout_child_t {
+	gint id;
+	GVariant * layout;
+	DbusmenuMenuitem * item;
+	gint oldpos;        /* Position in the old children, -1 if new */
+	gboolean stable;    /* Recycled and doesn't need to be moved */
+};
+
+/* Get the type property out of a child node in the layout,
+   NULL if it doesn't have one */
+static GVariant *
+layout_child_type (GVariant * child)
+{
+	GVariant * child_props = g_variant_get_child_value(child, 1);
+	GVariant * type = g_variant_lookup_value(child_props, DBUSMENU_MENUITEM_PROP_TYPE, NULL);
+	g_variant_unref(child_props);
+	return type;
+}
+
+/* Find the longest set of recycled children that are already in
+   the right order relative to each other and mark them as stable.
+   Those never need to move, only everyone else does.  This is the
+   standard patience sort for longest increasing subsequence. */
+static void
+layout_mark_stable (layout_child_t * entries, guint count)
+{
+	gint * tails = g_new(gint, count + 1);
+	gint * prev = g_new(gint, count + 1);
+	guint length = 0;
+	guint i;
+
+	for (i = 0; i < count; i++) {
+		if (entries[i].oldpos < 0) {
+			continue;
+		}
+
+		guint low = 0, high = length;
+		while (low < high) {
+			guint mid = (low + high) / 2;
+			if (entries[tails[mid]].oldpos < entries[i].oldpos) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+
+		prev[i] = low > 0 ? tails[low - 1] : -1;
+		tails[low] = i;
+		if (low == length) {
+			length++;
+		}
+	}
+
+	if (length > 0) {
+		gint index;
+		for (index = tails[length - 1]; index >= 0; index = prev[index]) {
+			entries[index].stable = TRUE;
+		}
+	}
+
+	g_free(tails);
+	g_free(prev);
+	return;
+}
+
+/* Marks @item as a submenu whose children haven't been fetched
+   yet, or clears that, and tells anyone listening about it */
+static void
+layout_placeholder_set (DbusmenuClient * client, DbusmenuMenuitem * item, gboolean placeholder)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gpointer key = GINT_TO_POINTER(dbusmenu_menuitem_get_id(item));
+
+	if (g_hash_table_contains(priv->placeholders, key) == placeholder) {
+		return;
+	}
+
+	if (placeholder) {
+		g_hash_table_add(priv->placeholders, key);
+		/* Its pages all come again with the first one */
+		layout_more_set(client, item, 0);
+	} else {
+		g_hash_table_remove(priv->placeholders, key);
+	}
+
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Menu item %d is %s a placeholder", dbusmenu_menuitem_get_id(item), placeholder ? "now" : "no longer");
+	#endif
+	g_signal_emit(G_OBJECT(client), signals[PLACEHOLDER_CHANGED], 0, item, placeholder, TRUE);
+
+	return;
+}
+
+/* Keeps track of whether @item has fewer children than the
+   @total the server has for it, and tells anyone listening
+   when that changes */
+static void
+layout_more_set (DbusmenuClient * client, DbusmenuMenuitem * item, guint total)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gpointer key = GINT_TO_POINTER(dbusmenu_menuitem_get_id(item));
+	gboolean had = g_hash_table_contains(priv->pages, key);
+	gboolean more = _dbusmenu_menuitem_get_n_children(item) < total;
+
+	if (more) {
+		g_hash_table_insert(priv->pages, key, GUINT_TO_POINTER(total));
+	} else {
+		g_hash_table_remove(priv->pages, key);
+		g_hash_table_remove(priv->page_revisions, key);
+	}
+
+	if (had == more) {
+		return;
+	}
+
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Menu item %d %s children to fetch", dbusmenu_menuitem_get_id(item), more ? "has" : "has no more");
+	#endif
+	g_signal_emit(G_OBJECT(client), signals[MORE_CHILDREN_CHANGED], 0, item, more, TRUE);
+
+	return;
+}
+
+/* Parse recursively through the XML and make it into
+   objects as need be.  @depth is the number of levels of
+   children the layout has below @item, -1 when it has all
+   of them. */
+static DbusmenuMenuitem *
+parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem * item, DbusmenuMenuitem * parent, GDBusProxy * proxy, gint depth)
+{
+	if (layout == NULL) {
+		return NULL;
+	}
+
+	/* First verify and figure out what we've got */
+	GVariant * idv = g_variant_get_child_value(layout, 0);
+	gint id = g_variant_get_int32(idv);
+	g_variant_unref(idv);
+	if (id < 0) {
+		return NULL;
+	}
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client looking at node with id: %d", id);
+	#endif
+
+	g_return_val_if_fail(item != NULL, NULL);
+	g_return_val_if_fail(id == dbusmenu_menuitem_get_id(item), NULL);
+
+	/* The layout stops above our children, so it can't tell
+	   us anything about them.  Keep the ones we've got. */
+	if (depth == 0) {
+		return item;
+	}
+
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	/* Some variables */
+	GVariantIter children;
 	GVariant * childrenv;
+	guint i;
 
 	childrenv = g_variant_get_child_value(layout, 2);
 	g_variant_iter_init(&children, childrenv);
 
-	guint position = 0;
-	GList * oldchildren = g_list_copy(dbusmenu_menuitem_get_children(item));
-	/* g_debug("Starting old children: %d", g_list_length(oldchildren)); */
+	/* Index the children we've got today by ID so that we can
+	   find the ones to recycle without searching */
+	GPtrArray * olditems = g_ptr_array_new();
+	GHashTable * oldids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GList * oldchild;
+	for (oldchild = dbusmenu_menuitem_get_children(item); oldchild != NULL; oldchild = g_list_next(oldchild)) {
+		g_hash_table_insert(oldids, GINT_TO_POINTER(dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(oldchild->data))), GINT_TO_POINTER(olditems->len));
+		g_ptr_array_add(olditems, oldchild->data);
+	}
+
+	/* Go through all the XML Nodes and match them up with the
+	   menuitems that we can recycle. */
+	layout_child_t * entries = g_new0(layout_child_t, g_variant_n_children(childrenv));
+	guint count = 0;
 
-	/* Go through all the XML Nodes and make sure that we have menuitems
-	   to cover those XML nodes. */
 	GVariant * child;
 	while ((child = g_variant_iter_next_value(&children)) != NULL) {
-		/* g_debug("Looking at child: %d", position); */
 		if (g_variant_is_of_type(child, G_VARIANT_TYPE_VARIANT)) {
 			GVariant * tmp = g_variant_get_variant(child);
 			g_variant_unref(child);
@@ -2156,99 +2667,140 @@ parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem *
 			g_variant_unref(child);
 			continue;
 		}
-		DbusmenuMenuitem * childmi = NULL;
-
-		/* First see if we can recycle a node that we've already built
-		   on this menu item */
-		GList * childsearch = NULL;
-		for (childsearch = oldchildren; childsearch != NULL; childsearch = g_list_next(childsearch)) {
-			DbusmenuMenuitem * cs_mi = DBUSMENU_MENUITEM(childsearch->data);
-			if (childid == dbusmenu_menuitem_get_id(cs_mi)) {
-				GVariantIter iter;
-				gchar * prop;
-				GVariant * value;
-				GVariant * child_props;
-				GVariant * new_type = NULL;
-				GVariant * old_type = NULL;
-
-				child_props = g_variant_get_child_value(child, 1);
-				g_variant_iter_init(&iter, child_props);
-				while (g_variant_iter_loop(&iter, "{sv}", &prop, &value)) {
-					if (g_strcmp0(prop, DBUSMENU_MENUITEM_PROP_TYPE) == 0) {
-						new_type = value;
-						break;
-					}
-				}
-				g_variant_unref(child_props);
-				
-				old_type = dbusmenu_menuitem_property_get_variant(cs_mi, DBUSMENU_MENUITEM_PROP_TYPE);
-				if ((old_type == NULL && new_type == NULL) || (old_type != NULL && new_type != NULL && g_variant_compare(old_type, new_type) == 0)) {
-					// Only recycle the menu item if it's of the same type
-					oldchildren = g_list_remove(oldchildren, cs_mi);
-					childmi = cs_mi;
-				}
-				break;
-			}
-		}
 
-		if (childmi == NULL) {
-			#ifdef MASSIVEDEBUGGING
-			g_debug("Building new menu item %d at position %d", childid, position);
-			#endif
-			/* If we can't recycle, then we build a new one */
-			childmi = parse_layout_new_child(childid, client, item);
-			dbusmenu_menuitem_child_add_position(item, childmi, position);
-			g_object_unref(childmi);
-		} else {
-			#ifdef MASSIVEDEBUGGING
-			g_debug("Recycling menu item %d at position %d", childid, position);
-			#endif
-			/* If we can recycle, make sure it's in the right place */
-			dbusmenu_menuitem_child_reorder(item, childmi, position);
-			parse_layout_update(childmi, client);
-		}
-
-		/* Apply known properties sent in the structure to the
-		   menu item.  Sometimes they may just be copies */
-		if (childmi != NULL) {
-			GVariantIter iter;
-			gchar * prop;
-			GVariant * value;
-			GVariant * child_props;
-
-			/* Set the type first as it can manage the behavior of
-			   all other properties. */
-			child_props = g_variant_get_child_value(child, 1);
-			g_variant_iter_init(&iter, child_props);
-			while (g_variant_iter_loop(&iter, "{sv}", &prop, &value)) {
-				if (g_strcmp0(prop, DBUSMENU_MENUITEM_PROP_TYPE) == 0) {
-					dbusmenu_menuitem_property_set_variant(childmi, prop, value);
-				}
-			}
+		layout_child_t * entry = &entries[count++];
+		entry->id = childid;
+		entry->layout = child;
+		entry->item = NULL;
+		entry->oldpos = -1;
+		entry->stable = FALSE;
 
-			/* Now go through and do all the properties. */
-			g_variant_iter_init(&iter, child_props);
-			while (g_variant_iter_loop(&iter, "{sv}", &prop, &value)) {
-				dbusmenu_menuitem_property_set_variant(childmi, prop, value);
-			}
-			g_variant_unref(child_props);
+		gpointer oldposp = NULL;
+		if (!g_hash_table_lookup_extended(oldids, GINT_TO_POINTER(childid), NULL, &oldposp)) {
+			continue;
 		}
 
-		position++;
-		g_variant_unref(child);
+		gint oldpos = GPOINTER_TO_INT(oldposp);
+		DbusmenuMenuitem * cs_mi = DBUSMENU_MENUITEM(g_ptr_array_index(olditems, oldpos));
+
+		GVariant * new_type = layout_child_type(child);
+		GVariant * old_type = dbusmenu_menuitem_property_get_variant(cs_mi, DBUSMENU_MENUITEM_PROP_TYPE);
+		if ((old_type == NULL && new_type == NULL) || (old_type != NULL && new_type != NULL && g_variant_compare(old_type, new_type) == 0)) {
+			// Only recycle the menu item if it's of the same type
+			entry->item = cs_mi;
+			entry->oldpos = oldpos;
+			g_ptr_array_index(olditems, oldpos) = NULL;
+			g_hash_table_remove(oldids, GINT_TO_POINTER(childid));
+		}
+		if (new_type != NULL) {
+			g_variant_unref(new_type);
+		}
 	}
 
+	g_hash_table_destroy(oldids);
+
 	/* Remove any children that are no longer used by this version of
 	   the layout. */
-	GList * oldchildleft = NULL;
-	for (oldchildleft = oldchildren; oldchildleft != NULL; oldchildleft = g_list_next(oldchildleft)) {
-		DbusmenuMenuitem * oldmi = DBUSMENU_MENUITEM(oldchildleft->data);
+	for (i = 0; i < olditems->len; i++) {
+		DbusmenuMenuitem * oldmi = g_ptr_array_index(olditems, i);
+		if (oldmi == NULL) {
+			continue;
+		}
 		#ifdef MASSIVEDEBUGGING
 		g_debug("Unref'ing menu item with layout update. ID: %d", dbusmenu_menuitem_get_id(oldmi));
 		#endif
+		layout_forget_subtree(client, oldmi);
+		cache_remove_entries_for_menuitem(priv->lookup_cache, oldmi);
 		dbusmenu_menuitem_child_delete(item, oldmi);
 	}
-	g_list_free(oldchildren);
+	g_ptr_array_free(olditems, TRUE);
+
+	/* Figure out who can stay where they are */
+	layout_mark_stable(entries, count);
+
+	/* Now put everyone in place.  We walk the new order keeping track
+	   of the child placed before this one and its position.  New and
+	   moving children go right after it.  Stable children are already
+	   in order, only children that still need to move can be between
+	   them, and we remember those as being behind us. */
+	GHashTable * behind = g_hash_table_new(g_direct_hash, g_direct_equal);
+	GList * cursor = NULL;
+	gint position = -1;
+
+	for (i = 0; i < count; i++) {
+		layout_child_t * entry = &entries[i];
+
+		if (entry->item == NULL) {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Building new menu item %d at position %d", entry->id, position + 1);
+			#endif
+			/* If we can't recycle, then we build a new one */
+			entry->item = parse_layout_new_child(entry->id, client, item);
+			dbusmenu_menuitem_child_add_position(item, entry->item, position + 1);
+			g_object_unref(entry->item);
+			position++;
+		} else if (entry->stable) {
+			GList * iter = cursor != NULL ? g_list_next(cursor) : dbusmenu_menuitem_get_children(item);
+			while (iter != NULL && iter->data != entry->item) {
+				g_hash_table_add(behind, iter->data);
+				position++;
+				iter = g_list_next(iter);
+			}
+			position++;
+
+			if (iter == NULL) {
+				g_warning("Sync failed, lost track of menu item %d.", entry->id);
+				position = dbusmenu_menuitem_get_position(entry->item, item);
+				iter = _dbusmenu_menuitem_get_child_link(item, position);
+			}
+
+			cursor = iter;
+			continue;
+		} else if (g_hash_table_remove(behind, entry->item)) {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Recycling menu item %d at position %d", entry->id, position);
+			#endif
+			/* Taking it out from behind us moves everything
+			   back by one */
+			dbusmenu_menuitem_child_reorder(item, entry->item, position);
+		} else {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Recycling menu item %d at position %d", entry->id, position + 1);
+			#endif
+			dbusmenu_menuitem_child_reorder(item, entry->item, position + 1);
+			position++;
+		}
+
+		/* It's now right after the child before it */
+		cursor = cursor != NULL ? g_list_next(cursor) : dbusmenu_menuitem_get_children(item);
+	}
+
+	g_hash_table_destroy(behind);
+
+	/* Apply known properties sent in the structure to the
+	   menu items.  Sometimes they may just be copies */
+	for (i = 0; i < count; i++) {
+		layout_child_t * entry = &entries[i];
+
+		/* Items we already had only need the properties that came
+		   with the layout, the signals kept the others current */
+		if (entry->oldpos >= 0 && !priv->layout_trusted) {
+			parse_layout_props_prune(client, entry->item, entry->layout);
+		}
+
+		parse_layout_props(entry->item, entry->layout);
+
+		/* The children of a submenu on the last level get
+		   fetched when it's about to be shown */
+		if (depth == 1) {
+			layout_placeholder_set(client, entry->item,
+				g_strcmp0(dbusmenu_menuitem_property_get(entry->item, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY), DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU) == 0);
+		}
+
+		if (entry->oldpos < 0 && priv->layout_realize) {
+			menuitem_realize(client, entry->item, item);
+		}
+	}
 
 	/* We've got everything built up at this node and reconcilled */
 
@@ -2257,204 +2809,868 @@ parse_layout_xml(DbusmenuClient * client, GVariant * layout, DbusmenuMenuitem *
 		get_properties_flush(client);
 	}
 
-	/* now it's time to recurse down the tree. */
+	/* now it's time to recurse down the tree. */
+	for (i = 0; i < count; i++) {
+		layout_child_t * entry = &entries[i];
+
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Recursing parse_layout_xml.  XML ID: %d  MI ID: %d", entry->id, dbusmenu_menuitem_get_id(entry->item));
+		#endif
+
+		parse_layout_xml(client, entry->layout, entry->item, item, proxy, depth < 0 ? -1 : depth - 1);
+		g_variant_unref(entry->layout);
+	}
+
+	g_free(entries);
+	g_variant_unref(childrenv);
+
+	/* Our children are all in now, unless this is just the
+	   first page of them */
+	layout_placeholder_set(client, item, FALSE);
+	if (!priv->page_parsing) {
+		layout_more_set(client, item, 0);
+	}
+
+	return item;
+}
+
+/* Take the layout passed to us over DBus and turn it into
+   a set of beautiful objects */
+static gint
+parse_layout (DbusmenuClient * client, GVariant * layout, gint depth)
+{
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client Parsing a new layout");
+	#endif 
+
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	DbusmenuMenuitem * oldroot = priv->root;
+
+	if (priv->root == NULL) {
+		priv->root = parse_layout_new_child(0, client, NULL);
+	} else if (!priv->layout_trusted) {
+		parse_layout_props_prune(client, priv->root, layout);
+	}
+
+	/* The root's properties come with the layout too */
+	if (priv->layout_realize || oldroot != NULL) {
+		parse_layout_props(priv->root, layout);
+	}
+	if (priv->layout_realize && oldroot == NULL) {
+		menuitem_realize(client, priv->root, NULL);
+	}
+
+	priv->root = parse_layout_xml(client, layout, priv->root, NULL, priv->menuproxy, depth);
+
+	if (priv->root == NULL) {
+		g_warning("Unable to parse layout on client %s object %s: %s", priv->dbus_name, priv->dbus_object, g_variant_print(layout, TRUE));
+	}
+
+	if (priv->root != oldroot) {
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Client signaling root changed.");
+		#endif 
+
+		/* If they are different, and there was an old root we must
+		   clean up that old root */
+		if (oldroot != NULL) {
+			layout_forget_subtree(client, oldroot);
+			cache_remove_entries_for_menuitem(priv->lookup_cache, oldroot);
+			dbusmenu_menuitem_set_root(oldroot, FALSE);
+			g_object_unref(oldroot);
+			oldroot = NULL;
+		}
+
+		/* If the root changed we can signal that */
+		g_signal_emit(G_OBJECT(client), signals[ROOT_CHANGED], 0, priv->root, TRUE);
+	}
+
+	return 1;
+}
+
+/* Reconcile just the subtree under the item @id with a layout
+   that starts at that item.  Returns FALSE if we can't. */
+static gboolean
+parse_layout_subtree (DbusmenuClient * client, gint id, GVariant * layout)
+{
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client Parsing a layout update for subtree %d", id);
+	#endif 
+
+	DbusmenuMenuitem * item = lookup_menuitem_by_id(client, id);
+	if (item == NULL) {
+		return FALSE;
+	}
+
+	GVariant * idv = g_variant_get_child_value(layout, 0);
+	gint layoutid = g_variant_get_int32(idv);
+	g_variant_unref(idv);
+	if (layoutid != id) {
+		return FALSE;
+	}
+
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	if (parse_layout_xml(client, layout, item, dbusmenu_menuitem_get_parent(item), priv->menuproxy, priv->layoutcall_depth) == NULL) {
+		return FALSE;
+	}
+
+	get_properties_flush(client);
+
+	return TRUE;
+}
+
+/* Apply a single edit from a LayoutEdits signal.  Returns FALSE
+   if it doesn't match what we've got, then we're out of sync. */
+static gboolean
+layout_edit_apply (DbusmenuClient * client, DbusmenuLayoutEdit op, gint id, gint parentid, gint position, GVariant * layout)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	DbusmenuMenuitem * parent = lookup_menuitem_by_id(client, parentid);
+	DbusmenuMenuitem * item = lookup_menuitem_by_id(client, id);
+
+	if (parent == NULL || id <= 0 || position < 0) {
+		return FALSE;
+	}
+
+	switch (op) {
+	case DBUSMENU_LAYOUT_EDIT_INSERT: {
+		if (item != NULL || (guint)position > _dbusmenu_menuitem_get_n_children(parent)) {
+			return FALSE;
+		}
+		if (!g_variant_is_of_type(layout, G_VARIANT_TYPE("(ia{sv}av)"))) {
+			return FALSE;
+		}
+
+		GVariant * idv = g_variant_get_child_value(layout, 0);
+		gint layoutid = g_variant_get_int32(idv);
+		g_variant_unref(idv);
+		if (layoutid != id) {
+			return FALSE;
+		}
+
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Edit inserting menu item %d under %d at %d", id, parentid, position);
+		#endif
+		item = parse_layout_new_child(id, client, parent);
+		dbusmenu_menuitem_child_add_position(parent, item, position);
+		g_object_unref(item);
+
+		parse_layout_props(item, layout);
+		if (priv->layout_realize) {
+			menuitem_realize(client, item, parent);
+		}
+		return parse_layout_xml(client, layout, item, parent, priv->menuproxy, -1) != NULL;
+	}
+	case DBUSMENU_LAYOUT_EDIT_REMOVE:
+		if (item == NULL || dbusmenu_menuitem_get_parent(item) != parent) {
+			return FALSE;
+		}
+
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Edit removing menu item %d from %d", id, parentid);
+		#endif
+		layout_forget_subtree(client, item);
+		cache_remove_entries_for_menuitem(priv->lookup_cache, item);
+		dbusmenu_menuitem_child_delete(parent, item);
+		return TRUE;
+	case DBUSMENU_LAYOUT_EDIT_MOVE:
+		if (item == NULL || dbusmenu_menuitem_get_parent(item) != parent ||
+				(guint)position >= _dbusmenu_menuitem_get_n_children(parent)) {
+			return FALSE;
+		}
+
+		#ifdef MASSIVEDEBUGGING
+		g_debug("Edit moving menu item %d under %d to %d", id, parentid, position);
+		#endif
+		dbusmenu_menuitem_child_reorder(parent, item, position);
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* The server sent us the edits it made since its last layout
+   update.  If we're on the revision right before them we can
+   apply them and skip getting the layout, otherwise we have to
+   get it all over again. */
+static void
+layout_edits (DbusmenuClient * client, GVariant * params)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	guint revision;
+	GVariant * edits;
+
+	g_variant_get(params, "(u@a(uiiiiv))", &revision, &edits);
+
+	/* Nothing new for us, or there's a layout coming that
+	   will be at least this new anyway */
+	if (revision <= priv->my_revision || priv->layoutcall != NULL) {
+		g_variant_unref(edits);
+		return;
+	}
+
+	gboolean synced = TRUE;
+	GVariantIter iter;
+	guint editrev;
+	gint op, id, parentid, position;
+	GVariant * layout;
+
+	g_variant_iter_init(&iter, edits);
+	while (synced && g_variant_iter_next(&iter, "(uiiiiv)", &editrev, &op, &id, &parentid, &position, &layout)) {
+		if (editrev > priv->my_revision) {
+			if (editrev == priv->my_revision + 1 && layout_edit_apply(client, op, id, parentid, position, layout)) {
+				priv->my_revision = editrev;
+			} else {
+				synced = FALSE;
+			}
+		}
+		g_variant_unref(layout);
+	}
+	g_variant_unref(edits);
+
+	priv->current_revision = MAX(priv->current_revision, revision);
+
+	if (!synced || priv->my_revision != revision) {
+		g_debug("Layout edits up to revision %d don't apply, getting the layout.", revision);
+		priv->my_revision = 0;
+		update_layout(client);
+		return;
+	}
+
+	get_properties_flush(client);
+	layout_cache_dirty(client, TRUE);
+
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client signaling layout has changed.");
+	#endif 
+	g_signal_emit(G_OBJECT(client), signals[LAYOUT_UPDATED], 0, TRUE);
+
+	return;
+}
+
+/* When the layout property returns, here's where we take care of that. */
+static void
+update_layout_cb (GObject * proxy, GAsyncResult * res, gpointer data)
+{
+	DbusmenuClient * client = DBUSMENU_CLIENT(data);
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	GError * error = NULL;
+	GVariant * params = NULL;
+	GVariant * layout = NULL;
+
+	params = g_dbus_proxy_call_finish(G_DBUS_PROXY(proxy), res, &error);
+
+	if (error != NULL) {
+		g_warning("Getting layout failed: %s", error->message);
+		gboolean retry = priv->layoutcall_parent != 0 && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+		g_error_free(error);
+		if (priv->layoutcall != NULL) {
+			g_object_unref(priv->layoutcall);
+			priv->layoutcall = NULL;
+		}
+		/* The subtree may have been removed on the server before we
+		   asked for it, fall back to getting everything. */
+		if (retry) {
+			update_layout(client);
+		}
+		goto out;
+	}
+
+	/* The call is done, clear it so that we can make another
+	   one if we need to */
+	if (priv->layoutcall != NULL) {
+		g_object_unref(priv->layoutcall);
+		priv->layoutcall = NULL;
+	}
+
+	GVariant * revv = g_variant_get_child_value(params, 0);
+	guint rev = g_variant_get_uint32(revv);
+	g_variant_unref(revv);
+
+	layout = g_variant_get_child_value(params, 1);
+
+	priv->layout_calls++;
+	priv->layout_bytes += g_variant_get_size(params);
+	gint64 start = g_get_monotonic_time();
+
+	if (priv->layoutcall_parent != 0) {
+		/* Only a subtree was requested.  Everything outside of it that
+		   changed after the revision we asked about will come with its
+		   own signal, so we can't claim to be any newer than that. */
+		gboolean parsed = parse_layout_subtree(client, priv->layoutcall_parent, layout);
+		priv->reconcile_time += g_get_monotonic_time() - start;
+
+		if (parsed) {
+			priv->my_revision = MAX(priv->my_revision, priv->layoutcall_revision);
+			layout_cache_dirty(client, TRUE);
+		} else {
+			/* The subtree went away underneath us, get everything */
+			priv->my_revision = 0;
+			update_layout(client);
+			goto out;
+		}
+	} else {
+		g_free(priv->layout_hash);
+		priv->layout_hash = NULL;
+
+		if (priv->layoutcall_all) {
+			priv->layout_hash = g_compute_checksum_for_data(G_CHECKSUM_SHA1, g_variant_get_data(layout), g_variant_get_size(layout));
+
+			/* The cached tree came from this same layout with all of
+			   its properties, so they're as good as asking again */
+			priv->layout_trusted = g_strcmp0(priv->layout_hash, priv->cache_hash) == 0;
+		}
+		g_free(priv->cache_hash);
+		priv->cache_hash = NULL;
+
+		guint parseable = parse_layout(client, layout, priv->layoutcall_depth);
+		priv->layout_trusted = FALSE;
+		priv->layoutcall_all = FALSE;
+		priv->reconcile_time += g_get_monotonic_time() - start;
+
+		if (parseable == 0) {
+			g_warning("Unable to parse layout!");
+			goto out;
+		}
+
+		priv->my_revision = rev;
+		layout_cache_dirty(client, FALSE);
+	}
+	/* g_debug("Root is now: 0x%X", (unsigned int)priv->root); */
+	#ifdef MASSIVEDEBUGGING
+	g_debug("Client signaling layout has changed.");
+	#endif 
+	g_signal_emit(G_OBJECT(client), signals[LAYOUT_UPDATED], 0, TRUE);
+
+	/* Check to see if we got another update in the time this
+	   one was issued. */
+	if (priv->my_revision < priv->current_revision) {
+		update_layout(client);
+	}
+
+	/* Submenus that were opened while we were busy */
+	layout_fetch_next(client);
+
+out:
+	if (layout != NULL) {
+		g_variant_unref(layout);
+	}
+
+	if (params != NULL) {
+		g_variant_unref(params);
+	}
+
+	g_object_unref(G_OBJECT(client));
+	return;
+}
+
+/* Call the property on the server we're connected to and set it up to
+   be async back to _update_layout_cb */
+static void
+update_layout (DbusmenuClient * client)
+{
+	update_layout_parent(client, 0);
+	return;
+}
+
+/* Request the layout under @parent, which is the whole menu
+   when @parent is zero */
+static void
+update_layout_parent (DbusmenuClient * client, gint parent)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	g_return_if_fail(priv->layout_props != NULL);
+
+	if (priv->menuproxy == NULL) {
+		return;
+	}
+
+	gchar * name_owner = g_dbus_proxy_get_name_owner(priv->menuproxy);
+	if (name_owner == NULL) {
+		return;
+	}
+	g_free(name_owner);
+
+	if (priv->layoutcall != NULL) {
+		return;
+	}
+
+	priv->layoutcall = g_cancellable_new();
+	priv->layoutcall_parent = parent;
+	priv->layoutcall_revision = priv->current_revision;
+	priv->layoutcall_depth = priv->layout_depth == 0 ? -1 : (gint)MIN(priv->layout_depth, G_MAXINT);
+
+	/* The hash of the whole layout says whether the cached tree
+	   is still right, so it has to cover all of the properties */
+	priv->layoutcall_all = parent == 0 && priv->layout_cache;
+
+	GVariantBuilder tupleb;
+	g_variant_builder_init(&tupleb, G_VARIANT_TYPE_TUPLE);
+	
+	g_variant_builder_add_value(&tupleb, g_variant_new_int32(parent)); // root
+	g_variant_builder_add_value(&tupleb, g_variant_new_int32(priv->layoutcall_depth)); // recurse
+	if (priv->layoutcall_all) {
+		g_variant_builder_add_value(&tupleb, g_variant_new_strv(NULL, 0)); // all props
+	} else {
+		g_variant_builder_add_value(&tupleb, priv->layout_props); // props
+	}
+
+	GVariant * args = g_variant_builder_end(&tupleb);
+	// g_debug("Args (type: %s): %s", g_variant_get_type_string(args), g_variant_print(args, TRUE));
+
+	g_object_ref(G_OBJECT(client));
+	g_dbus_proxy_call(priv->menuproxy,
+	                  "GetLayout",
+	                  args,
+	                  G_DBUS_CALL_FLAGS_NONE,
+	                  -1,   /* timeout */
+	                  priv->layoutcall, /* cancellable */
+	                  update_layout_cb,
+	                  client);
+
+	return;
+}
+
+/* Get the children of the placeholders that are waiting, one
+   subtree at a time.  If we're behind the server we have to get
+   the whole layout first. */
+static void
+layout_fetch_next (DbusmenuClient * client)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	while (priv->layoutcall == NULL && !g_queue_is_empty(priv->placeholder_fetches)) {
+		gint id = GPOINTER_TO_INT(g_queue_pop_head(priv->placeholder_fetches));
+		DbusmenuMenuitem * item = lookup_menuitem_by_id(client, id);
+		gboolean placeholder = g_hash_table_contains(priv->placeholders, GINT_TO_POINTER(id));
+
+		if (item == NULL || (!placeholder && !g_hash_table_contains(priv->pages, GINT_TO_POINTER(id)))) {
+			continue;
+		}
+
+		if (priv->my_revision < priv->current_revision) {
+			g_queue_push_head(priv->placeholder_fetches, GINT_TO_POINTER(id));
+			update_layout(client);
+			return;
+		}
+
+		guint nchildren = _dbusmenu_menuitem_get_n_children(item);
+		gboolean paging = priv->page_size > 0 && priv->paged_children;
+
+		if (!placeholder) {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Fetching more children of %d after %d", id, nchildren);
+			#endif
+			layout_fetch_page(client, id, nchildren, paging ? priv->page_size : G_MAXUINT32);
+		} else if (paging) {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Fetching the first page of children of placeholder %d", id);
+			#endif
+			layout_fetch_page(client, id, 0, MAX(priv->page_size, nchildren));
+		} else {
+			#ifdef MASSIVEDEBUGGING
+			g_debug("Fetching the children of placeholder %d", id);
+			#endif
+			update_layout_parent(client, id);
+		}
+	}
+
+	return;
+}
+
+/* Queue getting the children of @id unless they're already
+   on their way */
+static void
+layout_fetch_queue (DbusmenuClient * client, gint id)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	/* Already on its way */
+	if ((priv->layoutcall != NULL && priv->layoutcall_parent == id) ||
+			g_queue_find(priv->placeholder_fetches, GINT_TO_POINTER(id)) != NULL) {
+		return;
+	}
+
+	g_queue_push_tail(priv->placeholder_fetches, GINT_TO_POINTER(id));
+	layout_fetch_next(client);
+
+	return;
+}
+
+/* Queue getting the children of @id if it is a placeholder */
+static void
+layout_fetch_placeholder (DbusmenuClient * client, gint id)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	if (!g_hash_table_contains(priv->placeholders, GINT_TO_POINTER(id))) {
+		return;
+	}
+
+	layout_fetch_queue(client, id);
+	return;
+}
+
+/* Add the page that came in @layout to the children we've
+   already got of @item, skipping any that we already have */
+static void
+layout_page_append (DbusmenuClient * client, DbusmenuMenuitem * item, GVariant * layout)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	GVariantIter children;
+	GVariant * child;
+	GVariant * childrenv = g_variant_get_child_value(layout, 2);
+
 	g_variant_iter_init(&children, childrenv);
-
-	child = g_variant_iter_next_value(&children);
-	GList * childmis = dbusmenu_menuitem_get_children(item);
-	while (child != NULL && childmis != NULL) {
+	while ((child = g_variant_iter_next_value(&children)) != NULL) {
 		if (g_variant_is_of_type(child, G_VARIANT_TYPE_VARIANT)) {
 			GVariant * tmp = g_variant_get_variant(child);
 			g_variant_unref(child);
 			child = tmp;
 		}
 
-		GVariant * xmlidv = g_variant_get_child_value(child, 0);
-		gint xmlid = g_variant_get_int32(xmlidv);
-		g_variant_unref(xmlidv);
-		/* If this isn't a valid menu item we need to move on
-		   until we have one.  This avoids things like comments. */
-		if (xmlid < 0) {
+		GVariant * childidv = g_variant_get_child_value(child, 0);
+		gint childid = g_variant_get_int32(childidv);
+		g_variant_unref(childidv);
+
+		if (childid < 0 || lookup_menuitem_by_id(client, childid) != NULL) {
 			g_variant_unref(child);
-			child = g_variant_iter_next_value(&children);
 			continue;
 		}
 
 		#ifdef MASSIVEDEBUGGING
-		gint miid = dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(childmis->data));
-		g_debug("Recursing parse_layout_xml.  XML ID: %d  MI ID: %d", xmlid, miid);
+		g_debug("Appending menu item %d from a page to %d", childid, dbusmenu_menuitem_get_id(item));
 		#endif
-		
-		parse_layout_xml(client, child, DBUSMENU_MENUITEM(childmis->data), item, proxy);
+		DbusmenuMenuitem * newitem = parse_layout_new_child(childid, client, item);
+		dbusmenu_menuitem_child_append(item, newitem);
+		g_object_unref(newitem);
+
+		parse_layout_props(newitem, child);
+		layout_placeholder_set(client, newitem,
+			g_strcmp0(dbusmenu_menuitem_property_get(newitem, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY), DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU) == 0);
+
+		if (priv->layout_realize) {
+			menuitem_realize(client, newitem, item);
+		}
 
 		g_variant_unref(child);
-		child = g_variant_iter_next_value(&children);
-		childmis = g_list_next(childmis);
 	}
 
 	g_variant_unref(childrenv);
+	return;
+}
+
+/* A page of children came back from the server, the first
+   one is reconciled like any layout, the ones after it are
+   added to the end */
+static void
+layout_page_cb (GObject * proxy, GAsyncResult * res, gpointer data)
+{
+	DbusmenuClient * client = DBUSMENU_CLIENT(data);
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	GError * error = NULL;
+	GVariant * params = NULL;
+	GVariant * layout = NULL;
+
+	params = g_dbus_proxy_call_finish(G_DBUS_PROXY(proxy), res, &error);
 
-	if (child != NULL) {
-		g_warning("Sync failed, now we've got extra layout nodes.");
+	if (priv->layoutcall != NULL) {
+		g_object_unref(priv->layoutcall);
+		priv->layoutcall = NULL;
 	}
-	if (childmis != NULL) {
-		g_warning("Sync failed, now we've got extra menu items.");
+
+	if (error != NULL) {
+		g_warning("Getting a page of children failed: %s", error->message);
+		gboolean retry = !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+		g_error_free(error);
+		/* The submenu may have been removed on the server before
+		   we asked for it, fall back to getting everything. */
+		if (retry) {
+			update_layout(client);
+		}
+		goto out;
 	}
 
-	return item;
-}
+	guint rev, total;
+	g_variant_get(params, "(uu@(ia{sv}av))", &rev, &total, &layout);
 
-/* Take the layout passed to us over DBus and turn it into
-   a set of beautiful objects */
-static gint
-parse_layout (DbusmenuClient * client, GVariant * layout)
-{
-	#ifdef MASSIVEDEBUGGING
-	g_debug("Client Parsing a new layout");
-	#endif 
+	priv->layout_calls++;
+	priv->layout_bytes += g_variant_get_size(params);
 
-	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	DbusmenuMenuitem * item = lookup_menuitem_by_id(client, priv->layoutcall_parent);
+	gpointer key = GINT_TO_POINTER(priv->layoutcall_parent);
+	gpointer firstrev = NULL;
 
-	DbusmenuMenuitem * oldroot = priv->root;
+	/* The server changed between the first page and this one, so
+	   this one may not start where the ones we've got end.  Get
+	   them all again from the start. */
+	if (item != NULL && priv->layoutcall_offset > 0
+			&& g_hash_table_lookup_extended(priv->page_revisions, key, NULL, &firstrev)
+			&& GPOINTER_TO_UINT(firstrev) != rev) {
+		GVariant * children = g_variant_get_child_value(layout, 2);
+		guint count = _dbusmenu_menuitem_get_n_children(item) + g_variant_n_children(children);
+		g_variant_unref(children);
 
-	if (priv->root == NULL) {
-		priv->root = parse_layout_new_child(0, client, NULL);
-	} else {
-		parse_layout_update(priv->root, client);
+		g_debug("Children of %d changed from revision %d to %d between pages, getting them again.", priv->layoutcall_parent, GPOINTER_TO_UINT(firstrev), rev);
+		layout_fetch_page(client, priv->layoutcall_parent, 0, count);
+		goto out;
 	}
 
-	priv->root = parse_layout_xml(client, layout, priv->root, NULL, priv->menuproxy);
+	if (item != NULL) {
+		gint64 start = g_get_monotonic_time();
 
-	if (priv->root == NULL) {
-		g_warning("Unable to parse layout on client %s object %s: %s", priv->dbus_name, priv->dbus_object, g_variant_print(layout, TRUE));
-	}
+		if (priv->layoutcall_offset == 0) {
+			g_hash_table_insert(priv->page_revisions, key, GUINT_TO_POINTER(rev));
+			priv->page_parsing = TRUE;
+			parse_layout_xml(client, layout, item, dbusmenu_menuitem_get_parent(item), priv->menuproxy, 1);
+			priv->page_parsing = FALSE;
+		} else {
+			layout_page_append(client, item, layout);
+		}
+
+		priv->reconcile_time += g_get_monotonic_time() - start;
+
+		get_properties_flush(client);
+		layout_more_set(client, item, total);
+
+		priv->my_revision = MAX(priv->my_revision, priv->layoutcall_revision);
+		layout_cache_dirty(client, TRUE);
 
-	if (priv->root != oldroot) {
 		#ifdef MASSIVEDEBUGGING
-		g_debug("Client signaling root changed.");
-		#endif 
+		g_debug("Client signaling layout has changed.");
+		#endif
+		g_signal_emit(G_OBJECT(client), signals[LAYOUT_UPDATED], 0, TRUE);
+	}
 
-		/* If they are different, and there was an old root we must
-		   clean up that old root */
-		if (oldroot != NULL) {
-			dbusmenu_menuitem_set_root(oldroot, FALSE);
-			g_object_unref(oldroot);
-			oldroot = NULL;
-		}
+	if (priv->my_revision < priv->current_revision) {
+		update_layout(client);
+	}
 
-		/* If the root changed we can signal that */
-		g_signal_emit(G_OBJECT(client), signals[ROOT_CHANGED], 0, priv->root, TRUE);
+	layout_fetch_next(client);
+
+out:
+	if (layout != NULL) {
+		g_variant_unref(layout);
 	}
 
-	return 1;
+	if (params != NULL) {
+		g_variant_unref(params);
+	}
+
+	g_object_unref(G_OBJECT(client));
+	return;
 }
 
-/* When the layout property returns, here's where we take care of that. */
+/* Ask for the children of @id from @offset on, @count of them
+   at the most */
 static void
-update_layout_cb (GObject * proxy, GAsyncResult * res, gpointer data)
+layout_fetch_page (DbusmenuClient * client, gint id, guint offset, guint count)
 {
-	DbusmenuClient * client = DBUSMENU_CLIENT(data);
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
 
-	GError * error = NULL;
-	GVariant * params = NULL;
-	GVariant * layout = NULL;
+	if (priv->menuproxy == NULL || priv->layoutcall != NULL) {
+		return;
+	}
 
-	params = g_dbus_proxy_call_finish(G_DBUS_PROXY(proxy), res, &error);
+	priv->layoutcall = g_cancellable_new();
+	priv->layoutcall_parent = id;
+	priv->layoutcall_revision = priv->current_revision;
+	priv->layoutcall_offset = offset;
+	priv->layoutcall_all = FALSE;
 
-	if (error != NULL) {
-		g_warning("Getting layout failed: %s", error->message);
-		g_error_free(error);
-		goto out;
+	g_object_ref(G_OBJECT(client));
+	g_dbus_proxy_call(priv->menuproxy,
+	                  "GetLayoutPage",
+	                  g_variant_new("(iuu@as)", id, offset, count, priv->layout_props),
+	                  G_DBUS_CALL_FLAGS_NONE,
+	                  -1,   /* timeout */
+	                  priv->layoutcall, /* cancellable */
+	                  layout_page_cb,
+	                  client);
+
+	return;
+}
+
+/* Where the tree for our name and object gets cached, NULL if
+   it can't be as unique names are different every time */
+static gchar *
+layout_cache_path (DbusmenuClient * client)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	if (priv->dbus_name == NULL || priv->dbus_object == NULL || priv->dbus_name[0] == ':') {
+		return NULL;
 	}
 
-	GVariant * revv = g_variant_get_child_value(params, 0);
-	guint rev = g_variant_get_uint32(revv);
-	g_variant_unref(revv);
+	/* Names can't have a slash and objects start with one */
+	gchar * key = g_strconcat(priv->dbus_name, priv->dbus_object, NULL);
+	gchar * sum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, key, -1);
+	gchar * file = g_strconcat(sum, ".gvariant", NULL);
+	gchar * path = g_build_filename(g_get_user_cache_dir(), "libdbusmenu", "layouts", file, NULL);
 
-	layout = g_variant_get_child_value(params, 1);
+	g_free(file);
+	g_free(sum);
+	g_free(key);
+
+	return path;
+}
 
-	guint parseable = parse_layout(client, layout);
+/* Turn an item and everything under it back into a layout, with
+   all of the properties we have instead of just the layout ones */
+static GVariant *
+layout_cache_tree (DbusmenuMenuitem * item)
+{
+	GVariantBuilder children;
+	GList * child;
 
-	if (parseable == 0) {
-		g_warning("Unable to parse layout!");
-		goto out;
+	g_variant_builder_init(&children, G_VARIANT_TYPE("av"));
+	for (child = dbusmenu_menuitem_get_children(item); child != NULL; child = g_list_next(child)) {
+		g_variant_builder_add_value(&children, g_variant_new_variant(layout_cache_tree(DBUSMENU_MENUITEM(child->data))));
 	}
 
-	priv->my_revision = rev;
-	/* g_debug("Root is now: 0x%X", (unsigned int)priv->root); */
-	#ifdef MASSIVEDEBUGGING
-	g_debug("Client signaling layout has changed.");
-	#endif 
-	g_signal_emit(G_OBJECT(client), signals[LAYOUT_UPDATED], 0, TRUE);
+	GVariant * props = dbusmenu_menuitem_properties_variant(item, NULL);
+	if (props == NULL) {
+		props = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
+	}
 
-	/* Check to see if we got another update in the time this
-	   one was issued. */
-	if (priv->my_revision < priv->current_revision) {
-		update_layout(client);
+	GVariant * tree = g_variant_new("(i@a{sv}@av)", dbusmenu_menuitem_get_id(item), props, g_variant_builder_end(&children));
+	g_variant_unref(props);
+
+	return tree;
+}
+
+/* Write out the tree we've got for the next client of this
+   menu to start with */
+static void
+layout_cache_save (DbusmenuClient * client)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	if (priv->root == NULL) {
+		return;
 	}
 
-out:
-	if (priv->layoutcall != NULL) {
-		g_object_unref(priv->layoutcall);
-		priv->layoutcall = NULL;
+	gchar * path = layout_cache_path(client);
+	if (path == NULL) {
+		return;
 	}
 
-	if (layout != NULL) {
-		g_variant_unref(layout);
+	GVariant * cache = g_variant_ref_sink(g_variant_new("(usss@(ia{sv}av))",
+	                                                    LAYOUT_CACHE_VERSION,
+	                                                    priv->dbus_name,
+	                                                    priv->dbus_object,
+	                                                    priv->layout_hash != NULL ? priv->layout_hash : "",
+	                                                    layout_cache_tree(priv->root)));
+
+	gchar * dir = g_path_get_dirname(path);
+	GError * error = NULL;
+
+	if (g_mkdir_with_parents(dir, 0700) != 0) {
+		g_warning("Unable to create layout cache directory '%s'", dir);
+	} else if (!g_file_set_contents(path, g_variant_get_data(cache), g_variant_get_size(cache), &error)) {
+		g_warning("Unable to cache layout in '%s': %s", path, error->message);
+		g_error_free(error);
 	}
 
-	if (params != NULL) {
-		g_variant_unref(params);
+	g_free(dir);
+	g_free(path);
+	g_variant_unref(cache);
+
+	return;
+}
+
+static gboolean
+layout_cache_save_cb (gpointer user_data)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(user_data);
+	priv->cache_save = 0;
+	layout_cache_save(DBUSMENU_CLIENT(user_data));
+	return FALSE;
+}
+
+/* The tree changed so it needs saving soon.  If it changed in a
+   way other than getting the full layout, or the properties of the
+   items that were new in it, we can't say which layout it matches
+   anymore. */
+static void
+layout_cache_dirty (DbusmenuClient * client, gboolean structure)
+{
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	if (!priv->layout_cache) {
+		return;
+	}
+
+	if (structure) {
+		g_free(priv->layout_hash);
+		priv->layout_hash = NULL;
+	}
+
+	if (priv->cache_save == 0) {
+		priv->cache_save = g_timeout_add_seconds(LAYOUT_CACHE_SAVE_DELAY, layout_cache_save_cb, client);
 	}
 
-	g_object_unref(G_OBJECT(client));
 	return;
 }
 
-/* Call the property on the server we're connected to and set it up to
-   be async back to _update_layout_cb */
+/* Show the tree from the last time we saw this menu while we wait
+   for the server, it gets reconciled when the layout comes in */
 static void
-update_layout (DbusmenuClient * client)
+layout_cache_load (DbusmenuClient * client)
 {
 	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
-	g_return_if_fail(priv->layout_props != NULL);
 
-	if (priv->menuproxy == NULL) {
+	if (priv->root != NULL) {
 		return;
 	}
 
-	gchar * name_owner = g_dbus_proxy_get_name_owner(priv->menuproxy);
-	if (name_owner == NULL) {
+	gchar * path = layout_cache_path(client);
+	if (path == NULL) {
 		return;
 	}
-	g_free(name_owner);
 
-	if (priv->layoutcall != NULL) {
+	/* Not being there is fine, it's our first time */
+	GMappedFile * mapped = g_mapped_file_new(path, FALSE, NULL);
+	g_free(path);
+	if (mapped == NULL) {
 		return;
 	}
 
-	priv->layoutcall = g_cancellable_new();
+	GVariant * cache = g_variant_ref_sink(g_variant_new_from_data(G_VARIANT_TYPE(LAYOUT_CACHE_TYPE),
+	                                                              g_mapped_file_get_contents(mapped),
+	                                                              g_mapped_file_get_length(mapped),
+	                                                              FALSE,
+	                                                              (GDestroyNotify)g_mapped_file_unref,
+	                                                              mapped));
 
-	GVariantBuilder tupleb;
-	g_variant_builder_init(&tupleb, G_VARIANT_TYPE_TUPLE);
-	
-	g_variant_builder_add_value(&tupleb, g_variant_new_int32(0)); // root
-	g_variant_builder_add_value(&tupleb, g_variant_new_int32(-1)); // recurse
-	g_variant_builder_add_value(&tupleb, priv->layout_props); // props
+	guint version;
+	const gchar * name;
+	const gchar * object;
+	const gchar * hash;
+	GVariant * tree;
 
-	GVariant * args = g_variant_builder_end(&tupleb);
-	// g_debug("Args (type: %s): %s", g_variant_get_type_string(args), g_variant_print(args, TRUE));
+	g_variant_get(cache, "(u&s&s&s@(ia{sv}av))", &version, &name, &object, &hash, &tree);
 
-	g_object_ref(G_OBJECT(client));
-	g_dbus_proxy_call(priv->menuproxy,
-	                  "GetLayout",
-	                  args,
-	                  G_DBUS_CALL_FLAGS_NONE,
-	                  -1,   /* timeout */
-	                  priv->layoutcall, /* cancellable */
-	                  update_layout_cb,
-	                  client);
+	if (version == LAYOUT_CACHE_VERSION && g_strcmp0(name, priv->dbus_name) == 0 && g_strcmp0(object, priv->dbus_object) == 0) {
+		/* Everything we need is in the cache, so realize the
+		   items without asking anyone */
+		gboolean realize = priv->layout_realize;
+		priv->layout_realize = TRUE;
+		parse_layout(client, tree, -1);
+		priv->layout_realize = realize;
+
+		if (hash[0] != '\0') {
+			priv->cache_hash = g_strdup(hash);
+		}
+
+		g_signal_emit(G_OBJECT(client), signals[LAYOUT_UPDATED], 0, TRUE);
+	}
+
+	g_variant_unref(tree);
+	g_variant_unref(cache);
 
 	return;
 }
@@ -2517,6 +3733,106 @@ dbusmenu_client_get_root (DbusmenuClient * client)
 	return priv->root;
 }
 
+/**
+ * dbusmenu_client_is_placeholder:
+ * @client: The #DbusmenuClient that @item came from
+ * @item: A #DbusmenuMenuitem from @client
+ *
+ * Checks whether @item is a submenu whose children haven't been
+ * fetched yet because of #DbusmenuClient:layout-depth.  They get
+ * fetched when #dbusmenu_menuitem_send_about_to_show is called on
+ * @item, and #DbusmenuClient::placeholder-changed is signaled when
+ * they're in.
+ *
+ * Return value: Whether @item is a placeholder
+ */
+gboolean
+dbusmenu_client_is_placeholder (DbusmenuClient * client, DbusmenuMenuitem * item)
+{
+	g_return_val_if_fail(DBUSMENU_IS_CLIENT(client), FALSE);
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(item), FALSE);
+
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gint id = dbusmenu_menuitem_get_id(item);
+
+	return g_hash_table_contains(priv->placeholders, GINT_TO_POINTER(id)) && lookup_menuitem_by_id(client, id) == item;
+}
+
+/**
+ * dbusmenu_client_has_more_children:
+ * @client: The #DbusmenuClient that @item came from
+ * @item: A #DbusmenuMenuitem from @client
+ *
+ * Checks whether only some pages of the children of @item have
+ * been fetched because of #DbusmenuClient:page-size.  The rest
+ * come with #dbusmenu_client_fetch_more_children, and
+ * #DbusmenuClient::more-children-changed is signaled when they're
+ * all in.
+ *
+ * Return value: Whether @item has children still to fetch
+ */
+gboolean
+dbusmenu_client_has_more_children (DbusmenuClient * client, DbusmenuMenuitem * item)
+{
+	g_return_val_if_fail(DBUSMENU_IS_CLIENT(client), FALSE);
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(item), FALSE);
+
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+	gint id = dbusmenu_menuitem_get_id(item);
+
+	return g_hash_table_contains(priv->pages, GINT_TO_POINTER(id)) && lookup_menuitem_by_id(client, id) == item;
+}
+
+/**
+ * dbusmenu_client_get_children_total:
+ * @client: The #DbusmenuClient that @item came from
+ * @item: A #DbusmenuMenuitem from @client
+ *
+ * Gets how many children @item has on the server, including the
+ * ones that haven't been fetched yet.  Useful to size a scrollbar
+ * before all of them are in.
+ *
+ * Return value: The number of children of @item
+ */
+guint
+dbusmenu_client_get_children_total (DbusmenuClient * client, DbusmenuMenuitem * item)
+{
+	g_return_val_if_fail(DBUSMENU_IS_CLIENT(client), 0);
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(item), 0);
+
+	if (dbusmenu_client_has_more_children(client, item)) {
+		DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+		return GPOINTER_TO_UINT(g_hash_table_lookup(priv->pages, GINT_TO_POINTER(dbusmenu_menuitem_get_id(item))));
+	}
+
+	return _dbusmenu_menuitem_get_n_children(item);
+}
+
+/**
+ * dbusmenu_client_fetch_more_children:
+ * @client: The #DbusmenuClient that @item came from
+ * @item: A #DbusmenuMenuitem from @client
+ *
+ * Asks the server for the next page of the children of @item
+ * when #dbusmenu_client_has_more_children says there are more
+ * of them, usually as the user scrolls towards the end of the
+ * ones that are there.  They're added to the end of the children
+ * of @item and #DbusmenuClient::layout-updated is signaled.
+ */
+void
+dbusmenu_client_fetch_more_children (DbusmenuClient * client, DbusmenuMenuitem * item)
+{
+	g_return_if_fail(DBUSMENU_IS_CLIENT(client));
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(item));
+
+	if (!dbusmenu_client_has_more_children(client, item)) {
+		return;
+	}
+
+	layout_fetch_queue(client, dbusmenu_menuitem_get_id(item));
+	return;
+}
+
 /* Remove the type handler when we're all done with it */
 static void
 type_handler_destroy (gpointer user_data)
@@ -2672,3 +3988,47 @@ dbusmenu_client_get_icon_paths (DbusmenuClient * client)
 	return priv->icon_dirs;
 }
 
+/**
+ * dbusmenu_client_get_stats:
+ * @client: The #DbusmenuClient to get the counters of
+ * 
+ * Gets counters about the menu the client has built and what it
+ * took to get it, to see why it might be slow.  The dictionary
+ * uses the same names as dbusmenu_server_get_stats() for the
+ * items, the layout calls and the property signals that were
+ * received, and adds "reconcile-usec" for the time spent turning
+ * layouts into menu items.
+ * 
+ * Return value: (transfer full): A #GVariant of type "a{sv}"
+ */
+GVariant *
+dbusmenu_client_get_stats (DbusmenuClient * client)
+{
+	g_return_val_if_fail(DBUSMENU_IS_CLIENT(client), NULL);
+	DbusmenuClientPrivate * priv = DBUSMENU_CLIENT_GET_PRIVATE(client);
+
+	guint items = 0;
+	guint properties = 0;
+	guint64 bytes = 0;
+
+	if (priv->root != NULL) {
+		_dbusmenu_menuitem_tree_stats(priv->root, &items, &properties, &bytes);
+	}
+
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+	g_variant_builder_add(&builder, "{sv}", "items", g_variant_new_uint32(items));
+	g_variant_builder_add(&builder, "{sv}", "properties", g_variant_new_uint32(properties));
+	g_variant_builder_add(&builder, "{sv}", "property-bytes", g_variant_new_uint64(bytes));
+	g_variant_builder_add(&builder, "{sv}", "layout-revision", g_variant_new_uint32(priv->my_revision));
+	g_variant_builder_add(&builder, "{sv}", "layout-calls", g_variant_new_uint32(priv->layout_calls));
+	g_variant_builder_add(&builder, "{sv}", "layout-bytes", g_variant_new_uint64(priv->layout_bytes));
+	g_variant_builder_add(&builder, "{sv}", "group-property-calls", g_variant_new_uint32(priv->group_calls));
+	g_variant_builder_add(&builder, "{sv}", "property-signals", g_variant_new_uint32(priv->property_signals));
+	g_variant_builder_add(&builder, "{sv}", "property-entries", g_variant_new_uint32(priv->property_entries));
+	g_variant_builder_add(&builder, "{sv}", "reconcile-usec", g_variant_new_uint64(priv->reconcile_time));
+
+	return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
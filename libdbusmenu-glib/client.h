@@ -80,6 +80,18 @@ G_BEGIN_DECLS
  * String to attach to signal #DbusmenuClient::icon-theme-dirs-changed
  */
 #define DBUSMENU_CLIENT_SIGNAL_ICON_THEME_DIRS_CHANGED    "icon-theme-dirs-changed"
+/**
+ * DBUSMENU_CLIENT_SIGNAL_PLACEHOLDER_CHANGED:
+ *
+ * String to attach to signal #DbusmenuClient::placeholder-changed
+ */
+#define DBUSMENU_CLIENT_SIGNAL_PLACEHOLDER_CHANGED    "placeholder-changed"
+/**
+ * DBUSMENU_CLIENT_SIGNAL_MORE_CHILDREN_CHANGED:
+ *
+ * String to attach to signal #DbusmenuClient::more-children-changed
+ */
+#define DBUSMENU_CLIENT_SIGNAL_MORE_CHILDREN_CHANGED    "more-children-changed"
 
 /**
  * DBUSMENU_CLIENT_PROP_DBUS_NAME:
@@ -111,6 +123,30 @@ G_BEGIN_DECLS
  * String to access property #DbusmenuClient:group-events
  */
 #define DBUSMENU_CLIENT_PROP_GROUP_EVENTS "group-events"
+/**
+ * DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES:
+ *
+ * String to access property #DbusmenuClient:layout-properties
+ */
+#define DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES "layout-properties"
+/**
+ * DBUSMENU_CLIENT_PROP_LAYOUT_CACHE:
+ *
+ * String to access property #DbusmenuClient:layout-cache
+ */
+#define DBUSMENU_CLIENT_PROP_LAYOUT_CACHE "layout-cache"
+/**
+ * DBUSMENU_CLIENT_PROP_LAYOUT_DEPTH:
+ *
+ * String to access property #DbusmenuClient:layout-depth
+ */
+#define DBUSMENU_CLIENT_PROP_LAYOUT_DEPTH "layout-depth"
+/**
+ * DBUSMENU_CLIENT_PROP_PAGE_SIZE:
+ *
+ * String to access property #DbusmenuClient:page-size
+ */
+#define DBUSMENU_CLIENT_PROP_PAGE_SIZE "page-size"
 
 /**
  * DBUSMENU_CLIENT_TYPES_DEFAULT:
@@ -146,8 +182,8 @@ typedef struct _DbusmenuClientPrivate DbusmenuClientPrivate;
 	@item_activate: Slot for #DbusmenuClient::item-activate.
 	@event_result: Slot for #DbusmenuClient::event-error.
 	@icon_theme_dirs: Slot for #DbusmenuClient::icon-theme-dirs-changed.
-	@reserved1: Reserved for future use.
-	@reserved2: Reserved for future use.
+	@placeholder_changed: Slot for #DbusmenuClient::placeholder-changed.
+	@more_children_changed: Slot for #DbusmenuClient::more-children-changed.
 	@reserved3: Reserved for future use.
 	@reserved4: Reserved for future use.
 	@reserved5: Reserved for future use.
@@ -166,10 +202,10 @@ struct _DbusmenuClientClass {
 	void (*item_activate) (DbusmenuMenuitem * item, guint timestamp);
 	void (*event_result) (DbusmenuMenuitem * item, gchar * event, GVariant * data, guint timestamp, GError * error);
 	void (*icon_theme_dirs) (DbusmenuMenuitem * item, gpointer theme_dirs, GError * error);
+	void (*placeholder_changed) (DbusmenuMenuitem * item, gboolean placeholder);
+	void (*more_children_changed) (DbusmenuMenuitem * item, gboolean more);
 
 	/*< Private >*/
-	void (*reserved1) (void);
-	void (*reserved2) (void);
 	void (*reserved3) (void);
 	void (*reserved4) (void);
 	void (*reserved5) (void);
@@ -220,6 +256,15 @@ gboolean             dbusmenu_client_add_type_handler_full (DbusmenuClient * cli
 DbusmenuTextDirection dbusmenu_client_get_text_direction (DbusmenuClient * client);
 DbusmenuStatus       dbusmenu_client_get_status        (DbusmenuClient * client);
 GStrv                dbusmenu_client_get_icon_paths    (DbusmenuClient * client);
+gboolean             dbusmenu_client_is_placeholder    (DbusmenuClient * client,
+                                                        DbusmenuMenuitem * item);
+gboolean             dbusmenu_client_has_more_children (DbusmenuClient * client,
+                                                        DbusmenuMenuitem * item);
+guint                dbusmenu_client_get_children_total (DbusmenuClient * client,
+                                                        DbusmenuMenuitem * item);
+void                 dbusmenu_client_fetch_more_children (DbusmenuClient * client,
+                                                        DbusmenuMenuitem * item);
+GVariant *           dbusmenu_client_get_stats         (DbusmenuClient * client);
 
 /**
 	SECTION:client
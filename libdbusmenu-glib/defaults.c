@@ -203,18 +203,8 @@ dbusmenu_defaults_default_set (DbusmenuDefaults * defaults, const gchar * type,
 		type = DBUSMENU_CLIENT_TYPES_DEFAULT;
 	}
 
-	GHashTable * prop_table = (GHashTable *)g_hash_table_lookup(defaults->priv->types, type);
-
-	/* We've never had a default for this type, so we need
-	   to create a table for it. */
-	if (prop_table == NULL) {
-		prop_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, entry_destroy);
-
-		g_hash_table_insert(prop_table, g_strdup(property), entry_create(prop_type, value));
-		g_hash_table_insert(defaults->priv->types, g_strdup(type), prop_table);
-	} else {
-		g_hash_table_replace(prop_table, g_strdup(property), entry_create(prop_type, value));
-	}
+	GHashTable * prop_table = dbusmenu_defaults_type_table(defaults, type);
+	g_hash_table_replace(prop_table, GUINT_TO_POINTER(g_quark_from_string(property)), entry_create(prop_type, value));
 
 	return;
 }
@@ -247,7 +237,7 @@ dbusmenu_defaults_default_get (DbusmenuDefaults * defaults, const gchar * type,
 		return NULL;
 	}
 
-	DefaultEntry * entry = (DefaultEntry *)g_hash_table_lookup(prop_table, property);
+	DefaultEntry * entry = (DefaultEntry *)g_hash_table_lookup(prop_table, GUINT_TO_POINTER(g_quark_try_string(property)));
 
 	if (entry == NULL) {
 		return NULL;
@@ -283,7 +273,7 @@ dbusmenu_defaults_default_get_type (DbusmenuDefaults * defaults, const gchar * t
 		return NULL;
 	}
 
-	DefaultEntry * entry = (DefaultEntry *)g_hash_table_lookup(prop_table, property);
+	DefaultEntry * entry = (DefaultEntry *)g_hash_table_lookup(prop_table, GUINT_TO_POINTER(g_quark_try_string(property)));
 
 	if (entry == NULL) {
 		return NULL;
@@ -292,3 +282,68 @@ dbusmenu_defaults_default_get_type (DbusmenuDefaults * defaults, const gchar * t
 	return entry->type;
 }
 
+/*
+ * dbusmenu_defaults_type_table:
+ * @defaults: The default database to use
+ * @type: (allow-none): The #DbusmenuMenuitem type to get the defaults for, if #NULL will default to #DBUSMENU_CLIENT_TYPE_DEFAULT
+ *
+ * Gets the table of defaults for @type so that menu items can hold
+ * on to it instead of finding it for every property.  An empty one
+ * is made if @type doesn't have any defaults yet, so the table stays
+ * the same when some are set later.
+ *
+ * Return value: (transfer none): The defaults for @type, which live
+ * as long as @defaults.
+ */
+GHashTable *
+dbusmenu_defaults_type_table (DbusmenuDefaults * defaults, const gchar * type)
+{
+	g_return_val_if_fail(DBUSMENU_IS_DEFAULTS(defaults), NULL);
+
+	if (type == NULL) {
+		type = DBUSMENU_CLIENT_TYPES_DEFAULT;
+	}
+
+	GHashTable * prop_table = (GHashTable *)g_hash_table_lookup(defaults->priv->types, type);
+
+	/* We've never had a default for this type, so we need
+	   to create a table for it. */
+	if (prop_table == NULL) {
+		prop_table = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, entry_destroy);
+		g_hash_table_insert(defaults->priv->types, g_strdup(type), prop_table);
+	}
+
+	return prop_table;
+}
+
+/*
+ * dbusmenu_defaults_table_lookup:
+ * @table: A table from dbusmenu_defaults_type_table()
+ * @property: The property name as a quark
+ * @value: (out) (allow-none): Where to put the default value
+ * @prop_type: (out) (allow-none): Where to put the type of the property
+ *
+ * Gets both the default value and the type of @property in one
+ * lookup.  Either of them can be #NULL when there's an entry.
+ *
+ * Return value: Whether there's an entry for @property
+ */
+gboolean
+dbusmenu_defaults_table_lookup (GHashTable * table, GQuark property, GVariant ** value, GVariantType ** prop_type)
+{
+	DefaultEntry * entry = NULL;
+
+	if (table != NULL && property != 0) {
+		entry = (DefaultEntry *)g_hash_table_lookup(table, GUINT_TO_POINTER(property));
+	}
+
+	if (value != NULL) {
+		*value = entry != NULL ? entry->value : NULL;
+	}
+
+	if (prop_type != NULL) {
+		*prop_type = entry != NULL ? entry->type : NULL;
+	}
+
+	return entry != NULL;
+}
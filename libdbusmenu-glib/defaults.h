@@ -80,6 +80,12 @@ GVariant *            dbusmenu_defaults_default_get          (DbusmenuDefaults *
 GVariantType *        dbusmenu_defaults_default_get_type     (DbusmenuDefaults * defaults,
                                                               const gchar * type,
                                                               const gchar * property);
+GHashTable *          dbusmenu_defaults_type_table           (DbusmenuDefaults * defaults,
+                                                              const gchar * type);
+gboolean              dbusmenu_defaults_table_lookup         (GHashTable * table,
+                                                              GQuark property,
+                                                              GVariant ** value,
+                                                              GVariantType ** prop_type);
 
 G_END_DECLS
 
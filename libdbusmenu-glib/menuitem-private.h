@@ -33,6 +33,49 @@ License version 3 and version 2.1 along with this program.  If not, see
 
 G_BEGIN_DECLS
 
+/* The operations that can be in a LayoutEdits signal */
+typedef enum {
+	DBUSMENU_LAYOUT_EDIT_INSERT = 0,
+	DBUSMENU_LAYOUT_EDIT_REMOVE = 1,
+	DBUSMENU_LAYOUT_EDIT_MOVE = 2
+} DbusmenuLayoutEdit;
+
+/* Constant empty values that get sent over the bus a lot */
+typedef enum {
+	DBUSMENU_EMPTY_PROPERTIES,        /* a{sv} */
+	DBUSMENU_EMPTY_CHILDREN,          /* av */
+	DBUSMENU_EMPTY_ITEM_PROPERTIES,   /* a(ia{sv}) */
+	DBUSMENU_EMPTY_ITEM_REMOVALS,     /* a(ias) */
+	DBUSMENU_EMPTY_LAYOUT,            /* (ia{sv}av) of (0, {}, []) */
+	DBUSMENU_EMPTY_GROUP_PROPERTIES,  /* (a(ia{sv})) of ([(0, {})],) */
+	DBUSMENU_EMPTY_COUNT
+} DbusmenuEmptyVariant;
+
+/* Adds the layout of children that aren't menuitems to @children,
+   an "av", when the layout of @mi gets built */
+typedef void (*DbusmenuMenuitemBuildChildren) (DbusmenuMenuitem * mi, GVariantBuilder * children, const gchar ** properties, gpointer user_data);
+
+/* Gets told about the changes anywhere in a tree of menu items
+   without having to connect to the signals of each of them.  They
+   are added on the top of the tree and the items below find them
+   by looking up through their parents. */
+typedef struct _DbusmenuMenuitemObserver DbusmenuMenuitemObserver;
+struct _DbusmenuMenuitemObserver {
+	void (*property_changed) (DbusmenuMenuitem * mi, const gchar * property, GVariant * value, gpointer user_data);
+	void (*child_added) (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint position, gpointer user_data);
+	void (*child_removed) (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, gpointer user_data);
+	void (*child_moved) (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint newpos, guint oldpos, gpointer user_data);
+	void (*show_to_user) (DbusmenuMenuitem * mi, guint timestamp, gpointer user_data);
+};
+
+GVariant * _dbusmenu_empty_variant (DbusmenuEmptyVariant which);
+void _dbusmenu_menuitem_set_build_children (DbusmenuMenuitem * mi, DbusmenuMenuitemBuildChildren func, gpointer user_data);
+gboolean _dbusmenu_menuitem_property_set_unchecked (DbusmenuMenuitem * mi, const gchar * property, GVariant * value);
+void _dbusmenu_menuitem_add_observer (DbusmenuMenuitem * mi, const DbusmenuMenuitemObserver * observer, gpointer user_data);
+void _dbusmenu_menuitem_remove_observer (DbusmenuMenuitem * mi, const DbusmenuMenuitemObserver * observer, gpointer user_data);
+guint _dbusmenu_menuitem_get_n_children (DbusmenuMenuitem * mi);
+GList * _dbusmenu_menuitem_get_child_link (DbusmenuMenuitem * mi, guint position);
+void _dbusmenu_menuitem_tree_stats (DbusmenuMenuitem * mi, guint * items, guint * properties, guint64 * bytes);
 GVariant * dbusmenu_menuitem_build_variant (DbusmenuMenuitem * mi, const gchar ** properties, gint recurse);
 gboolean dbusmenu_menuitem_realized (DbusmenuMenuitem * mi);
 void dbusmenu_menuitem_set_realized (DbusmenuMenuitem * mi);
@@ -27,6 +27,8 @@ License version 3 and version 2.1 along with this program.  If not, see
 */
 
 #include <stdlib.h>
+#include <string.h>
+#include <gio/gio.h>
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -35,18 +37,61 @@ License version 3 and version 2.1 along with this program.  If not, see
 #include "menuitem-private.h"
 #include "defaults.h"
 
+/* Version of the snapshot files, bump it whenever SNAPSHOT_TYPE changes */
+#define SNAPSHOT_VERSION  1
+#define SNAPSHOT_TYPE     "(u(ia{sv}av))"
+
+/* Items with more properties than this index them with a hash
+   table instead of searching through the array */
+#define PROPS_ARRAY_MAX   16
+
 #ifdef MASSIVEDEBUGGING
 #define LABEL(x)  dbusmenu_menuitem_property_get(DBUSMENU_MENUITEM(x), DBUSMENU_MENUITEM_PROP_LABEL)
 #define ID(x)     dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(x))
 #endif
 
+/* A property, the name is a quark so that all the items
+   with it share one copy.  Quarks are never freed, so a name
+   that hasn't been interned already isn't made into one, a server
+   could send us as many of those as it likes.  Those get a @key
+   of zero and their own copy of the name in @name instead. */
+typedef struct _prop_t prop_t;
+struct _prop_t {
+	GQuark key;
+	gchar * name;
+	GVariant * value;
+};
+
+/* An observer added to an item and the data it gets called with */
+typedef struct _observer_t observer_t;
+struct _observer_t {
+	const DbusmenuMenuitemObserver * observer;
+	gpointer user_data;
+};
+
 /* Private */
 /**
 	DbusmenuMenuitemPrivate:
 	@id: The ID of this menu item
 	@children: A list of #DbusmenuMenuitem objects that are
 	      children to this one.
-	@properties: All of the properties on this menu item.
+	@child_links: The links of @children in order, so that they
+	      can be found by position.
+	@positions_valid: How many of the children at the start of
+	      @child_links have their position right.
+	@realized_tree: Counts of the realized children as a Fenwick
+	      tree over @child_links, for the realized positions.
+	@realized_valid: Whether @realized_tree is up to date.
+	@position: Where this item is in the children of @parent,
+	      might be out of date.
+	@observers: The observer_t's that get told about the changes in
+	      the tree below this item, usually only set on the root.
+	@props: The properties on this menu item, in the order they
+	      were first set, see prop_t for how they're named.
+	@nprops: How many properties are in @props
+	@props_size: How many properties @props has room for
+	@props_index: Where each property is in @props, plus one,
+	      once there are too many of them to search through.
 	@root: Whether this node is the root node
 
 	These are the little secrets that we don't want getting
@@ -57,10 +102,21 @@ struct _DbusmenuMenuitemPrivate
 {
 	gint id;
 	GList * children;
-	GHashTable * properties;
+	GArray * child_links;
+	guint positions_valid;
+	guint * realized_tree;
+	gboolean realized_valid;
+	guint position;
+	GSList * observers;
+	prop_t * props;
+	guint nprops;
+	guint props_size;
+	GHashTable * props_index;
+	GVariant * properties_variant; /* Serialized copy of properties, built on demand */
 	gboolean root;
 	gboolean realized;
 	DbusmenuDefaults * defaults;
+	GHashTable * defaults_table; /* The defaults for our type, NULL until needed */
 	gboolean exposed;
 	DbusmenuMenuitem * parent;
 };
@@ -76,6 +132,7 @@ enum {
 	SHOW_TO_USER,
 	ABOUT_TO_SHOW,
 	EVENT,
+	PROPERTIES_CHANGED,
 	LAST_SIGNAL
 };
 
@@ -102,6 +159,12 @@ static void g_value_transform_STRING_BOOLEAN (const GValue * in, GValue * out);
 static void g_value_transform_STRING_INT (const GValue * in, GValue * out);
 static void handle_event (DbusmenuMenuitem * mi, const gchar * name, GVariant * variant, guint timestamp);
 static void send_about_to_show (DbusmenuMenuitem * mi, void (*cb) (DbusmenuMenuitem * mi, gpointer user_data), gpointer cb_data);
+static void children_clear (DbusmenuMenuitemPrivate * priv);
+
+static gboolean property_set_key (DbusmenuMenuitem * mi, GQuark key, const gchar * property, GVariant * value, GPtrArray * changed);
+static void properties_changed_emit (DbusmenuMenuitem * mi, const gchar ** names, guint nnames);
+
+static GQuark prop_type_quark = 0;
 
 /* GObject stuff */
 G_DEFINE_TYPE (DbusmenuMenuitem, dbusmenu_menuitem, G_TYPE_OBJECT);
@@ -121,6 +184,20 @@ dbusmenu_menuitem_class_init (DbusmenuMenuitemClass *klass)
 	klass->handle_event = handle_event;
 	klass->send_about_to_show = send_about_to_show;
 
+	/* Intern the well known names without copying them */
+	prop_type_quark = g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_TYPE);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_VISIBLE);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_ENABLED);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_LABEL);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_ICON_NAME);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_ICON_DATA);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_ACCESSIBLE_DESC);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_TOGGLE_TYPE);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_TOGGLE_STATE);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_SHORTCUT);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY);
+	g_quark_from_static_string(DBUSMENU_MENUITEM_PROP_DISPOSITION);
+
 	/**
 		DbusmenuMenuitem::property-changed:
 		@arg0: The #DbusmenuMenuitem object.
@@ -266,6 +343,26 @@ dbusmenu_menuitem_class_init (DbusmenuMenuitemClass *klass)
 	                                          g_signal_accumulator_true_handled, NULL,
 	                                          _dbusmenu_menuitem_marshal_BOOLEAN__STRING_VARIANT_UINT,
 	                                          G_TYPE_BOOLEAN, 3, G_TYPE_STRING, G_TYPE_VARIANT, G_TYPE_UINT);
+	/**
+		DbusmenuMenuitem::properties-changed:
+		@arg0: The #DbusmenuMenuitem object.
+		@arg1: (array zero-terminated=1): The names of the properties that changed
+
+		Emitted once after one or more properties have changed,
+		after all of their #DbusmenuMenuitem::property-changed
+		signals.  When they were set with
+		#dbusmenu_menuitem_properties_set_many there is only one
+		of these for all of them, so it's the one to use for work
+		that should only be done once per update.  The new values
+		can be read with #dbusmenu_menuitem_property_get_variant.
+	*/
+	signals[PROPERTIES_CHANGED] = g_signal_new(DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED,
+	                                           G_TYPE_FROM_CLASS(klass),
+	                                           G_SIGNAL_RUN_LAST,
+	                                           G_STRUCT_OFFSET(DbusmenuMenuitemClass, properties_changed),
+	                                           NULL, NULL,
+	                                           _dbusmenu_menuitem_marshal_VOID__BOXED,
+	                                           G_TYPE_NONE, 1, G_TYPE_STRV | G_SIGNAL_TYPE_STATIC_SCOPE);
 
 	g_object_class_install_property (object_class, PROP_ID,
 	                                 g_param_spec_int(PROP_ID_S, "ID for the menu item",
@@ -318,8 +415,177 @@ _g_variant_unref (gpointer data)
 	return;
 }
 
-/* Initialize the values of the in the object, and build the
-   properties hash table. */
+typedef void (*props_func) (const gchar * name, GVariant * value, gpointer user_data);
+
+/* The name of @prop, whether it's interned or not */
+static inline const gchar *
+prop_name (const prop_t * prop)
+{
+	return prop->key != 0 ? g_quark_to_string(prop->key) : prop->name;
+}
+
+/* Finds where @property is in the properties, -1 if it isn't set.
+   @key is the quark for @property, or zero if it doesn't have one. */
+static gint
+props_find (DbusmenuMenuitemPrivate * priv, GQuark key, const gchar * property)
+{
+	if (priv->props_index != NULL) {
+		return GPOINTER_TO_INT(g_hash_table_lookup(priv->props_index, property)) - 1;
+	}
+
+	guint i;
+	for (i = 0; i < priv->nprops; i++) {
+		const prop_t * prop = &priv->props[i];
+
+		if (key != 0) {
+			if (prop->key == key) {
+				return i;
+			}
+		} else if (prop->key == 0 && g_strcmp0(prop->name, property) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/* Finds the value of @property, NULL if it isn't set */
+static GVariant *
+props_lookup (DbusmenuMenuitemPrivate * priv, GQuark key, const gchar * property)
+{
+	if (property == NULL) {
+		return NULL;
+	}
+
+	gint i = props_find(priv, key, property);
+	if (i < 0) {
+		return NULL;
+	}
+
+	return priv->props[i].value;
+}
+
+/* Sets @property to @value, taking the reference to @value.  The
+   value that was there before is returned for the caller to unref,
+   as it may still be needed for a moment. */
+static GVariant *
+props_replace (DbusmenuMenuitemPrivate * priv, GQuark key, const gchar * property, GVariant * value)
+{
+	gint i = props_find(priv, key, property);
+
+	if (i >= 0) {
+		GVariant * old = priv->props[i].value;
+		priv->props[i].value = value;
+		return old;
+	}
+
+	if (priv->nprops == priv->props_size) {
+		priv->props_size = priv->props_size == 0 ? 4 : priv->props_size * 2;
+		priv->props = g_renew(prop_t, priv->props, priv->props_size);
+	}
+
+	prop_t * prop = &priv->props[priv->nprops];
+	prop->key = key;
+	prop->name = key == 0 ? g_strdup(property) : NULL;
+	prop->value = value;
+	priv->nprops++;
+
+	/* The index uses the names the properties hold, so they're
+	   good for as long as the entries are */
+	if (priv->props_index != NULL) {
+		g_hash_table_insert(priv->props_index, (gpointer)prop_name(prop), GUINT_TO_POINTER(priv->nprops));
+	} else if (priv->nprops > PROPS_ARRAY_MAX) {
+		/* Too many to search through, index them all */
+		guint j;
+		priv->props_index = g_hash_table_new(g_str_hash, g_str_equal);
+		for (j = 0; j < priv->nprops; j++) {
+			g_hash_table_insert(priv->props_index, (gpointer)prop_name(&priv->props[j]), GUINT_TO_POINTER(j + 1));
+		}
+	}
+
+	return NULL;
+}
+
+/* Takes @property out and returns its value for the caller to
+   unref, or NULL if it wasn't set.  If it had its own copy of the
+   name that goes in @name for the caller to free, as the caller
+   may have gotten @property from us. */
+static GVariant *
+props_steal (DbusmenuMenuitemPrivate * priv, GQuark key, const gchar * property, gchar ** name)
+{
+	gint i = props_find(priv, key, property);
+
+	*name = NULL;
+	if (i < 0) {
+		return NULL;
+	}
+
+	GVariant * old = priv->props[i].value;
+	*name = priv->props[i].name;
+
+	if (priv->props_index != NULL) {
+		g_hash_table_remove(priv->props_index, prop_name(&priv->props[i]));
+	}
+
+	priv->nprops--;
+	memmove(&priv->props[i], &priv->props[i + 1], (priv->nprops - i) * sizeof(prop_t));
+
+	/* Everything after it moved up one */
+	if (priv->props_index != NULL) {
+		guint j;
+		for (j = i; j < priv->nprops; j++) {
+			g_hash_table_insert(priv->props_index, (gpointer)prop_name(&priv->props[j]), GUINT_TO_POINTER(j + 1));
+		}
+	}
+
+	return old;
+}
+
+/* The number of properties that are set */
+static guint
+props_count (DbusmenuMenuitemPrivate * priv)
+{
+	return priv->nprops;
+}
+
+/* Calls @func on every property that is set, in the order they
+   were first set */
+static void
+props_foreach (DbusmenuMenuitemPrivate * priv, props_func func, gpointer user_data)
+{
+	guint i;
+	for (i = 0; i < priv->nprops; i++) {
+		func(prop_name(&priv->props[i]), priv->props[i].value, user_data);
+	}
+
+	return;
+}
+
+/* Drops all of the properties */
+static void
+props_free (DbusmenuMenuitemPrivate * priv)
+{
+	guint i;
+	for (i = 0; i < priv->nprops; i++) {
+		g_variant_unref(priv->props[i].value);
+		g_free(priv->props[i].name);
+	}
+
+	if (priv->props_index != NULL) {
+		g_hash_table_destroy(priv->props_index);
+		priv->props_index = NULL;
+	}
+
+	g_free(priv->props);
+	priv->props = NULL;
+	priv->nprops = 0;
+	priv->props_size = 0;
+
+	return;
+}
+
+/* Initialize the values of the in the object, the properties
+   are allocated when the first one is set. */
 static void
 dbusmenu_menuitem_init (DbusmenuMenuitem *self)
 {
@@ -329,13 +595,24 @@ dbusmenu_menuitem_init (DbusmenuMenuitem *self)
 
 	priv->id = -1; 
 	priv->children = NULL;
-
-	priv->properties = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, _g_variant_unref);
+	priv->child_links = NULL;
+	priv->positions_valid = 0;
+	priv->realized_tree = NULL;
+	priv->realized_valid = FALSE;
+	priv->position = 0;
+	priv->observers = NULL;
+
+	priv->props = NULL;
+	priv->nprops = 0;
+	priv->props_size = 0;
+	priv->props_index = NULL;
+	priv->properties_variant = NULL;
 
 	priv->root = FALSE;
 	priv->realized = FALSE;
 
 	priv->defaults = dbusmenu_defaults_ref_default();
+	priv->defaults_table = NULL;
 	priv->exposed = FALSE;
 	
 	return;
@@ -352,10 +629,17 @@ dbusmenu_menuitem_dispose (GObject *object)
 	}
 	g_list_free(priv->children);
 	priv->children = NULL;
+	children_clear(priv);
 
 	if (priv->defaults != NULL) {
 		g_object_unref(priv->defaults);
 		priv->defaults = NULL;
+		priv->defaults_table = NULL;
+	}
+
+	while (priv->observers != NULL) {
+		observer_t * entry = (observer_t *)priv->observers->data;
+		_dbusmenu_menuitem_remove_observer(DBUSMENU_MENUITEM(object), entry->observer, entry->user_data);
 	}
 
 	if (priv->parent) {
@@ -373,9 +657,11 @@ dbusmenu_menuitem_finalize (GObject *object)
 	/* g_debug("Menuitem dying"); */
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(object);
 
-	if (priv->properties != NULL) {
-		g_hash_table_destroy(priv->properties);
-		priv->properties = NULL;
+	props_free(priv);
+
+	if (priv->properties_variant != NULL) {
+		g_variant_unref(priv->properties_variant);
+		priv->properties_variant = NULL;
 	}
 
 	G_OBJECT_CLASS (dbusmenu_menuitem_parent_class)->finalize (object);
@@ -469,19 +755,248 @@ send_about_to_show (DbusmenuMenuitem * mi, void (*cb) (DbusmenuMenuitem * mi, gp
 	return;
 }
 
-/* A helper function to get the type of the menuitem, this might
-   be a candidate for optimization in the future. */
+/* A helper function to get the type of the menuitem */
 static const gchar *
 menuitem_get_type (const DbusmenuMenuitem * mi)
 {
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	GVariant * currentval = (GVariant *)g_hash_table_lookup(priv->properties, DBUSMENU_MENUITEM_PROP_TYPE);
+	GVariant * currentval = props_lookup(priv, prop_type_quark, DBUSMENU_MENUITEM_PROP_TYPE);
 	if (currentval != NULL) {
 		return g_variant_get_string(currentval, NULL);
 	}
 	return NULL;
 }
 
+/* The defaults for the type of the menuitem.  They're found
+   once and kept until the type changes. */
+static GHashTable *
+menuitem_get_defaults (const DbusmenuMenuitem * mi)
+{
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+
+	if (priv->defaults_table == NULL && priv->defaults != NULL) {
+		priv->defaults_table = dbusmenu_defaults_type_table(priv->defaults, menuitem_get_type(mi));
+	}
+
+	return priv->defaults_table;
+}
+
+/* How many observers there are, so that nobody has to look
+   for one when there aren't any */
+static guint observers = 0;
+
+/* Finds @mi or the first item above it that has an observer */
+static DbusmenuMenuitem *
+observer_find (DbusmenuMenuitem * mi)
+{
+	while (mi != NULL && DBUSMENU_MENUITEM_GET_PRIVATE(mi)->observers == NULL) {
+		mi = DBUSMENU_MENUITEM_GET_PRIVATE(mi)->parent;
+	}
+
+	return mi;
+}
+
+/* Calls @func on every observer from @mi up to the top of its
+   tree, the observer's data goes on the end of the arguments */
+#define OBSERVERS_CALL(mi, func, ...) G_STMT_START { \
+	if (observers > 0) { \
+		DbusmenuMenuitem * obsmi; \
+		for (obsmi = observer_find(mi); obsmi != NULL; obsmi = observer_find(DBUSMENU_MENUITEM_GET_PRIVATE(obsmi)->parent)) { \
+			GSList * obslist; \
+			for (obslist = DBUSMENU_MENUITEM_GET_PRIVATE(obsmi)->observers; obslist != NULL; obslist = obslist->next) { \
+				observer_t * obs = (observer_t *)obslist->data; \
+				if (obs->observer->func != NULL) { \
+					obs->observer->func(__VA_ARGS__, obs->user_data); \
+				} \
+			} \
+		} \
+	} \
+} G_STMT_END
+
+/* Gets the link of the child at @index */
+#define CHILD_LINK(priv, index)  (g_array_index((priv)->child_links, GList *, (index)))
+
+/* Forget the index of the children, the list itself is
+   handled by the caller */
+static void
+children_clear (DbusmenuMenuitemPrivate * priv)
+{
+	if (priv->child_links != NULL) {
+		g_array_free(priv->child_links, TRUE);
+		priv->child_links = NULL;
+	}
+
+	g_free(priv->realized_tree);
+	priv->realized_tree = NULL;
+	priv->realized_valid = FALSE;
+	priv->positions_valid = 0;
+
+	return;
+}
+
+/* The number of children */
+static guint
+children_count (DbusmenuMenuitemPrivate * priv)
+{
+	return priv->child_links != NULL ? priv->child_links->len : 0;
+}
+
+/* Puts @link in the list of children at @position, or at the
+   end if there aren't that many.  Returns where it went. */
+static guint
+children_link_insert (DbusmenuMenuitemPrivate * priv, GList * link, guint position)
+{
+	guint count = children_count(priv);
+
+	if (position > count) {
+		position = count;
+	}
+
+	if (position < count) {
+		GList * next = CHILD_LINK(priv, position);
+
+		link->prev = next->prev;
+		link->next = next;
+		if (next->prev != NULL) {
+			next->prev->next = link;
+		} else {
+			priv->children = link;
+		}
+		next->prev = link;
+	} else if (count > 0) {
+		GList * prev = CHILD_LINK(priv, count - 1);
+
+		link->prev = prev;
+		link->next = NULL;
+		prev->next = link;
+	} else {
+		link->prev = NULL;
+		link->next = NULL;
+		priv->children = link;
+	}
+
+	if (priv->child_links == NULL) {
+		priv->child_links = g_array_new(FALSE, FALSE, sizeof(GList *));
+	}
+	g_array_insert_val(priv->child_links, position, link);
+
+	/* Everyone after us moved along, unless we're at the end
+	   and everyone before us is already right */
+	DBUSMENU_MENUITEM_GET_PRIVATE(link->data)->position = position;
+	if (priv->positions_valid == position) {
+		priv->positions_valid++;
+	} else {
+		priv->positions_valid = MIN(priv->positions_valid, position);
+	}
+	priv->realized_valid = FALSE;
+
+	return position;
+}
+
+/* Takes the link at @index out of the list of children, it's
+   not free'd */
+static GList *
+children_link_remove (DbusmenuMenuitemPrivate * priv, guint index)
+{
+	GList * link = CHILD_LINK(priv, index);
+
+	if (link->prev != NULL) {
+		link->prev->next = link->next;
+	} else {
+		priv->children = link->next;
+	}
+	if (link->next != NULL) {
+		link->next->prev = link->prev;
+	}
+	link->prev = NULL;
+	link->next = NULL;
+
+	g_array_remove_index(priv->child_links, index);
+
+	priv->positions_valid = MIN(priv->positions_valid, index);
+	priv->realized_valid = FALSE;
+
+	return link;
+}
+
+/* Finds where @child is in the children.  Each child remembers
+   its position, which is checked, and only the positions that
+   could have moved since the last time get looked at again. */
+static gint
+children_index (DbusmenuMenuitemPrivate * priv, DbusmenuMenuitem * child)
+{
+	guint count = children_count(priv);
+	DbusmenuMenuitemPrivate * cpriv = DBUSMENU_MENUITEM_GET_PRIVATE(child);
+
+	if (cpriv->position < count && CHILD_LINK(priv, cpriv->position)->data == child) {
+		return cpriv->position;
+	}
+
+	for (; priv->positions_valid < count; priv->positions_valid++) {
+		GList * link = CHILD_LINK(priv, priv->positions_valid);
+		DBUSMENU_MENUITEM_GET_PRIVATE(link->data)->position = priv->positions_valid;
+	}
+
+	if (cpriv->position < count && CHILD_LINK(priv, cpriv->position)->data == child) {
+		return cpriv->position;
+	}
+
+	return -1;
+}
+
+/* How many of the children before @index have been realized.  The
+   tree gets built again after the children change and is updated
+   in place as they get realized. */
+static guint
+children_realized_before (DbusmenuMenuitemPrivate * priv, guint index)
+{
+	guint count = children_count(priv);
+	guint i;
+
+	if (!priv->realized_valid) {
+		priv->realized_tree = g_renew(guint, priv->realized_tree, count + 1);
+		priv->realized_tree[0] = 0;
+
+		for (i = 1; i <= count; i++) {
+			priv->realized_tree[i] = dbusmenu_menuitem_realized(DBUSMENU_MENUITEM(CHILD_LINK(priv, i - 1)->data)) ? 1 : 0;
+		}
+
+		for (i = 1; i <= count; i++) {
+			guint up = i + (i & -i);
+			if (up <= count) {
+				priv->realized_tree[up] += priv->realized_tree[i];
+			}
+		}
+
+		priv->realized_valid = TRUE;
+	}
+
+	guint realized = 0;
+	for (i = MIN(index, count); i > 0; i -= i & -i) {
+		realized += priv->realized_tree[i];
+	}
+
+	return realized;
+}
+
+/* The child at @index has just been realized */
+static void
+children_realized_add (DbusmenuMenuitemPrivate * priv, guint index)
+{
+	if (!priv->realized_valid) {
+		return;
+	}
+
+	guint count = children_count(priv);
+	guint i;
+
+	for (i = index + 1; i <= count; i += i & -i) {
+		priv->realized_tree[i]++;
+	}
+
+	return;
+}
+
 /* Public interface */
 
 /**
@@ -570,6 +1085,12 @@ dbusmenu_menuitem_set_realized (DbusmenuMenuitem * mi)
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 	if (priv->realized) {
 		g_warning("Realized entry realized again?  ID: %d", dbusmenu_menuitem_get_id(mi));
+	} else if (priv->parent != NULL) {
+		DbusmenuMenuitemPrivate * ppriv = DBUSMENU_MENUITEM_GET_PRIVATE(priv->parent);
+		gint index = children_index(ppriv, mi);
+		if (index >= 0) {
+			children_realized_add(ppriv, index);
+		}
 	}
 	priv->realized = TRUE;
 	g_signal_emit(G_OBJECT(mi), signals[REALIZED], 0, TRUE);
@@ -582,7 +1103,8 @@ dbusmenu_menuitem_set_realized (DbusmenuMenuitem * mi)
  * 
  * Returns simply the list of children that this menu item
  * has.  The list is valid until another child related function
- * is called, where it might be changed.
+ * is called, where it might be changed.  It is kept up to date
+ * with the children, so getting it is cheap.
  * 
  * Return value: (transfer none) (element-type Dbusmenu.Menuitem): A #GList of pointers to #DbusmenuMenuitem objects.
  */
@@ -595,6 +1117,108 @@ dbusmenu_menuitem_get_children (DbusmenuMenuitem * mi)
 	return priv->children;
 }
 
+/* Adds an observer that gets told about the changes to @mi and
+   everything below it.  Each of the observers on an item gets
+   told, in the order they were added, and then the ones on the
+   items above it. */
+void
+_dbusmenu_menuitem_add_observer (DbusmenuMenuitem * mi, const DbusmenuMenuitemObserver * observer, gpointer user_data)
+{
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(mi));
+	g_return_if_fail(observer != NULL);
+
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+
+	observer_t * entry = g_new0(observer_t, 1);
+	entry->observer = observer;
+	entry->user_data = user_data;
+
+	priv->observers = g_slist_append(priv->observers, entry);
+	observers++;
+
+	return;
+}
+
+/* Removes the observer that was added with the same @observer
+   and @user_data */
+void
+_dbusmenu_menuitem_remove_observer (DbusmenuMenuitem * mi, const DbusmenuMenuitemObserver * observer, gpointer user_data)
+{
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(mi));
+
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+	GSList * link;
+
+	for (link = priv->observers; link != NULL; link = link->next) {
+		observer_t * entry = (observer_t *)link->data;
+
+		if (entry->observer == observer && entry->user_data == user_data) {
+			priv->observers = g_slist_delete_link(priv->observers, link);
+			g_free(entry);
+			observers--;
+			return;
+		}
+	}
+
+	g_warning("Removing an observer that wasn't added to menuitem %d", priv->id);
+	return;
+}
+
+/* How many children @mi has, without walking them */
+guint
+_dbusmenu_menuitem_get_n_children (DbusmenuMenuitem * mi)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), 0);
+
+	return children_count(DBUSMENU_MENUITEM_GET_PRIVATE(mi));
+}
+
+/* The link in the list of children of @mi for the child at
+   @position, to walk on from there.  #NULL if there aren't
+   that many. */
+GList *
+_dbusmenu_menuitem_get_child_link (DbusmenuMenuitem * mi, guint position)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), NULL);
+
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+
+	if (position >= children_count(priv)) {
+		return NULL;
+	}
+
+	return CHILD_LINK(priv, position);
+}
+
+/* Adds up the size of the serialized property values */
+static void
+tree_stats_bytes (const gchar * name, GVariant * value, gpointer user_data)
+{
+	*(guint64 *)user_data += g_variant_get_size(value);
+	return;
+}
+
+/* Adds the number of items, properties and bytes of property
+   values in @mi and everything below it to the counters */
+void
+_dbusmenu_menuitem_tree_stats (DbusmenuMenuitem * mi, guint * items, guint * properties, guint64 * bytes)
+{
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(mi));
+
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+
+	*items += 1;
+	*properties += props_count(priv);
+	props_foreach(priv, tree_stats_bytes, bytes);
+
+	GList * child;
+	for (child = priv->children; child != NULL; child = g_list_next(child)) {
+		_dbusmenu_menuitem_tree_stats(DBUSMENU_MENUITEM(child->data), items, properties, bytes);
+	}
+
+	return;
+}
+
 /* For all the taken children we need to signal
    that they were removed */
 static void
@@ -605,6 +1229,7 @@ take_children_helper (gpointer data, gpointer user_data)
 	#endif
 	dbusmenu_menuitem_unparent(DBUSMENU_MENUITEM(data));
 	g_signal_emit(G_OBJECT(user_data), signals[CHILD_REMOVED], 0, DBUSMENU_MENUITEM(data), TRUE);
+	OBSERVERS_CALL(DBUSMENU_MENUITEM(user_data), child_removed, DBUSMENU_MENUITEM(user_data), DBUSMENU_MENUITEM(data));
 	return;
 }
 
@@ -629,6 +1254,7 @@ dbusmenu_menuitem_take_children (DbusmenuMenuitem * mi)
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 	GList * children = priv->children;
 	priv->children = NULL;
+	children_clear(priv);
 	g_list_foreach(children, take_children_helper, mi);
 
 	dbusmenu_menuitem_property_remove(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY);
@@ -659,20 +1285,14 @@ dbusmenu_menuitem_get_position (DbusmenuMenuitem * mi, DbusmenuMenuitem * parent
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), 0);
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(parent), 0);
 
-	GList * childs = dbusmenu_menuitem_get_children(parent);
-	if (childs == NULL) return 0;
-	guint count = 0;
-	for ( ; childs != NULL; childs = childs->next, count++) {
-		if (childs->data == mi) break;
-	}
-
-	if (childs == NULL) return 0;
+	gint index = children_index(DBUSMENU_MENUITEM_GET_PRIVATE(parent), mi);
+	if (index < 0) return 0;
 
 	#ifdef MASSIVEDEBUGGING
-	g_debug("Getting position of %d (%s), it's at: %d", ID(mi), LABEL(mi), count);
+	g_debug("Getting position of %d (%s), it's at: %d", ID(mi), LABEL(mi), index);
 	#endif
 
-	return count;
+	return index;
 }
 
 /**
@@ -697,20 +1317,14 @@ dbusmenu_menuitem_get_position_realized (DbusmenuMenuitem * mi, DbusmenuMenuitem
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), 0);
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(parent), 0);
 
-	GList * childs = dbusmenu_menuitem_get_children(parent);
-	if (childs == NULL) return 0;
-	guint count = 0;
-	for ( ; childs != NULL; childs = childs->next, count++) {
-		if (!dbusmenu_menuitem_realized(DBUSMENU_MENUITEM(childs->data))) {
-			count--;
-			continue;
-		}
-		if (childs->data == mi) {
-			break;
-		}
-	}
+	/* Only realized children have a realized position */
+	if (!dbusmenu_menuitem_realized(mi)) return 0;
+
+	DbusmenuMenuitemPrivate * ppriv = DBUSMENU_MENUITEM_GET_PRIVATE(parent);
+	gint index = children_index(ppriv, mi);
+	if (index < 0) return 0;
 
-	if (childs == NULL) return 0;
+	guint count = children_realized_before(ppriv, index);
 
 	#ifdef MASSIVEDEBUGGING
 	g_debug("Getting position of %d (%s), it's at: %d", ID(mi), LABEL(mi), count);
@@ -736,7 +1350,7 @@ dbusmenu_menuitem_child_append (DbusmenuMenuitem * mi, DbusmenuMenuitem * child)
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(child), FALSE);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	g_return_val_if_fail(g_list_find(priv->children, child) == NULL, FALSE);
+	g_return_val_if_fail(children_index(priv, child) < 0, FALSE);
 
 	if (!dbusmenu_menuitem_set_parent(child, mi)) {
 		return FALSE;
@@ -746,12 +1360,13 @@ dbusmenu_menuitem_child_append (DbusmenuMenuitem * mi, DbusmenuMenuitem * child)
 		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
 	}
 
-	priv->children = g_list_append(priv->children, child);
+	guint position = children_link_insert(priv, g_list_prepend(NULL, child), G_MAXUINT);
 	#ifdef MASSIVEDEBUGGING
-	g_debug("Menuitem %d (%s) signalling child added %d (%s) at %d", ID(mi), LABEL(mi), ID(child), LABEL(child), g_list_length(priv->children) - 1);
+	g_debug("Menuitem %d (%s) signalling child added %d (%s) at %d", ID(mi), LABEL(mi), ID(child), LABEL(child), position);
 	#endif
 	g_object_ref(G_OBJECT(child));
-	g_signal_emit(G_OBJECT(mi), signals[CHILD_ADDED], 0, child, g_list_length(priv->children) - 1, TRUE);
+	g_signal_emit(G_OBJECT(mi), signals[CHILD_ADDED], 0, child, position, TRUE);
+	OBSERVERS_CALL(mi, child_added, mi, child, position);
 	return TRUE;
 }
 
@@ -772,7 +1387,7 @@ dbusmenu_menuitem_child_prepend (DbusmenuMenuitem * mi, DbusmenuMenuitem * child
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(child), FALSE);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	g_return_val_if_fail(g_list_find(priv->children, child) == NULL, FALSE);
+	g_return_val_if_fail(children_index(priv, child) < 0, FALSE);
 
 	if (!dbusmenu_menuitem_set_parent(child, mi)) {
 		return FALSE;
@@ -782,12 +1397,13 @@ dbusmenu_menuitem_child_prepend (DbusmenuMenuitem * mi, DbusmenuMenuitem * child
 		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
 	}
 
-	priv->children = g_list_prepend(priv->children, child);
+	children_link_insert(priv, g_list_prepend(NULL, child), 0);
 	#ifdef MASSIVEDEBUGGING
 	g_debug("Menuitem %d (%s) signalling child added %d (%s) at %d", ID(mi), LABEL(mi), ID(child), LABEL(child), 0);
 	#endif
 	g_object_ref(G_OBJECT(child));
 	g_signal_emit(G_OBJECT(mi), signals[CHILD_ADDED], 0, child, 0, TRUE);
+	OBSERVERS_CALL(mi, child_added, mi, child, 0);
 	return TRUE;
 }
 
@@ -814,12 +1430,16 @@ dbusmenu_menuitem_child_delete (DbusmenuMenuitem * mi, DbusmenuMenuitem * child)
 	}
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	priv->children = g_list_remove(priv->children, child);
+	gint index = children_index(priv, child);
+	if (index >= 0) {
+		g_list_free_1(children_link_remove(priv, index));
+	}
 	dbusmenu_menuitem_unparent(child);
 	#ifdef MASSIVEDEBUGGING
 	g_debug("Menuitem %d (%s) signalling child removed %d (%s)", ID(mi), LABEL(mi), ID(child), LABEL(child));
 	#endif
 	g_signal_emit(G_OBJECT(mi), signals[CHILD_REMOVED], 0, child, TRUE);
+	OBSERVERS_CALL(mi, child_removed, mi, child);
 	g_object_unref(G_OBJECT(child));
 
 	if (priv->children == NULL) {
@@ -848,7 +1468,7 @@ dbusmenu_menuitem_child_add_position (DbusmenuMenuitem * mi, DbusmenuMenuitem *
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(child), FALSE);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	g_return_val_if_fail(g_list_find(priv->children, child) == NULL, FALSE);
+	g_return_val_if_fail(children_index(priv, child) < 0, FALSE);
 
 	if (!dbusmenu_menuitem_set_parent(child, mi)) {
 		return FALSE;
@@ -858,12 +1478,13 @@ dbusmenu_menuitem_child_add_position (DbusmenuMenuitem * mi, DbusmenuMenuitem *
 		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
 	}
 
-	priv->children = g_list_insert(priv->children, child, position);
+	children_link_insert(priv, g_list_prepend(NULL, child), position);
 	#ifdef MASSIVEDEBUGGING
 	g_debug("Menuitem %d (%s) signalling child added %d (%s) at %d", ID(mi), LABEL(mi), ID(child), LABEL(child), position);
 	#endif
 	g_object_ref(G_OBJECT(child));
 	g_signal_emit(G_OBJECT(mi), signals[CHILD_ADDED], 0, child, position, TRUE);
+	OBSERVERS_CALL(mi, child_added, mi, child, position);
 	return TRUE;
 }
 
@@ -886,7 +1507,7 @@ dbusmenu_menuitem_child_reorder(DbusmenuMenuitem * mi, DbusmenuMenuitem * child,
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(child), FALSE);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	gint oldpos = g_list_index(priv->children, child);
+	gint oldpos = children_index(priv, child);
 
 	if (oldpos == -1) {
 		g_warning("Can not reorder child that isn't actually a child.");
@@ -896,13 +1517,14 @@ dbusmenu_menuitem_child_reorder(DbusmenuMenuitem * mi, DbusmenuMenuitem * child,
 		return TRUE;
 	}
 
-	priv->children = g_list_remove(priv->children, child);
-	priv->children = g_list_insert(priv->children, child, position);
+	/* The link moves with the child */
+	children_link_insert(priv, children_link_remove(priv, oldpos), position);
 
 	#ifdef MASSIVEDEBUGGING
 	g_debug("Menuitem %d (%s) signalling child %d (%s) moved from %d to %d", ID(mi), LABEL(mi), ID(child), LABEL(child), oldpos, position);
 	#endif
 	g_signal_emit(G_OBJECT(mi), signals[CHILD_MOVED], 0, child, position, oldpos, TRUE);
+	OBSERVERS_CALL(mi, child_moved, mi, child, position, oldpos);
 
 	return TRUE;
 }
@@ -923,11 +1545,12 @@ dbusmenu_menuitem_child_find (DbusmenuMenuitem * mi, gint id)
 {
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), NULL);
 
-	GList * childs = dbusmenu_menuitem_get_children(mi);
-	if (childs == NULL) return NULL;
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+	guint count = children_count(priv);
+	guint i;
 
-	for ( ; childs == NULL; childs = g_list_next(childs)) {
-		DbusmenuMenuitem * lmi = DBUSMENU_MENUITEM(childs->data);
+	for (i = 0; i < count; i++) {
+		DbusmenuMenuitem * lmi = DBUSMENU_MENUITEM(CHILD_LINK(priv, i)->data);
 		if (id == dbusmenu_menuitem_get_id(lmi)) {
 			return lmi;
 		}
@@ -1183,27 +1806,34 @@ dbusmenu_menuitem_property_set_variant (DbusmenuMenuitem * mi, const gchar * pro
 	g_return_val_if_fail(property != NULL, FALSE);
 	g_return_val_if_fail(g_utf8_validate(property, -1, NULL), FALSE);
 
+	/* Names that aren't interned already don't get to be */
+	return property_set_key(mi, g_quark_try_string(property), property, value, NULL);
+}
+
+/* Sets @property, which has already been checked and has the quark
+   @key if it's interned.  If @changed is set the name is put on it
+   when the value changes and it's up to the caller to signal
+   properties-changed, otherwise we do it here for just this one. */
+static gboolean
+property_set_key (DbusmenuMenuitem * mi, GQuark key, const gchar * property, GVariant * value, GPtrArray * changed)
+{
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 	GVariant * default_value = NULL;
+	GVariantType * default_type = NULL;
 
-	const gchar * type = menuitem_get_type(mi);
-
-	if (value != NULL) {
-		/* Check the expected type to see if we want to have a warning */
-		GVariantType * default_type = dbusmenu_defaults_default_get_type(priv->defaults, type, property);
-		if (default_type != NULL) {
-			/* If we have an expected type we should check to see if
-			   the value we've been given is of the same type and generate
-			   a warning if it isn't */
-			if (!g_variant_is_of_type(value, default_type)) {
-				g_warning("Setting menuitem property '%s' with value of type '%s' when expecting '%s'", property, g_variant_get_type_string(value), g_variant_type_peek_string(default_type));
-			}
+	/* Check the defaults database to see if we have a default
+	   for this property and the type it should have. */
+	dbusmenu_defaults_table_lookup(menuitem_get_defaults(mi), key, &default_value, &default_type);
+
+	if (value != NULL && default_type != NULL) {
+		/* If we have an expected type we should check to see if
+		   the value we've been given is of the same type and generate
+		   a warning if it isn't */
+		if (!g_variant_is_of_type(value, default_type)) {
+			g_warning("Setting menuitem property '%s' with value of type '%s' when expecting '%s'", property, g_variant_get_type_string(value), g_variant_type_peek_string(default_type));
 		}
 	}
 
-	/* Check the defaults database to see if we have a default
-	   for this property. */
-	default_value = dbusmenu_defaults_default_get(priv->defaults, type, property);
 	if (default_value != NULL && value != NULL) {
 		/* Now see if we're setting this to the same value as the
 		   default.  If we are then we just want to swallow this variant
@@ -1216,55 +1846,42 @@ dbusmenu_menuitem_property_set_variant (DbusmenuMenuitem * mi, const gchar * pro
 	}
 
 	gboolean replaced = FALSE;
-	gboolean remove = FALSE;
-	gchar * hash_key = NULL;
-	GVariant * hash_variant = NULL;
-	gboolean inhash = g_hash_table_lookup_extended(priv->properties, property, (gpointer *)&hash_key, (gpointer *)&hash_variant);
-
-	if (inhash && hash_variant == NULL) {
-		g_warning("The property '%s' is in the hash with a NULL variant", property);
-		inhash = FALSE;
-	}
+	GVariant * old_variant = NULL;
+	gchar * old_name = NULL;
+	GVariant * current_variant = props_lookup(priv, key, property);
 
 	if (value != NULL) {
 		/* NOTE: We're only marking this as replaced if this is true
 		   but we're actually replacing it no matter.  This is so that
 		   the variant passed in sticks around which the caller may
 		   expect.  They shouldn't, but it's low cost to remove bugs. */
-		if (!inhash || (hash_variant != NULL && !g_variant_equal(hash_variant, value))) {
+		if (current_variant == NULL || !g_variant_equal(current_variant, value)) {
 			replaced = TRUE;
 		}
 
-		gchar * lprop = g_strdup(property);
 		g_variant_ref_sink(value);
-
-		/* Really important that this is _insert as that means the value
-		   that we just created in the _strdup is free'd and not the one
-		   currently in the hashtable.  That could be the same as the one
-		   being passed in and then the signal emit would be done with a
-		   bad value */
-		g_hash_table_insert(priv->properties, lprop, value);
-	} else {
-		if (inhash) {
-		/* So the question you should be asking if you're paying attention
-		   is "Why not just do the remove here?"  It's a good question with
-		   an interesting answer.  Bascially it's the same reason as above,
-		   in a couple cases the passed in properties is the value in the hash
-		   table so we can avoid strdup'ing it by removing it (and thus free'ing
-		   it) after the signal emition */
-			remove = TRUE;
-			replaced = TRUE;
-			g_hash_table_steal(priv->properties, property);
-		}
+		old_variant = props_replace(priv, key, property, value);
+	} else if (current_variant != NULL) {
+		/* The value we had is kept until after the signal, the
+		   caller may have gotten @value or @property from us */
+		replaced = TRUE;
+		old_variant = props_steal(priv, key, property, &old_name);
 	}
 
-	/* NOTE: The actual value is invalid at this point
-	   becuse it has been unref'd when replaced in the hash
-	   table.  But the fact that there was a value is
-	   the imporant part. */
 	if (replaced) {
 		GVariant * signalval = value;
 
+		/* A new type has its own defaults */
+		if (key == prop_type_quark) {
+			priv->defaults_table = NULL;
+		}
+
+		/* Our serialized copy is out of date now */
+		if (priv->properties_variant != NULL) {
+			g_variant_unref(priv->properties_variant);
+			priv->properties_variant = NULL;
+		}
+
 		if (signalval == NULL) {
 			/* Might also be NULL, but if it is we're definitely
 			   clearing this thing. */
@@ -1272,12 +1889,118 @@ dbusmenu_menuitem_property_set_variant (DbusmenuMenuitem * mi, const gchar * pro
 		}
 
 		g_signal_emit(G_OBJECT(mi), signals[PROPERTY_CHANGED], 0, property, signalval, TRUE);
+		OBSERVERS_CALL(mi, property_changed, mi, property, signalval);
+
+		if (changed != NULL) {
+			g_ptr_array_add(changed, (gpointer)property);
+		} else {
+			properties_changed_emit(mi, &property, 1);
+		}
 	}
 
-	if (remove) {
-		g_free(hash_key);
-		g_variant_unref(hash_variant);
+	if (old_variant != NULL) {
+		g_variant_unref(old_variant);
 	}
+	g_free(old_name);
+
+	return TRUE;
+}
+
+/* Signals properties-changed with the first @nnames of @names,
+   if there are any and someone is listening.  Every single set
+   comes through here so it's worth not building the list for
+   nobody. */
+static void
+properties_changed_emit (DbusmenuMenuitem * mi, const gchar ** names, guint nnames)
+{
+	if (nnames == 0) {
+		return;
+	}
+
+	if (DBUSMENU_MENUITEM_GET_CLASS(mi)->properties_changed == NULL
+			&& !g_signal_has_handler_pending(mi, signals[PROPERTIES_CHANGED], 0, FALSE)) {
+		return;
+	}
+
+	const gchar * single[2];
+	const gchar ** terminated = nnames == 1 ? single : g_new(const gchar *, nnames + 1);
+
+	memcpy(terminated, names, nnames * sizeof(const gchar *));
+	terminated[nnames] = NULL;
+
+	g_signal_emit(G_OBJECT(mi), signals[PROPERTIES_CHANGED], 0, terminated, TRUE);
+
+	if (terminated != single) {
+		g_free(terminated);
+	}
+
+	return;
+}
+
+/* Sets a property without checking the name, for callers that
+   set a lot of them with names that are known to be fine already,
+   like the ones that come in a GVariant from the bus */
+gboolean
+_dbusmenu_menuitem_property_set_unchecked (DbusmenuMenuitem * mi, const gchar * property, GVariant * value)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), FALSE);
+	g_return_val_if_fail(property != NULL, FALSE);
+
+	return property_set_key(mi, g_quark_try_string(property), property, value, NULL);
+}
+
+/**
+ * dbusmenu_menuitem_properties_set_many:
+ * @mi: The #DbusmenuMenuitem to set the properties on.
+ * @properties: A dictionary of type a{sv} of names and values
+ *
+ * Sets all of the properties in @properties on @mi as if
+ * #dbusmenu_menuitem_property_set_variant was called for each of
+ * them, but #DbusmenuMenuitem::properties-changed is only emitted
+ * once at the end with all the ones that changed.  If the type is
+ * in @properties it is set first, as it changes the defaults that
+ * the others are checked against.  A floating @properties is
+ * consumed.
+ *
+ * Return value: A boolean representing if the properties were set.
+ */
+gboolean
+dbusmenu_menuitem_properties_set_many (DbusmenuMenuitem * mi, GVariant * properties)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), FALSE);
+	g_return_val_if_fail(properties != NULL, FALSE);
+	g_return_val_if_fail(g_variant_is_of_type(properties, G_VARIANT_TYPE("a{sv}")), FALSE);
+
+	g_variant_ref_sink(properties);
+
+	/* The names point into @properties, which is kept until the
+	   signal is done */
+	GPtrArray * changed = g_ptr_array_sized_new(g_variant_n_children(properties));
+	GVariantIter iter;
+	const gchar * name;
+	GVariant * value;
+
+	value = g_variant_lookup_value(properties, DBUSMENU_MENUITEM_PROP_TYPE, NULL);
+	if (value != NULL) {
+		property_set_key(mi, prop_type_quark, DBUSMENU_MENUITEM_PROP_TYPE, value, changed);
+		g_variant_unref(value);
+	}
+
+	/* Names in a GVariant are valid UTF-8 so there's no need to
+	   check them again */
+	g_variant_iter_init(&iter, properties);
+	while (g_variant_iter_loop(&iter, "{&sv}", &name, &value)) {
+		GQuark key = g_quark_try_string(name);
+
+		if (key != prop_type_quark) {
+			property_set_key(mi, key, name, value, changed);
+		}
+	}
+
+	properties_changed_emit(mi, (const gchar **)changed->pdata, changed->len);
+
+	g_ptr_array_free(changed, TRUE);
+	g_variant_unref(properties);
 
 	return TRUE;
 }
@@ -1323,10 +2046,11 @@ dbusmenu_menuitem_property_get_variant (const DbusmenuMenuitem * mi, const gchar
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 
-	GVariant * currentval = (GVariant *)g_hash_table_lookup(priv->properties, property);
+	GQuark key = g_quark_try_string(property);
+	GVariant * currentval = props_lookup(priv, key, property);
 
 	if (currentval == NULL) {
-		currentval = dbusmenu_defaults_default_get(priv->defaults, menuitem_get_type(mi), property);
+		dbusmenu_defaults_table_lookup(menuitem_get_defaults(mi), key, &currentval, NULL);
 	}
 
 	return currentval;
@@ -1439,7 +2163,7 @@ dbusmenu_menuitem_property_exist (const DbusmenuMenuitem * mi, const gchar * pro
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 
-	gpointer value = g_hash_table_lookup(priv->properties, property);
+	GVariant * value = props_lookup(priv, g_quark_try_string(property), property);
 
 	return value != NULL;
 }
@@ -1462,6 +2186,16 @@ dbusmenu_menuitem_property_remove (DbusmenuMenuitem * mi, const gchar * property
 	return;
 }
 
+/* Puts the name of each property on the list, the names live
+   as long as their properties are set */
+static void
+list_helper (const gchar * name, GVariant * value, gpointer user_data)
+{
+	GList ** list = (GList **)user_data;
+	*list = g_list_prepend(*list, (gpointer)name);
+	return;
+}
+
 /**
  * dbusmenu_menuitem_properties_list:
  * @mi: #DbusmenuMenuitem to list the properties on
@@ -1480,20 +2214,20 @@ dbusmenu_menuitem_properties_list (DbusmenuMenuitem * mi)
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), NULL);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	return g_hash_table_get_keys(priv->properties);
+	GList * list = NULL;
+	props_foreach(priv, list_helper, &list);
+	return g_list_reverse(list);
 }
 
 /* Copy the keys and make references to the variants that are
    in the new table.  They'll be free'd and unref'd when the
    Hashtable gets destroyed. */
 static void
-copy_helper (gpointer in_key, gpointer in_value, gpointer in_data)
+copy_helper (const gchar * name, GVariant * value, gpointer in_data)
 {
 	GHashTable * table = (GHashTable *)in_data;
-	gchar * key = (gchar *)in_key;
-	GVariant * value = (GVariant *)in_value;
 	g_variant_ref_sink(value);
-	g_hash_table_insert(table, g_strdup(key), value);
+	g_hash_table_insert(table, g_strdup(name), value);
 	return;
 }
 
@@ -1519,7 +2253,7 @@ dbusmenu_menuitem_properties_copy (DbusmenuMenuitem * mi)
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), ret);
 
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
-	g_hash_table_foreach(priv->properties, copy_helper, ret);
+	props_foreach(priv, copy_helper, ret);
 
 	return ret;
 }
@@ -1527,10 +2261,10 @@ dbusmenu_menuitem_properties_copy (DbusmenuMenuitem * mi)
 /* Looks at each value in the hashtable and tries to convert it
    into a variant and add it to our variant builder */
 static void
-variant_helper (gpointer in_key, gpointer in_value, gpointer user_data)
+variant_helper (const gchar * name, GVariant * in_value, gpointer user_data)
 {
-	GVariant * value = g_variant_new_dict_entry(g_variant_new_string((gchar *)in_key),
-	                                            g_variant_new_variant((GVariant *)in_value));
+	GVariant * value = g_variant_new_dict_entry(g_variant_new_string(name),
+	                                            g_variant_new_variant(in_value));
 	g_variant_builder_add_value((GVariantBuilder *)user_data, value);
 	return;
 }
@@ -1540,7 +2274,8 @@ variant_helper (gpointer in_key, gpointer in_value, gpointer user_data)
  * @mi: #DbusmenuMenuitem to get properties from
  * 
  * Grabs the properties of the menuitem as a GVariant with the
- * type "a{sv}".
+ * type "a{sv}".  When all the properties are requested the
+ * same variant is returned until one of them changes.
  * 
  * Return Value: (transfer full): A GVariant of type "a{sv}" or NULL on error.
  */
@@ -1553,13 +2288,17 @@ dbusmenu_menuitem_properties_variant (DbusmenuMenuitem * mi, const gchar ** prop
 
 	GVariant * final_variant = NULL;
 
-	if ((properties == NULL || properties[0] == NULL) && g_hash_table_size(priv->properties) > 0) {
-		GVariantBuilder builder;
-		g_variant_builder_init(&builder, G_VARIANT_TYPE_ARRAY);
+	if ((properties == NULL || properties[0] == NULL) && props_count(priv) > 0) {
+		if (priv->properties_variant == NULL) {
+			GVariantBuilder builder;
+			g_variant_builder_init(&builder, G_VARIANT_TYPE_ARRAY);
+
+			props_foreach(priv, variant_helper, &builder);
 
-		g_hash_table_foreach(priv->properties, variant_helper, &builder);
+			priv->properties_variant = g_variant_ref_sink(g_variant_builder_end(&builder));
+		}
 
-		final_variant = g_variant_builder_end(&builder);
+		final_variant = g_variant_ref(priv->properties_variant);
 	}
 
 	if (properties != NULL) {
@@ -1585,7 +2324,7 @@ dbusmenu_menuitem_properties_variant (DbusmenuMenuitem * mi, const gchar ** prop
 		}
 
 		if (builder_init) {
-			final_variant = g_variant_builder_end(&builder);
+			final_variant = g_variant_ref_sink(g_variant_builder_end(&builder));
 		}
 	}
 
@@ -1627,6 +2366,82 @@ dbusmenu_menuitem_get_root (DbusmenuMenuitem * mi)
 }
 
 
+/* Gets one of the constant empty values.  They're built the first
+   time they're asked for and then shared, which is a lot cheaper
+   than building or parsing them for every item.  Returns a full
+   reference that needs to be unref'd like any other variant. */
+GVariant *
+_dbusmenu_empty_variant (DbusmenuEmptyVariant which)
+{
+	static GVariant * empties[DBUSMENU_EMPTY_COUNT];
+	static gsize init = 0;
+
+	g_return_val_if_fail(which < DBUSMENU_EMPTY_COUNT, NULL);
+
+	if (g_once_init_enter(&init)) {
+		GVariant * zero = g_variant_new_int32(0);
+		GVariant * props = g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0);
+		GVariant * children = g_variant_new_array(G_VARIANT_TYPE_VARIANT, NULL, 0);
+
+		empties[DBUSMENU_EMPTY_PROPERTIES] = g_variant_ref_sink(props);
+		empties[DBUSMENU_EMPTY_CHILDREN] = g_variant_ref_sink(children);
+		empties[DBUSMENU_EMPTY_ITEM_PROPERTIES] = g_variant_ref_sink(g_variant_new_array(G_VARIANT_TYPE("(ia{sv})"), NULL, 0));
+		empties[DBUSMENU_EMPTY_ITEM_REMOVALS] = g_variant_ref_sink(g_variant_new_array(G_VARIANT_TYPE("(ias)"), NULL, 0));
+
+		GVariant * layout[3] = { zero, props, children };
+		empties[DBUSMENU_EMPTY_LAYOUT] = g_variant_ref_sink(g_variant_new_tuple(layout, 3));
+
+		GVariant * rootprops[2] = { zero, props };
+		GVariant * rootitem = g_variant_new_tuple(rootprops, 2);
+		GVariant * group = g_variant_new_array(NULL, &rootitem, 1);
+		empties[DBUSMENU_EMPTY_GROUP_PROPERTIES] = g_variant_ref_sink(g_variant_new_tuple(&group, 1));
+
+		g_once_init_leave(&init, 1);
+	}
+
+	return g_variant_ref(empties[which]);
+}
+
+/* The function that builds the children of an item
+   in the layout instead of its menuitems */
+typedef struct _build_children_t build_children_t;
+struct _build_children_t {
+	DbusmenuMenuitemBuildChildren func;
+	gpointer user_data;
+};
+
+/* Kept as qdata as very few items have one */
+static GQuark
+build_children_quark (void)
+{
+	static GQuark quark = 0;
+	if (quark == 0) {
+		quark = g_quark_from_static_string("dbusmenu-build-children");
+	}
+	return quark;
+}
+
+/* Makes the layout of @mi get its children from @func instead of
+   its menuitems, or go back to them when @func is NULL.  This is
+   how the server puts the items of a data source in the layout. */
+void
+_dbusmenu_menuitem_set_build_children (DbusmenuMenuitem * mi, DbusmenuMenuitemBuildChildren func, gpointer user_data)
+{
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(mi));
+
+	if (func == NULL) {
+		g_object_set_qdata(G_OBJECT(mi), build_children_quark(), NULL);
+		return;
+	}
+
+	build_children_t * build = g_new0(build_children_t, 1);
+	build->func = func;
+	build->user_data = user_data;
+
+	g_object_set_qdata_full(G_OBJECT(mi), build_children_quark(), build, g_free);
+	return;
+}
+
 /**
  * dbusmenu_menuitem_buildvariant:
  * @mi: #DbusmenuMenuitem to represent in a variant
@@ -1664,16 +2479,27 @@ dbusmenu_menuitem_build_variant (DbusmenuMenuitem * mi, const gchar ** propertie
 	GVariant * props = dbusmenu_menuitem_properties_variant(mi, properties);
 	if (props != NULL) {
 		g_variant_builder_add_value(&tupleb, props);
+		g_variant_unref(props);
 	} else {
-		GVariant *empty_props = g_variant_parse(G_VARIANT_TYPE("a{sv}"), "[ ]", NULL, NULL, NULL);
+		GVariant * empty_props = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
 		g_variant_builder_add_value(&tupleb, empty_props);
 		g_variant_unref(empty_props);
 	}
 
 	/* Pillage the children */
 	GList * children = dbusmenu_menuitem_get_children(mi);
-	if (children == NULL || recurse == 0) {
-		g_variant_builder_add_value(&tupleb, g_variant_new_array(G_VARIANT_TYPE_VARIANT, NULL, 0));
+	build_children_t * build = g_object_get_qdata(G_OBJECT(mi), build_children_quark());
+	if (build != NULL && recurse != 0) {
+		GVariantBuilder childrenbuilder;
+		g_variant_builder_init(&childrenbuilder, G_VARIANT_TYPE("av"));
+
+		build->func(mi, &childrenbuilder, properties, build->user_data);
+
+		g_variant_builder_add_value(&tupleb, g_variant_builder_end(&childrenbuilder));
+	} else if (children == NULL || recurse == 0) {
+		GVariant * empty_children = _dbusmenu_empty_variant(DBUSMENU_EMPTY_CHILDREN);
+		g_variant_builder_add_value(&tupleb, empty_children);
+		g_variant_unref(empty_children);
 	} else {
 		GVariantBuilder childrenbuilder;
 		g_variant_builder_init(&childrenbuilder, G_VARIANT_TYPE_ARRAY);
@@ -1690,6 +2516,326 @@ dbusmenu_menuitem_build_variant (DbusmenuMenuitem * mi, const gchar ** propertie
 	return g_variant_builder_end(&tupleb);
 }
 
+/* Builds the "(ia{sv}av)" node for a snapshot.  Unlike the layout
+   this keeps the real ID of every item, including the root, and
+   doesn't mark anything as exposed. */
+static GVariant *
+snapshot_build (DbusmenuMenuitem * mi)
+{
+	GVariantBuilder tupleb;
+	g_variant_builder_init(&tupleb, G_VARIANT_TYPE_TUPLE);
+
+	g_variant_builder_add_value(&tupleb, g_variant_new_int32(dbusmenu_menuitem_get_id(mi)));
+
+	GVariant * props = dbusmenu_menuitem_properties_variant(mi, NULL);
+	if (props == NULL) {
+		props = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
+	}
+	g_variant_builder_add_value(&tupleb, props);
+	g_variant_unref(props);
+
+	GList * children = dbusmenu_menuitem_get_children(mi);
+	if (children == NULL) {
+		GVariant * empty_children = _dbusmenu_empty_variant(DBUSMENU_EMPTY_CHILDREN);
+		g_variant_builder_add_value(&tupleb, empty_children);
+		g_variant_unref(empty_children);
+	} else {
+		GVariantBuilder childrenbuilder;
+		g_variant_builder_init(&childrenbuilder, G_VARIANT_TYPE_ARRAY);
+
+		for ( ; children != NULL; children = children->next) {
+			g_variant_builder_add_value(&childrenbuilder, g_variant_new_variant(snapshot_build(DBUSMENU_MENUITEM(children->data))));
+		}
+
+		g_variant_builder_add_value(&tupleb, g_variant_builder_end(&childrenbuilder));
+	}
+
+	return g_variant_builder_end(&tupleb);
+}
+
+/* Checks a property from a snapshot the way property_set_key()
+   would and puts it straight into the item.  Values that are the
+   default aren't kept, same as when they're set. */
+static gboolean
+snapshot_restore_prop (DbusmenuMenuitem * mi, GQuark key, const gchar * property, GVariant * value, GError ** error)
+{
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+	GVariant * default_value = NULL;
+	GVariantType * default_type = NULL;
+
+	dbusmenu_defaults_table_lookup(menuitem_get_defaults(mi), key, &default_value, &default_type);
+
+	if (default_type != NULL && !g_variant_is_of_type(value, default_type)) {
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+		            "Snapshot item %d has property '%s' of type '%s' instead of '%s'",
+		            dbusmenu_menuitem_get_id(mi), property,
+		            g_variant_get_type_string(value), g_variant_type_peek_string(default_type));
+		return FALSE;
+	}
+
+	if (default_value != NULL && g_variant_equal(default_value, value)) {
+		return TRUE;
+	}
+
+	GVariant * old = props_replace(priv, key, property, g_variant_ref(value));
+	if (old != NULL) {
+		g_variant_unref(old);
+	}
+
+	/* A new type has its own defaults */
+	if (key == prop_type_quark) {
+		priv->defaults_table = NULL;
+	}
+
+	return TRUE;
+}
+
+/* Builds an item and all of its children out of a snapshot node
+   without going through the property and child functions, so that
+   no signals get emitted.  The properties get the same checks as
+   when they're set and the dictionary they came from is kept as the
+   serialized copy of them if all of it was used.  Any ID that is
+   negative or already in @ids makes the whole snapshot bad. */
+static DbusmenuMenuitem *
+snapshot_restore (GVariant * node, GHashTable * ids, GError ** error)
+{
+	gint32 id = 0;
+	GVariant * props = NULL;
+	GVariant * children = NULL;
+	DbusmenuMenuitem * mi = NULL;
+
+	g_variant_get(node, "(i@a{sv}@av)", &id, &props, &children);
+
+	if (id < 0) {
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Snapshot has an item with ID %d", id);
+		goto out;
+	}
+
+	if (g_hash_table_contains(ids, GINT_TO_POINTER(id))) {
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Snapshot has more than one item with ID %d", id);
+		goto out;
+	}
+	g_hash_table_add(ids, GINT_TO_POINTER(id));
+
+	mi = dbusmenu_menuitem_new_with_id(id);
+	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
+
+	/* The type goes first as it picks the defaults for the others */
+	GVariant * value = g_variant_lookup_value(props, DBUSMENU_MENUITEM_PROP_TYPE, NULL);
+	if (value != NULL) {
+		gboolean restored = snapshot_restore_prop(mi, prop_type_quark, DBUSMENU_MENUITEM_PROP_TYPE, value, error);
+		g_variant_unref(value);
+		if (!restored) {
+			goto fail;
+		}
+	}
+
+	GVariantIter iter;
+	const gchar * name = NULL;
+	gsize nprops = 0;
+
+	g_variant_iter_init(&iter, props);
+	while (g_variant_iter_next(&iter, "{&sv}", &name, &value)) {
+		GQuark key = g_quark_try_string(name);
+		gboolean restored = TRUE;
+
+		if (key != prop_type_quark) {
+			restored = snapshot_restore_prop(mi, key, name, value, error);
+		}
+
+		g_variant_unref(value);
+		if (!restored) {
+			goto fail;
+		}
+		nprops++;
+	}
+
+	/* Only reuse the dictionary if every entry in it was kept */
+	if (nprops > 0 && props_count(priv) == nprops) {
+		priv->properties_variant = g_variant_ref(props);
+	}
+
+	gsize i;
+	for (i = 0; i < g_variant_n_children(children); i++) {
+		GVariant * child = g_variant_get_child_value(children, i);
+		GVariant * childnode = g_variant_get_variant(child);
+		DbusmenuMenuitem * childmi = NULL;
+
+		if (g_variant_is_of_type(childnode, G_VARIANT_TYPE("(ia{sv}av)"))) {
+			childmi = snapshot_restore(childnode, ids, error);
+		} else {
+			g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Snapshot child of %d has type '%s'", id, g_variant_get_type_string(childnode));
+		}
+
+		g_variant_unref(childnode);
+		g_variant_unref(child);
+
+		if (childmi == NULL) {
+			goto fail;
+		}
+
+		dbusmenu_menuitem_set_parent(childmi, mi);
+		children_link_insert(priv, g_list_prepend(NULL, childmi), G_MAXUINT);
+	}
+
+	goto out;
+
+fail:
+	g_object_unref(mi);
+	mi = NULL;
+
+out:
+	g_variant_unref(children);
+	g_variant_unref(props);
+
+	return mi;
+}
+
+/* Restores a whole snapshot from its root node */
+static DbusmenuMenuitem *
+snapshot_restore_tree (GVariant * root, GError ** error)
+{
+	GHashTable * ids = g_hash_table_new(g_direct_hash, g_direct_equal);
+	DbusmenuMenuitem * mi = snapshot_restore(root, ids, error);
+	g_hash_table_destroy(ids);
+	return mi;
+}
+
+/**
+ * dbusmenu_menuitem_snapshot:
+ * @mi: #DbusmenuMenuitem to take a snapshot of
+ *
+ * Puts @mi, all of its properties and all of its children into a
+ * single variant of the type "(ia{sv}av)".  It has the same shape as
+ * a layout but keeps the ID of every item, so that
+ * #dbusmenu_menuitem_new_from_snapshot can rebuild the same tree.
+ *
+ * Return value: (transfer full): A floating variant of the tree
+ */
+GVariant *
+dbusmenu_menuitem_snapshot (DbusmenuMenuitem * mi)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), NULL);
+
+	return snapshot_build(mi);
+}
+
+/**
+ * dbusmenu_menuitem_new_from_snapshot:
+ * @snapshot: A variant from #dbusmenu_menuitem_snapshot
+ *
+ * Builds a whole tree of menuitems out of @snapshot in one pass.
+ * No property or child signals are emitted while the tree is
+ * built, as nobody can be listening to it yet.
+ *
+ * Return value: (transfer full): The root of the new tree or %NULL
+ * 	if @snapshot doesn't have the right type, has an item with a
+ * 	negative or repeated ID or a property of the wrong type.
+ */
+DbusmenuMenuitem *
+dbusmenu_menuitem_new_from_snapshot (GVariant * snapshot)
+{
+	g_return_val_if_fail(snapshot != NULL, NULL);
+
+	g_variant_ref_sink(snapshot);
+
+	DbusmenuMenuitem * mi = NULL;
+	if (g_variant_is_of_type(snapshot, G_VARIANT_TYPE("(ia{sv}av)"))) {
+		GError * error = NULL;
+		mi = snapshot_restore_tree(snapshot, &error);
+		if (error != NULL) {
+			g_warning("Unable to build a menu from a snapshot: %s", error->message);
+			g_error_free(error);
+		}
+	} else {
+		g_warning("Snapshot has type '%s' instead of '(ia{sv}av)'", g_variant_get_type_string(snapshot));
+	}
+
+	g_variant_unref(snapshot);
+
+	return mi;
+}
+
+/**
+ * dbusmenu_menuitem_snapshot_save:
+ * @mi: #DbusmenuMenuitem to save
+ * @filename: File to write the snapshot to
+ * @error: Return location for a #GError or %NULL
+ *
+ * Writes a snapshot of @mi and all of its children to @filename
+ * as a binary #GVariant so that it can be loaded back quickly with
+ * #dbusmenu_menuitem_snapshot_load.
+ *
+ * Return value: Whether the file was written
+ */
+gboolean
+dbusmenu_menuitem_snapshot_save (DbusmenuMenuitem * mi, const gchar * filename, GError ** error)
+{
+	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), FALSE);
+	g_return_val_if_fail(filename != NULL, FALSE);
+
+	GVariant * file = g_variant_ref_sink(g_variant_new("(u@(ia{sv}av))", SNAPSHOT_VERSION, snapshot_build(mi)));
+
+	gboolean retval = g_file_set_contents(filename, g_variant_get_data(file), g_variant_get_size(file), error);
+
+	g_variant_unref(file);
+
+	return retval;
+}
+
+/**
+ * dbusmenu_menuitem_snapshot_load:
+ * @filename: File written by #dbusmenu_menuitem_snapshot_save
+ * @error: Return location for a #GError or %NULL
+ *
+ * Maps @filename and builds the tree of menuitems that is stored
+ * in it with #dbusmenu_menuitem_new_from_snapshot.  Files written on
+ * a machine with the other byte order are swapped on the way in.
+ *
+ * Return value: (transfer full): The root of the new tree or %NULL
+ * 	on error.
+ */
+DbusmenuMenuitem *
+dbusmenu_menuitem_snapshot_load (const gchar * filename, GError ** error)
+{
+	g_return_val_if_fail(filename != NULL, NULL);
+
+	GMappedFile * mapped = g_mapped_file_new(filename, FALSE, error);
+	if (mapped == NULL) {
+		return NULL;
+	}
+
+	GVariant * file = g_variant_ref_sink(g_variant_new_from_data(G_VARIANT_TYPE(SNAPSHOT_TYPE),
+	                                                             g_mapped_file_get_contents(mapped),
+	                                                             g_mapped_file_get_length(mapped),
+	                                                             FALSE,
+	                                                             (GDestroyNotify)g_mapped_file_unref,
+	                                                             mapped));
+
+	guint32 version = 0;
+	g_variant_get_child(file, 0, "u", &version);
+
+	if (version == GUINT32_SWAP_LE_BE(SNAPSHOT_VERSION)) {
+		GVariant * swapped = g_variant_ref_sink(g_variant_byteswap(file));
+		g_variant_unref(file);
+		file = swapped;
+		version = SNAPSHOT_VERSION;
+	}
+
+	DbusmenuMenuitem * mi = NULL;
+	if (version == SNAPSHOT_VERSION) {
+		GVariant * root = g_variant_get_child_value(file, 1);
+		mi = snapshot_restore_tree(root, error);
+		g_variant_unref(root);
+	} else {
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Snapshot '%s' has version %u instead of %u", filename, version, SNAPSHOT_VERSION);
+	}
+
+	g_variant_unref(file);
+
+	return mi;
+}
+
 typedef struct {
 	void (*func) (DbusmenuMenuitem * mi, gpointer data);
 	gpointer data;
@@ -1761,7 +2907,8 @@ dbusmenu_menuitem_handle_event (DbusmenuMenuitem * mi, const gchar * name, GVari
 
 	g_variant_ref_sink(variant);
 
-	g_signal_emit(G_OBJECT(mi), signals[EVENT], g_quark_from_string(name), name, variant, timestamp, &handled);
+	/* Anyone connected to the detail has interned it already */
+	g_signal_emit(G_OBJECT(mi), signals[EVENT], g_quark_try_string(name), name, variant, timestamp, &handled);
 
 	if (!handled && class->handle_event != NULL) {
 		class->handle_event(mi, name, variant, timestamp);
@@ -1814,6 +2961,7 @@ dbusmenu_menuitem_show_to_user (DbusmenuMenuitem * mi, guint timestamp)
 	g_return_if_fail(DBUSMENU_IS_MENUITEM(mi));
 
 	g_signal_emit(G_OBJECT(mi), signals[SHOW_TO_USER], 0, timestamp, TRUE);
+	OBSERVERS_CALL(mi, show_to_user, mi, timestamp);
 
 	return;
 }
@@ -1826,7 +2974,7 @@ dbusmenu_menuitem_property_is_default (DbusmenuMenuitem * mi, const gchar * prop
 	g_return_val_if_fail(DBUSMENU_IS_MENUITEM(mi), FALSE);
 	DbusmenuMenuitemPrivate * priv = DBUSMENU_MENUITEM_GET_PRIVATE(mi);
 
-	GVariant * currentval = (GVariant *)g_hash_table_lookup(priv->properties, property);
+	GVariant * currentval = props_lookup(priv, g_quark_try_string(property), property);
 	if (currentval != NULL) {
 		/* If we're storing it locally, then it shouldn't be a default */
 		return FALSE;
@@ -104,6 +104,12 @@ G_BEGIN_DECLS
  * String to attach to signal #DbusmenuServer::event
  */
 #define DBUSMENU_MENUITEM_SIGNAL_EVENT               "event"
+/**
+ * DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED:
+ *
+ * String to attach to signal #DbusmenuMenuitem::properties-changed
+ */
+#define DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED  "properties-changed"
 
 /* ***************************************** */
 /* *********  Menuitem Properties  ********* */
@@ -430,7 +436,7 @@ typedef GVariant * (*dbusmenu_menuitem_buildvariant_slot_t) (DbusmenuMenuitem *
  * @send_about_to_show: Virtual function that notifies server that the client is about to show a menu.
  * @show_to_user: Slot for #DbusmenuMenuitem::show-to-user.
  * @event: Slot for #DbsumenuMenuitem::event.
- * @reserved1: Reserved for future use.
+ * @properties_changed: Slot for #DbusmenuMenuitem::properties-changed.
  * @reserved2: Reserved for future use.
  * @reserved3: Reserved for future use.
  * @reserved4: Reserved for future use.
@@ -462,8 +468,9 @@ struct _DbusmenuMenuitemClass
 
 	void (*event) (const gchar * name, GVariant * value, guint timestamp);
 
+	void (*properties_changed) (const gchar ** properties);
+
 	/*< Private >*/
-	void (*reserved1) (void);
 	void (*reserved2) (void);
 	void (*reserved3) (void);
 	void (*reserved4) (void);
@@ -507,6 +514,7 @@ gboolean dbusmenu_menuitem_property_exist (const DbusmenuMenuitem * mi, const gc
 GList * dbusmenu_menuitem_properties_list (DbusmenuMenuitem * mi) G_GNUC_WARN_UNUSED_RESULT;
 GHashTable * dbusmenu_menuitem_properties_copy (DbusmenuMenuitem * mi);
 void dbusmenu_menuitem_property_remove (DbusmenuMenuitem * mi, const gchar * property);
+gboolean dbusmenu_menuitem_properties_set_many (DbusmenuMenuitem * mi, GVariant * properties);
 
 void dbusmenu_menuitem_set_root (DbusmenuMenuitem * mi, gboolean root);
 gboolean dbusmenu_menuitem_get_root (DbusmenuMenuitem * mi);
@@ -517,6 +525,11 @@ void dbusmenu_menuitem_send_about_to_show (DbusmenuMenuitem * mi, void (*cb) (Db
 
 void dbusmenu_menuitem_show_to_user (DbusmenuMenuitem * mi, guint timestamp);
 
+GVariant * dbusmenu_menuitem_snapshot (DbusmenuMenuitem * mi);
+DbusmenuMenuitem * dbusmenu_menuitem_new_from_snapshot (GVariant * snapshot);
+gboolean dbusmenu_menuitem_snapshot_save (DbusmenuMenuitem * mi, const gchar * filename, GError ** error);
+DbusmenuMenuitem * dbusmenu_menuitem_snapshot_load (const gchar * filename, GError ** error);
+
 /**
  * SECTION:menuitem
  * @short_description: A lowlevel represenation of a menuitem
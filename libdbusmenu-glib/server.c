@@ -40,10 +40,22 @@ License version 3 and version 2.1 along with this program.  If not, see
 
 #include "dbus-menu-clean.xml.h"
 
-static void layout_update_signal (DbusmenuServer * server);
+static void layout_update_signal (DbusmenuServer * server, DbusmenuMenuitem * parent);
 
 #define DBUSMENU_VERSION_NUMBER    3
 #define DBUSMENU_INTERFACE         "com.canonical.dbusmenu"
+#define DBUSMENU_STATS_INTERFACE   "com.canonical.dbusmenu.Stats"
+
+/* Optional features we tell clients about in Capabilities */
+#define DBUSMENU_CAPABILITY_PAGED_CHILDREN  "paged-children"
+
+/* The most GetLayout replies we'll hold on to before we
+   start over, clients don't tend to vary their requests */
+#define LAYOUT_CACHE_MAX           64
+
+/* Past this many edits in a single LayoutEdits signal it's
+   cheaper for the clients to just get the layout again */
+#define LAYOUT_EDITS_MAX           256
 
 /* Privates, I'll show you mine... */
 struct _DbusmenuServerPrivate
@@ -52,20 +64,47 @@ struct _DbusmenuServerPrivate
 	gchar * dbusobject;
 	gint layout_revision;
 	guint layout_idle;
+	DbusmenuMenuitem * layout_parent; /* Subtree changed since the last LayoutUpdated, NULL for everything */
+	gboolean layout_edits_enabled;
+	GPtrArray * layout_edits; /* GVariant * edits since the last LayoutUpdated */
+	gboolean layout_edits_broken; /* Something changed that can't be an edit */
 
 	GDBusConnection * bus;
 	guint find_server_signal;
 	GCancellable * bus_lookup;
 	guint dbus_registration;
+	guint stats_registration; /* Only with DBUSMENU_STATS set */
 
 	DbusmenuTextDirection text_direction;
 	DbusmenuStatus status;
 	GStrv icon_dirs;
 
-	GArray * prop_array;
+	GArray * prop_array; /* prop_idle_item_t, in order of first change */
+	GHashTable * prop_index; /* item ID -> position in prop_array + 1 */
 	guint property_idle;
+	gboolean property_after_layout; /* Properties wait for the layout idle to send its edits */
+
+	guint emit_interval; /* ms */
+	guint batch_latency; /* ms */
+	gint64 layout_last_emit;
+	gint64 property_last_emit;
+	guint layout_merged;
+	guint property_merged;
+
+	/* Counters for dbusmenu_server_get_stats() */
+	guint layout_calls;
+	guint64 layout_bytes;
+	guint group_calls;
+	guint property_signals;
+	guint property_entries;
+	guint property_coalesced;
 
 	GHashTable * lookup_cache;
+
+	GHashTable * layout_cache; /* DbusmenuMenuitem * -> (request key -> GVariant *) */
+	guint layout_cache_size;
+
+	GPtrArray * sources; /* source_t *, one per item with a data source */
 };
 
 #define DBUSMENU_SERVER_GET_PRIVATE(o) (DBUSMENU_SERVER(o)->priv)
@@ -89,7 +128,12 @@ enum {
 	PROP_VERSION,
 	PROP_TEXT_DIRECTION,
 	PROP_STATUS,
-	PROP_ICON_THEME_DIRS
+	PROP_ICON_THEME_DIRS,
+	PROP_EMIT_INTERVAL,
+	PROP_BATCH_LATENCY,
+	PROP_LAYOUT_MERGED,
+	PROP_PROPERTY_MERGED,
+	PROP_LAYOUT_EDITS
 };
 
 /* Errors */
@@ -121,6 +165,7 @@ enum {
 	METHOD_EVENT_GROUP,
 	METHOD_ABOUT_TO_SHOW,
 	METHOD_ABOUT_TO_SHOW_GROUP,
+	METHOD_GET_LAYOUT_PAGE,
 	/* Counter, do not remove! */
 	METHOD_COUNT
 };
@@ -158,26 +203,40 @@ static GVariant * bus_get_prop                (GDBusConnection * connection,
                                                const gchar * property,
                                                GError ** error,
                                                gpointer user_data);
+static GVariant * bus_get_stats_prop          (GDBusConnection * connection,
+                                               const gchar * sender,
+                                               const gchar * path,
+                                               const gchar * interface,
+                                               const gchar * property,
+                                               GError ** error,
+                                               gpointer user_data);
 static void       menuitem_property_changed   (DbusmenuMenuitem * mi,
-                                               gchar * property,
+                                               const gchar * property,
                                                GVariant * variant,
-                                               DbusmenuServer * server);
+                                               gpointer user_data);
 static void       menuitem_child_added        (DbusmenuMenuitem * parent,
                                                DbusmenuMenuitem * child,
                                                guint pos,
-                                               DbusmenuServer * server);
+                                               gpointer user_data);
 static void       menuitem_child_removed      (DbusmenuMenuitem * parent,
                                                DbusmenuMenuitem * child,
-                                               DbusmenuServer * server);
-static void       menuitem_signals_create     (DbusmenuMenuitem * mi,
-                                               gpointer data);
-static void       menuitem_signals_remove     (DbusmenuMenuitem * mi,
-                                               gpointer data);
+                                               gpointer user_data);
+static void       menuitem_child_moved        (DbusmenuMenuitem * parent,
+                                               DbusmenuMenuitem * child,
+                                               guint newpos,
+                                               guint oldpos,
+                                               gpointer user_data);
+static void       menuitem_shown              (DbusmenuMenuitem * mi,
+                                               guint timestamp,
+                                               gpointer user_data);
 static GQuark     error_quark                 (void);
-static void       prop_array_teardown         (GArray * prop_array);
+static void       prop_array_teardown         (DbusmenuServerPrivate * priv);
 static void       bus_get_layout              (DbusmenuServer * server,
                                                GVariant * params,
                                                GDBusMethodInvocation * invocation);
+static void       bus_get_layout_page         (DbusmenuServer * server,
+                                               GVariant * params,
+                                               GDBusMethodInvocation * invocation);
 static void       bus_get_group_properties    (DbusmenuServer * server,
                                                GVariant * params,
                                                GDBusMethodInvocation * invocation);
@@ -210,6 +269,12 @@ static void       find_servers_cb             (GDBusConnection * connection,
                                                GVariant * params,
                                                gpointer user_data);
 static gboolean   layout_update_idle          (gpointer user_data);
+static gboolean   menuitem_property_idle      (gpointer user_data);
+static guint      emit_schedule               (DbusmenuServer * server,
+                                               gint64 last_emit,
+                                               GSourceFunc func);
+static void       layout_update_emit          (DbusmenuServer * server,
+                                               gint parent);
 
 /* Globals */
 static GDBusNodeInfo *            dbusmenu_node_info = NULL;
@@ -219,7 +284,20 @@ static const GDBusInterfaceVTable dbusmenu_interface_table = {
 	.get_property = bus_get_prop,
 	.set_property = NULL /* No properties that can be set */
 };
+static GDBusInterfaceInfo *       dbusmenu_stats_info = NULL;
+static const GDBusInterfaceVTable dbusmenu_stats_table = {
+	.method_call  = NULL,
+	.get_property = bus_get_stats_prop,
+	.set_property = NULL
+};
 static method_table_t             dbusmenu_method_table[METHOD_COUNT];
+static const DbusmenuMenuitemObserver menuitem_observer = {
+	.property_changed = menuitem_property_changed,
+	.child_added      = menuitem_child_added,
+	.child_removed    = menuitem_child_removed,
+	.child_moved      = menuitem_child_moved,
+	.show_to_user     = menuitem_shown
+};
 
 G_DEFINE_TYPE (DbusmenuServer, dbusmenu_server, G_TYPE_OBJECT);
 
@@ -328,6 +406,31 @@ dbusmenu_server_class_init (DbusmenuServerClass *class)
 	                                              "Exports over DBus whether the menus should be given special visuals",
 	                                              DBUSMENU_TYPE_STATUS, DBUSMENU_STATUS_NORMAL,
 	                                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_EMIT_INTERVAL,
+	                                 g_param_spec_uint(DBUSMENU_SERVER_PROP_EMIT_INTERVAL, "Minimum emission interval",
+	                                              "The shortest time, in milliseconds, between two layout or two property update signals",
+	                                              0, G_MAXUINT, 0,
+	                                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_BATCH_LATENCY,
+	                                 g_param_spec_uint(DBUSMENU_SERVER_PROP_BATCH_LATENCY, "Maximum batch latency",
+	                                              "The longest time, in milliseconds, a change is held back to be batched, zero for no limit",
+	                                              0, G_MAXUINT, 0,
+	                                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_LAYOUT_MERGED,
+	                                 g_param_spec_uint(DBUSMENU_SERVER_PROP_LAYOUT_MERGED, "Merged layout updates",
+	                                              "The number of layout changes that were folded into an already pending signal",
+	                                              0, G_MAXUINT, 0,
+	                                              G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_PROPERTY_MERGED,
+	                                 g_param_spec_uint(DBUSMENU_SERVER_PROP_PROPERTY_MERGED, "Merged property updates",
+	                                              "The number of property changes that were folded into an already pending signal",
+	                                              0, G_MAXUINT, 0,
+	                                              G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+	g_object_class_install_property (object_class, PROP_LAYOUT_EDITS,
+	                                 g_param_spec_boolean(DBUSMENU_SERVER_PROP_LAYOUT_EDITS, "Send layout edits",
+	                                              "Send the LayoutEdits signal so clients can update their layout without getting it again",
+	                                              FALSE,
+	                                              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
 	if (dbusmenu_node_info == NULL) {
 		GError * error = NULL;
@@ -347,6 +450,14 @@ dbusmenu_server_class_init (DbusmenuServerClass *class)
 		}
 	}
 
+	if (dbusmenu_stats_info == NULL) {
+		dbusmenu_stats_info = g_dbus_node_info_lookup_interface(dbusmenu_node_info, DBUSMENU_STATS_INTERFACE);
+
+		if (dbusmenu_stats_info == NULL) {
+			g_error("Unable to find interface '" DBUSMENU_STATS_INTERFACE "'");
+		}
+	}
+
 	/* Building our Method table :( */
 	dbusmenu_method_table[METHOD_GET_LAYOUT].interned_name = g_intern_static_string("GetLayout");
 	dbusmenu_method_table[METHOD_GET_LAYOUT].func          = bus_get_layout;
@@ -375,6 +486,9 @@ dbusmenu_server_class_init (DbusmenuServerClass *class)
 	dbusmenu_method_table[METHOD_ABOUT_TO_SHOW_GROUP].interned_name = g_intern_static_string("AboutToShowGroup");
 	dbusmenu_method_table[METHOD_ABOUT_TO_SHOW_GROUP].func          = bus_about_to_show_group;
 
+	dbusmenu_method_table[METHOD_GET_LAYOUT_PAGE].interned_name = g_intern_static_string("GetLayoutPage");
+	dbusmenu_method_table[METHOD_GET_LAYOUT_PAGE].func          = bus_get_layout_page;
+
 	return;
 }
 
@@ -389,13 +503,36 @@ dbusmenu_server_init (DbusmenuServer *self)
 	priv->dbusobject = NULL;
 	priv->layout_revision = 1;
 	priv->layout_idle = 0;
+	priv->layout_parent = NULL;
+	priv->layout_edits_enabled = FALSE;
+	priv->layout_edits = NULL;
+	priv->layout_edits_broken = FALSE;
+	priv->emit_interval = 0;
+	priv->batch_latency = 0;
+	priv->layout_last_emit = 0;
+	priv->property_last_emit = 0;
+	priv->property_after_layout = FALSE;
+	priv->layout_merged = 0;
+	priv->property_merged = 0;
+	priv->layout_calls = 0;
+	priv->layout_bytes = 0;
+	priv->group_calls = 0;
+	priv->property_signals = 0;
+	priv->property_entries = 0;
+	priv->property_coalesced = 0;
 	priv->bus = NULL;
 	priv->bus_lookup = NULL;
 	priv->find_server_signal = 0;
 	priv->dbus_registration = 0;
+	priv->stats_registration = 0;
 
 	priv->lookup_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_object_unref);
 
+	priv->layout_cache = g_hash_table_new_full(g_direct_hash, g_direct_equal, g_object_unref, (GDestroyNotify)g_hash_table_destroy);
+	priv->layout_cache_size = 0;
+
+	priv->sources = NULL;
+
 	default_text_direction(self);
 	priv->status = DBUSMENU_STATUS_NORMAL;
 	priv->icon_dirs = NULL;
@@ -412,19 +549,37 @@ dbusmenu_server_dispose (GObject *object)
 		g_source_remove(priv->layout_idle);
 		priv->layout_idle = 0;
 	}
+
+	if (priv->layout_parent != NULL) {
+		g_object_unref(priv->layout_parent);
+		priv->layout_parent = NULL;
+	}
 	
 	if (priv->property_idle != 0) {
 		g_source_remove(priv->property_idle);
 		priv->property_idle = 0;
 	}
 
-	if (priv->prop_array != NULL) {
-		prop_array_teardown(priv->prop_array);
-		priv->prop_array = NULL;
+	prop_array_teardown(priv);
+
+	if (priv->layout_edits != NULL) {
+		g_ptr_array_free(priv->layout_edits, TRUE);
+		priv->layout_edits = NULL;
+	}
+
+	if (priv->layout_cache != NULL) {
+		g_hash_table_destroy(priv->layout_cache);
+		priv->layout_cache = NULL;
+		priv->layout_cache_size = 0;
+	}
+
+	if (priv->sources != NULL) {
+		g_ptr_array_free(priv->sources, TRUE);
+		priv->sources = NULL;
 	}
 
 	if (priv->root != NULL) {
-		dbusmenu_menuitem_foreach(priv->root, menuitem_signals_remove, object);
+		_dbusmenu_menuitem_remove_observer(priv->root, &menuitem_observer, object);
 		g_object_unref(priv->root);
 	}
 
@@ -433,6 +588,11 @@ dbusmenu_server_dispose (GObject *object)
 		priv->dbus_registration = 0;
 	}
 
+	if (priv->stats_registration != 0) {
+		g_dbus_connection_unregister_object(priv->bus, priv->stats_registration);
+		priv->stats_registration = 0;
+	}
+
 	if (priv->find_server_signal != 0) {
 		g_dbus_connection_signal_unsubscribe(priv->bus, priv->find_server_signal);
 		priv->find_server_signal = 0;
@@ -517,6 +677,298 @@ cache_add_entries_for_menuitem (GHashTable * cache, DbusmenuMenuitem * item)
 	}
 }
 
+/* Builds the key for the layout cache out of the parts of a
+   GetLayout request that change what gets sent back */
+static gchar *
+layout_cache_key (gint recurse, const gchar ** props)
+{
+	GString * key = g_string_new(NULL);
+	g_string_printf(key, "%d", recurse < 0 ? -1 : recurse);
+
+	if (props != NULL) {
+		gint i;
+		for (i = 0; props[i] != NULL; i++) {
+			g_string_append_c(key, '\n');
+			g_string_append(key, props[i]);
+		}
+	}
+
+	return g_string_free(key, FALSE);
+}
+
+/* Look for a layout we've already built for this request.  Returns
+   a reference or NULL if we need to build it. */
+static GVariant *
+layout_cache_lookup (DbusmenuServer * server, DbusmenuMenuitem * mi, gint recurse, const gchar ** props)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	GHashTable * requests = g_hash_table_lookup(priv->layout_cache, mi);
+	if (requests == NULL) {
+		return NULL;
+	}
+
+	gchar * key = layout_cache_key(recurse, props);
+	GVariant * layout = g_hash_table_lookup(requests, key);
+	g_free(key);
+
+	if (layout == NULL) {
+		return NULL;
+	}
+
+	return g_variant_ref(layout);
+}
+
+/* Hold on to a layout so the next request like it can reuse it */
+static void
+layout_cache_store (DbusmenuServer * server, DbusmenuMenuitem * mi, gint recurse, const gchar ** props, GVariant * layout)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	if (priv->layout_cache_size >= LAYOUT_CACHE_MAX) {
+		g_hash_table_remove_all(priv->layout_cache);
+		priv->layout_cache_size = 0;
+	}
+
+	GHashTable * requests = g_hash_table_lookup(priv->layout_cache, mi);
+	if (requests == NULL) {
+		requests = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+		g_hash_table_insert(priv->layout_cache, g_object_ref(mi), requests);
+	}
+
+	/* Only count it if it's new and not replacing a layout for
+	   the same request */
+	guint before = g_hash_table_size(requests);
+	g_hash_table_insert(requests, layout_cache_key(recurse, props), g_variant_ref(layout));
+	priv->layout_cache_size += g_hash_table_size(requests) - before;
+
+	return;
+}
+
+/* Drop all the layouts that are built from a single item */
+static void
+layout_cache_remove (DbusmenuServer * server, DbusmenuMenuitem * mi)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	GHashTable * requests = g_hash_table_lookup(priv->layout_cache, mi);
+	if (requests == NULL) {
+		return;
+	}
+
+	priv->layout_cache_size -= MIN(priv->layout_cache_size, g_hash_table_size(requests));
+	g_hash_table_remove(priv->layout_cache, mi);
+
+	return;
+}
+
+/* Something about @mi changed, so any layout that includes it,
+   which is anything built from it or one of its parents, is
+   no longer valid. */
+static void
+layout_cache_invalidate (DbusmenuServer * server, DbusmenuMenuitem * mi)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	if (priv->layout_cache_size == 0) {
+		return;
+	}
+
+	for ( ; mi != NULL; mi = dbusmenu_menuitem_get_parent(mi)) {
+		layout_cache_remove(server, mi);
+	}
+
+	return;
+}
+
+/* Drop the layouts built from any item in a subtree that is
+   leaving our tree.  We won't hear about changes to it anymore. */
+static void
+layout_cache_remove_subtree (DbusmenuServer * server, DbusmenuMenuitem * mi)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	if (priv->layout_cache_size == 0) {
+		return;
+	}
+
+	layout_cache_remove(server, mi);
+
+	GList * child;
+	for (child = dbusmenu_menuitem_get_children(mi); child != NULL; child = child->next) {
+		layout_cache_remove_subtree(server, DBUSMENU_MENUITEM(child->data));
+	}
+
+	return;
+}
+
+/* The data source for the children of an item */
+typedef struct _source_t source_t;
+struct _source_t {
+	DbusmenuServer * server;
+	DbusmenuMenuitem * parent; /* weak */
+	DbusmenuServerSource funcs;
+	gpointer user_data;
+	GDestroyNotify destroy;
+};
+
+/* The item the source was on is gone, so nothing can ask for
+   its children anymore.  Moving the item around the tree keeps
+   it, only this or dbusmenu_server_set_source() drop a source. */
+static void
+source_parent_gone (gpointer data, GObject * where_the_object_was)
+{
+	source_t * source = (source_t *)data;
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(source->server);
+
+	source->parent = NULL;
+	g_ptr_array_remove_fast(priv->sources, source);
+
+	return;
+}
+
+/* Puts the parent back to using its menuitems and lets
+   go of the user data */
+static void
+source_free (gpointer data)
+{
+	source_t * source = (source_t *)data;
+
+	if (source->parent != NULL) {
+		_dbusmenu_menuitem_set_build_children(source->parent, NULL, NULL);
+		g_object_weak_unref(G_OBJECT(source->parent), source_parent_gone, source);
+	}
+
+	if (source->destroy != NULL) {
+		source->destroy(source->user_data);
+	}
+
+	g_free(source);
+	return;
+}
+
+/* Finds the source for the children of @mi, if there is one */
+static source_t *
+source_find (DbusmenuServer * server, DbusmenuMenuitem * mi, guint * position)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+	guint i;
+
+	if (priv->sources == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < priv->sources->len; i++) {
+		source_t * source = g_ptr_array_index(priv->sources, i);
+		if (source->parent == mi) {
+			if (position != NULL) {
+				*position = i;
+			}
+			return source;
+		}
+	}
+
+	return NULL;
+}
+
+/* Finds the source that has an item with @id and where that item
+   is in it.  Only sources under an item in our tree count. */
+static source_t *
+source_lookup (DbusmenuServer * server, gint id, guint * index)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+	guint i;
+
+	if (priv->sources == NULL) {
+		return NULL;
+	}
+
+	for (i = 0; i < priv->sources->len; i++) {
+		source_t * source = g_ptr_array_index(priv->sources, i);
+		gint found = source->funcs.lookup_id(id, source->user_data);
+
+		if (found < 0) {
+			continue;
+		}
+
+		gint parentid = dbusmenu_menuitem_get_id(source->parent);
+		if (source->parent != priv->root && lookup_menuitem_by_id(server, parentid) != source->parent) {
+			continue;
+		}
+
+		*index = found;
+		return source;
+	}
+
+	return NULL;
+}
+
+/* Gets the properties of the item at @index, only the ones in
+   @props if there are any.  Returns a full reference. */
+static GVariant *
+source_properties (source_t * source, guint index, const gchar ** props)
+{
+	GVariant * all = source->funcs.get_properties(index, source->user_data);
+	if (all == NULL) {
+		return _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
+	}
+	/* Sinks a floating one, takes over a full reference */
+	all = g_variant_take_ref(all);
+
+	if (props == NULL || props[0] == NULL) {
+		return all;
+	}
+
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+	gint i;
+	for (i = 0; props[i] != NULL; i++) {
+		GVariant * value = g_variant_lookup_value(all, props[i], NULL);
+		if (value != NULL) {
+			g_variant_builder_add(&builder, "{sv}", props[i], value);
+			g_variant_unref(value);
+		}
+	}
+
+	g_variant_unref(all);
+	return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
+
+/* Builds the "(ia{sv}av)" layout of the item at @index, they
+   never have children of their own */
+static GVariant *
+source_build_item (source_t * source, guint index, const gchar ** props)
+{
+	GVariant * tuple[3];
+
+	tuple[0] = g_variant_new_int32(source->funcs.get_id(index, source->user_data));
+	tuple[1] = source_properties(source, index, props);
+	tuple[2] = _dbusmenu_empty_variant(DBUSMENU_EMPTY_CHILDREN);
+
+	GVariant * layout = g_variant_new_tuple(tuple, 3);
+
+	g_variant_unref(tuple[1]);
+	g_variant_unref(tuple[2]);
+
+	return layout;
+}
+
+/* Puts the items of the source in the layout of its parent */
+static void
+source_build_children (DbusmenuMenuitem * mi, GVariantBuilder * children, const gchar ** properties, gpointer user_data)
+{
+	source_t * source = (source_t *)user_data;
+	guint count = source->funcs.get_n_items(source->user_data);
+	guint i;
+
+	for (i = 0; i < count; i++) {
+		g_variant_builder_add_value(children, g_variant_new_variant(source_build_item(source, i, properties)));
+	}
+
+	return;
+}
+
 static void
 set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 {
@@ -540,8 +992,13 @@ set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 		}
 		break;
 	case PROP_ROOT_NODE:
+		if (priv->layout_cache != NULL) {
+			g_hash_table_remove_all(priv->layout_cache);
+			priv->layout_cache_size = 0;
+		}
+
 		if (priv->root != NULL) {
-			dbusmenu_menuitem_foreach(priv->root, menuitem_signals_remove, obj);
+			_dbusmenu_menuitem_remove_observer(priv->root, &menuitem_observer, obj);
 			dbusmenu_menuitem_set_root(priv->root, FALSE);
 			cache_remove_entries_for_menuitem(priv->lookup_cache, priv->root);
 
@@ -549,7 +1006,7 @@ set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 			GList * iter;
 			for (iter = properties; iter != NULL; iter = g_list_next(iter)) {
 				gchar * property = (gchar *)iter->data;
-				menuitem_property_changed(priv->root, property, NULL, DBUSMENU_SERVER(obj));
+				menuitem_property_changed(priv->root, property, NULL, obj);
 			}
 			g_list_free(properties);
 
@@ -561,19 +1018,19 @@ set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 			g_object_ref(G_OBJECT(priv->root));
 			cache_add_entries_for_menuitem(priv->lookup_cache, priv->root);
 			dbusmenu_menuitem_set_root(priv->root, TRUE);
-			dbusmenu_menuitem_foreach(priv->root, menuitem_signals_create, obj);
+			_dbusmenu_menuitem_add_observer(priv->root, &menuitem_observer, obj);
 
 			GList * properties = dbusmenu_menuitem_properties_list(priv->root);
 			GList * iter;
 			for (iter = properties; iter != NULL; iter = g_list_next(iter)) {
 				gchar * property = (gchar *)iter->data;
-				menuitem_property_changed(priv->root, property, dbusmenu_menuitem_property_get_variant(priv->root, property), DBUSMENU_SERVER(obj));
+				menuitem_property_changed(priv->root, property, dbusmenu_menuitem_property_get_variant(priv->root, property), obj);
 			}
 			g_list_free(properties);
 		} else {
 			g_debug("Setting root node to NULL");
 		}
-		layout_update_signal(DBUSMENU_SERVER(obj));
+		layout_update_signal(DBUSMENU_SERVER(obj), NULL);
 		break;
 	case PROP_TEXT_DIRECTION: {
 		DbusmenuTextDirection indir = g_value_get_enum(value);
@@ -633,6 +1090,19 @@ set_property (GObject * obj, guint id, const GValue * value, GParamSpec * pspec)
 		priv->status = instatus;
 		break;
 	}
+	case PROP_EMIT_INTERVAL:
+		priv->emit_interval = g_value_get_uint(value);
+		break;
+	case PROP_BATCH_LATENCY:
+		priv->batch_latency = g_value_get_uint(value);
+		break;
+	case PROP_LAYOUT_EDITS:
+		priv->layout_edits_enabled = g_value_get_boolean(value);
+		/* Anything pending was never recorded */
+		if (priv->layout_idle != 0) {
+			priv->layout_edits_broken = TRUE;
+		}
+		break;
 	default:
 		g_return_if_reached();
 		break;
@@ -662,6 +1132,21 @@ get_property (GObject * obj, guint id, GValue * value, GParamSpec * pspec)
 	case PROP_STATUS:
 		g_value_set_enum(value, priv->status);
 		break;
+	case PROP_EMIT_INTERVAL:
+		g_value_set_uint(value, priv->emit_interval);
+		break;
+	case PROP_BATCH_LATENCY:
+		g_value_set_uint(value, priv->batch_latency);
+		break;
+	case PROP_LAYOUT_MERGED:
+		g_value_set_uint(value, priv->layout_merged);
+		break;
+	case PROP_PROPERTY_MERGED:
+		g_value_set_uint(value, priv->property_merged);
+		break;
+	case PROP_LAYOUT_EDITS:
+		g_value_set_boolean(value, priv->layout_edits_enabled);
+		break;
 	default:
 		g_return_if_reached();
 		break;
@@ -734,6 +1219,11 @@ register_object (DbusmenuServer * server)
 		priv->dbus_registration = 0;
 	}
 
+	if (priv->stats_registration != 0) {
+		g_dbus_connection_unregister_object(priv->bus, priv->stats_registration);
+		priv->stats_registration = 0;
+	}
+
 	GError * error = NULL;
 	priv->dbus_registration = g_dbus_connection_register_object(priv->bus,
 	                                                            priv->dbusobject,
@@ -749,18 +1239,25 @@ register_object (DbusmenuServer * server)
 		return;
 	}
 
-	/* If we've got it registered let's tell everyone about it */
-	g_signal_emit(G_OBJECT(server), signals[LAYOUT_UPDATED], 0, priv->layout_revision, 0, TRUE);
-	if (priv->dbusobject != NULL && priv->bus != NULL) {
-		g_dbus_connection_emit_signal(priv->bus,
-		                              NULL,
-		                              priv->dbusobject,
-		                              DBUSMENU_INTERFACE,
-		                              "LayoutUpdated",
-		                              g_variant_new("(ui)", priv->layout_revision, 0),
-		                              NULL);
+	/* Only for debugging, so it has to be asked for */
+	if (g_getenv("DBUSMENU_STATS") != NULL) {
+		priv->stats_registration = g_dbus_connection_register_object(priv->bus,
+		                                                             priv->dbusobject,
+		                                                             dbusmenu_stats_info,
+		                                                             &dbusmenu_stats_table,
+		                                                             server,
+		                                                             NULL,
+		                                                             &error);
+
+		if (error != NULL) {
+			g_warning("Unable to register stats on bus: %s", error->message);
+			g_error_free(error);
+		}
 	}
 
+	/* If we've got it registered let's tell everyone about it */
+	layout_update_emit(server, 0);
+
 	return;
 }
 
@@ -808,7 +1305,7 @@ bus_got_cb (GObject * obj, GAsyncResult * result, gpointer user_data)
 static void
 find_servers_cb (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
 {
-	layout_update_idle(user_data);
+	layout_update_emit(DBUSMENU_SERVER(user_data), 0);
 	return;
 }
 
@@ -869,6 +1366,9 @@ bus_get_prop (GDBusConnection * connection, const gchar * sender, const gchar *
 		return dirs;
 	} else if (g_strcmp0(property, "Status") == 0) {
 		return g_variant_new_string(dbusmenu_status_get_nick(priv->status));
+	} else if (g_strcmp0(property, "Capabilities") == 0) {
+		const gchar * capabilities[] = { DBUSMENU_CAPABILITY_PAGED_CHILDREN, NULL };
+		return g_variant_new_strv(capabilities, -1);
 	} else {
 		g_warning("Unknown property '%s'", property);
 	}
@@ -876,85 +1376,403 @@ bus_get_prop (GDBusConnection * connection, const gchar * sender, const gchar *
 	return NULL;
 }
 
-/* Handle actually signalling in the idle loop.  This way we collect all
-   the updates. */
-static gboolean
-layout_update_idle (gpointer user_data)
+/* The only property of the stats interface, the same dictionary
+   that dbusmenu_server_get_stats() returns */
+static GVariant *
+bus_get_stats_prop (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * property, GError ** error, gpointer user_data)
+{
+	g_return_val_if_fail(g_strcmp0(interface, DBUSMENU_STATS_INTERFACE) == 0, NULL);
+
+	if (g_strcmp0(property, "Stats") != 0) {
+		g_warning("Unknown property '%s'", property);
+		return NULL;
+	}
+
+	/* GDBus takes the reference we return */
+	return dbusmenu_server_get_stats(DBUSMENU_SERVER(user_data));
+}
+
+/* Sends out the layout updated signal, both locally and on
+   the bus, for the subtree under @parent */
+static void
+layout_update_emit (DbusmenuServer * server, gint parent)
 {
-	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
 	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
 
-	g_signal_emit(G_OBJECT(server), signals[LAYOUT_UPDATED], 0, priv->layout_revision, 0, TRUE);
+	g_signal_emit(G_OBJECT(server), signals[LAYOUT_UPDATED], 0, priv->layout_revision, parent, TRUE);
 	if (priv->dbusobject != NULL && priv->bus != NULL) {
 		g_dbus_connection_emit_signal(priv->bus,
 		                              NULL,
 		                              priv->dbusobject,
 		                              DBUSMENU_INTERFACE,
 		                              "LayoutUpdated",
-		                              g_variant_new("(ui)", priv->layout_revision, 0),
+		                              g_variant_new("(ui)", priv->layout_revision, parent),
 		                              NULL);
 	}
 
-	priv->layout_idle = 0;
-
-	return FALSE;
+	return;
 }
 
-/* Signals that the layout has been updated */
+/* Sends the edits that have been made since the last LayoutUpdated
+   signal so that clients can skip calling GetLayout.  This always
+   goes out right before the LayoutUpdated for the same revision. */
 static void
-layout_update_signal (DbusmenuServer * server)
+layout_edits_emit (DbusmenuServer * server)
 {
 	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
-	priv->layout_revision++;
+	GPtrArray * edits = priv->layout_edits;
+	gboolean broken = priv->layout_edits_broken;
 
-	if (priv->layout_idle == 0) {
-		priv->layout_idle = g_idle_add(layout_update_idle, server);
+	priv->layout_edits = NULL;
+	priv->layout_edits_broken = FALSE;
+
+	if (edits == NULL) {
+		return;
 	}
 
-	return;
-}
+	if (!broken && edits->len > 0 && priv->dbusobject != NULL && priv->bus != NULL) {
+		g_dbus_connection_emit_signal(priv->bus,
+		                              NULL,
+		                              priv->dbusobject,
+		                              DBUSMENU_INTERFACE,
+		                              "LayoutEdits",
+		                              g_variant_new("(u@a(uiiiiv))", priv->layout_revision,
+		                                            g_variant_new_array(G_VARIANT_TYPE("(uiiiiv)"), (GVariant **)edits->pdata, edits->len)),
+		                              NULL);
+	}
 
-typedef struct _prop_idle_item_t prop_idle_item_t;
-struct _prop_idle_item_t {
-	DbusmenuMenuitem * mi;
-	GArray * array;
-};
+	g_ptr_array_free(edits, TRUE);
 
-typedef struct _prop_idle_prop_t prop_idle_prop_t;
-struct _prop_idle_prop_t {
-	gchar * property;
-	GVariant * variant;
-};
+	return;
+}
 
-/* Takes appart our data structure so we don't leak any
-   memory or references. */
+/* Records a change to the children of @parent as an edit for the
+   revision that the change has just moved us to.  Inserts carry
+   the whole subtree as it is now, later changes to it come as
+   their own edits or property updates. */
 static void
-prop_array_teardown (GArray * prop_array)
+layout_edits_record (DbusmenuServer * server, DbusmenuLayoutEdit op, DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint position)
 {
-	int i, j;
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
 
-	for (i = 0; i < prop_array->len; i++) {
-		prop_idle_item_t * iitem = &g_array_index(prop_array, prop_idle_item_t, i);
-		
-		for (j = 0; j < iitem->array->len; j++) {
-			prop_idle_prop_t * iprop = &g_array_index(iitem->array, prop_idle_prop_t, j);
+	if (!priv->layout_edits_enabled || priv->layout_edits_broken) {
+		return;
+	}
 
-			g_free(iprop->property);
+	if (priv->layout_edits == NULL) {
+		priv->layout_edits = g_ptr_array_new_with_free_func((GDestroyNotify)g_variant_unref);
+	}
 
-			if (iprop->variant != NULL) {
-				g_variant_unref(iprop->variant);
+	if (priv->layout_edits->len >= LAYOUT_EDITS_MAX) {
+		priv->layout_edits_broken = TRUE;
+		return;
+	}
+
+	GVariant * layout = NULL;
+	if (op == DBUSMENU_LAYOUT_EDIT_INSERT) {
+		layout = dbusmenu_menuitem_build_variant(child, NULL, -1);
+	} else {
+		layout = g_variant_new_tuple(NULL, 0);
+	}
+
+	gint parentid = dbusmenu_menuitem_get_root(parent) ? 0 : dbusmenu_menuitem_get_id(parent);
+
+	GVariant * edit = g_variant_new("(uiiiiv)",
+	                                priv->layout_revision,
+	                                op,
+	                                dbusmenu_menuitem_get_id(child),
+	                                parentid,
+	                                position,
+	                                layout);
+	g_ptr_array_add(priv->layout_edits, g_variant_ref_sink(edit));
+
+	return;
+}
+
+/* Handle actually signalling in the idle loop.  This way we collect all
+   the updates. */
+static gboolean
+layout_update_idle (gpointer user_data)
+{
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	/* Only report a subtree if it's still in our tree, otherwise
+	   the whole layout needs to be looked at again. */
+	gint parent = 0;
+	if (priv->layout_parent != NULL) {
+		if (priv->layout_parent != priv->root &&
+				lookup_menuitem_by_id(server, dbusmenu_menuitem_get_id(priv->layout_parent)) == priv->layout_parent) {
+			parent = dbusmenu_menuitem_get_id(priv->layout_parent);
+		}
+
+		g_object_unref(priv->layout_parent);
+		priv->layout_parent = NULL;
+	}
+
+	priv->layout_idle = 0;
+	priv->layout_last_emit = g_get_monotonic_time();
+
+	layout_edits_emit(server);
+	layout_update_emit(server, parent);
+
+	/* The properties that were waiting on the edits can go now */
+	if (priv->property_after_layout) {
+		priv->property_after_layout = FALSE;
+		priv->property_idle = emit_schedule(server, priv->property_last_emit, menuitem_property_idle);
+	}
+
+	return FALSE;
+}
+
+/* Queues @func to send a signal that was last sent at @last_emit.
+   It runs on the next idle unless that would be inside the emission
+   interval, in which case it waits for the interval to end, but never
+   longer than the batch latency. */
+static guint
+emit_schedule (DbusmenuServer * server, gint64 last_emit, GSourceFunc func)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+	gint64 delay = 0;
+
+	if (priv->emit_interval != 0 && last_emit != 0) {
+		delay = last_emit + (gint64)priv->emit_interval * 1000 - g_get_monotonic_time();
+	}
+
+	if (priv->batch_latency != 0) {
+		delay = MIN(delay, (gint64)priv->batch_latency * 1000);
+	}
+
+	if (delay <= 0) {
+		return g_idle_add(func, server);
+	}
+
+	/* Round up so we don't wake just before the interval ends */
+	return g_timeout_add((delay + 999) / 1000, func, server);
+}
+
+/* Finds the closest item that both @one and @two are under, or
+   NULL if they're not in the same tree. */
+static DbusmenuMenuitem *
+layout_common_parent (DbusmenuMenuitem * one, DbusmenuMenuitem * two)
+{
+	guint onedepth = 0, twodepth = 0;
+	DbusmenuMenuitem * iter;
+
+	for (iter = one; iter != NULL; iter = dbusmenu_menuitem_get_parent(iter)) {
+		onedepth++;
+	}
+	for (iter = two; iter != NULL; iter = dbusmenu_menuitem_get_parent(iter)) {
+		twodepth++;
+	}
+
+	while (onedepth > twodepth) {
+		one = dbusmenu_menuitem_get_parent(one);
+		onedepth--;
+	}
+	while (twodepth > onedepth) {
+		two = dbusmenu_menuitem_get_parent(two);
+		twodepth--;
+	}
+
+	while (one != two) {
+		one = dbusmenu_menuitem_get_parent(one);
+		two = dbusmenu_menuitem_get_parent(two);
+	}
+
+	return one;
+}
+
+/* Signals that the layout has been updated.  @parent is the item
+   whose children changed, or NULL if the whole tree should be
+   considered changed.  Changes that happen before the idle runs
+   are reported as the smallest subtree covering all of them. */
+static void
+layout_update_signal (DbusmenuServer * server, DbusmenuMenuitem * parent)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+	priv->layout_revision++;
+
+	/* Changes to the whole tree can't be sent as edits */
+	if (parent == NULL) {
+		priv->layout_edits_broken = TRUE;
+	}
+
+	if (priv->layout_idle == 0) {
+		if (parent != NULL) {
+			priv->layout_parent = g_object_ref(parent);
+		}
+		priv->layout_idle = emit_schedule(server, priv->layout_last_emit, layout_update_idle);
+		return;
+	}
+
+	priv->layout_merged++;
+
+	if (priv->layout_parent != NULL) {
+		DbusmenuMenuitem * common = NULL;
+		if (parent != NULL) {
+			common = layout_common_parent(priv->layout_parent, parent);
+		}
+
+		if (common != priv->layout_parent) {
+			if (common != NULL) {
+				g_object_ref(common);
 			}
+			g_object_unref(priv->layout_parent);
+			priv->layout_parent = common;
 		}
+	}
+
+	return;
+}
+
+/* Past this many properties on a single item we stop scanning
+   the array and build a quark index for it instead. */
+#define PROP_IDLE_SCAN_MAX 8
+
+typedef struct _prop_idle_item_t prop_idle_item_t;
+struct _prop_idle_item_t {
+	DbusmenuMenuitem * mi;
+	GArray * array;
+	GHashTable * index; /* property quark -> position in array + 1 */
+};
+
+typedef struct _prop_idle_prop_t prop_idle_prop_t;
+struct _prop_idle_prop_t {
+	GQuark property;
+	GVariant * variant;
+};
 
+/* Drops the pending values of @iitem and its index, leaving it
+   with an empty array */
+static void
+prop_item_clear (prop_idle_item_t * iitem)
+{
+	int j;
+
+	for (j = 0; j < iitem->array->len; j++) {
+		prop_idle_prop_t * iprop = &g_array_index(iitem->array, prop_idle_prop_t, j);
+
+		if (iprop->variant != NULL) {
+			g_variant_unref(iprop->variant);
+		}
+	}
+	g_array_set_size(iitem->array, 0);
+
+	if (iitem->index != NULL) {
+		g_hash_table_destroy(iitem->index);
+		iitem->index = NULL;
+	}
+
+	return;
+}
+
+/* Takes appart our data structure so we don't leak any
+   memory or references. */
+static void
+prop_array_teardown (DbusmenuServerPrivate * priv)
+{
+	int i;
+
+	if (priv->prop_index != NULL) {
+		g_hash_table_destroy(priv->prop_index);
+		priv->prop_index = NULL;
+	}
+
+	if (priv->prop_array == NULL) {
+		return;
+	}
+
+	for (i = 0; i < priv->prop_array->len; i++) {
+		prop_idle_item_t * iitem = &g_array_index(priv->prop_array, prop_idle_item_t, i);
+
+		prop_item_clear(iitem);
 		g_object_unref(G_OBJECT(iitem->mi));
 		g_array_free(iitem->array, TRUE);
 	}
 
-	g_array_free(prop_array, TRUE);
+	g_array_free(priv->prop_array, TRUE);
+	priv->prop_array = NULL;
 
 	return;
 }
 
+/* Finds the pending entry for a menuitem, adding one to the end
+   of the array if it hasn't changed since the last idle. */
+static prop_idle_item_t *
+prop_array_item (DbusmenuServerPrivate * priv, DbusmenuMenuitem * mi)
+{
+	gpointer key = GINT_TO_POINTER(dbusmenu_menuitem_get_id(mi));
+	guint pos = GPOINTER_TO_UINT(g_hash_table_lookup(priv->prop_index, key));
+
+	if (pos != 0) {
+		prop_idle_item_t * iitem = &g_array_index(priv->prop_array, prop_idle_item_t, pos - 1);
+
+		/* An ID can get reused by a different item within a
+		   single idle.  The signal can only have each ID once and
+		   the item that had it before is gone, so what it had
+		   waiting is dropped and the entry is taken over. */
+		if (iitem->mi != mi) {
+			prop_item_clear(iitem);
+			g_object_ref(G_OBJECT(mi));
+			g_object_unref(G_OBJECT(iitem->mi));
+			iitem->mi = mi;
+		}
+
+		return iitem;
+	}
+
+	prop_idle_item_t myitem;
+	myitem.mi = mi;
+	g_object_ref(G_OBJECT(mi));
+	myitem.array = g_array_new(FALSE, FALSE, sizeof(prop_idle_prop_t));
+	myitem.index = NULL;
+
+	g_array_append_val(priv->prop_array, myitem);
+	g_hash_table_insert(priv->prop_index, key, GUINT_TO_POINTER(priv->prop_array->len));
+
+	return &g_array_index(priv->prop_array, prop_idle_item_t, priv->prop_array->len - 1);
+}
+
+/* Finds the pending value for a property on an item, adding an
+   empty one to the end of the item's array if there isn't one. */
+static prop_idle_prop_t *
+prop_array_prop (prop_idle_item_t * item, GQuark property)
+{
+	int i;
+
+	if (item->index != NULL) {
+		guint pos = GPOINTER_TO_UINT(g_hash_table_lookup(item->index, GUINT_TO_POINTER(property)));
+		if (pos != 0) {
+			return &g_array_index(item->array, prop_idle_prop_t, pos - 1);
+		}
+	} else {
+		for (i = 0; i < item->array->len; i++) {
+			prop_idle_prop_t * iprop = &g_array_index(item->array, prop_idle_prop_t, i);
+			if (iprop->property == property) {
+				return iprop;
+			}
+		}
+	}
+
+	prop_idle_prop_t myprop;
+	myprop.property = property;
+	myprop.variant = NULL;
+	g_array_append_val(item->array, myprop);
+
+	if (item->index != NULL) {
+		g_hash_table_insert(item->index, GUINT_TO_POINTER(property), GUINT_TO_POINTER(item->array->len));
+	} else if (item->array->len > PROP_IDLE_SCAN_MAX) {
+		item->index = g_hash_table_new(g_direct_hash, g_direct_equal);
+		for (i = 0; i < item->array->len; i++) {
+			prop_idle_prop_t * iprop = &g_array_index(item->array, prop_idle_prop_t, i);
+			g_hash_table_insert(item->index, GUINT_TO_POINTER(iprop->property), GUINT_TO_POINTER(i + 1));
+		}
+	}
+
+	return &g_array_index(item->array, prop_idle_prop_t, item->array->len - 1);
+}
+
 /* Works in the idle to send a set of property updates so that they'll
    all update in a single dbus message. */
 static gboolean
@@ -965,6 +1783,17 @@ menuitem_property_idle (gpointer user_data)
 	/* Source will get removed as we return */
 	priv->property_idle = 0;
 
+	/* Clients need to know about inserted items before they get
+	   property updates for them.  Pending edits are sent when their
+	   own schedule says so and the layout idle queues us again after
+	   them, both keep to the emission interval that way. */
+	if (priv->layout_idle != 0 && priv->layout_edits != NULL) {
+		priv->property_after_layout = TRUE;
+		return FALSE;
+	}
+
+	priv->property_last_emit = g_get_monotonic_time();
+
 	/* If there are no items, let's just not signal */
 	if (priv->prop_array == NULL) {
 		return FALSE;
@@ -1003,7 +1832,7 @@ menuitem_property_idle (gpointer user_data)
 					dictinit = TRUE;
 				}
 
-				GVariant * entry = g_variant_new_dict_entry(g_variant_new_string(iprop->property),
+				GVariant * entry = g_variant_new_dict_entry(g_variant_new_string(g_quark_to_string(iprop->property)),
 				                                            g_variant_new_variant(iprop->variant));
 
 				g_variant_builder_add_value(&dictbuilder, entry);
@@ -1013,7 +1842,7 @@ menuitem_property_idle (gpointer user_data)
 					removedictinit = TRUE;
 				}
 
-				g_variant_builder_add_value(&removedictbuilder, g_variant_new_string(iprop->property));
+				g_variant_builder_add_value(&removedictbuilder, g_variant_new_string(g_quark_to_string(iprop->property)));
 			}
 		}
 
@@ -1055,22 +1884,13 @@ menuitem_property_idle (gpointer user_data)
 	/* these are going to be standard references in all code paths and must be unrefed */
 	GVariant * megadata[2];
 	gboolean gotsomething = FALSE;
-	gboolean error_nosend = FALSE;
 
 	if (item_init) {
 		megadata[0] = g_variant_builder_end(&itembuilder);
 		g_variant_ref_sink(megadata[0]);
 		gotsomething = TRUE;
 	} else {
-		GError * error = NULL;
-		megadata[0] = g_variant_parse(G_VARIANT_TYPE("a(ia{sv})"), "[ ]", NULL, NULL, &error);
-
-		if (error != NULL) {
-			g_warning("Unable to parse '[ ]' as a 'a(ia{sv})': %s", error->message);
-			g_error_free(error);
-			megadata[0] = NULL;
-			error_nosend = TRUE;
-		}
+		megadata[0] = _dbusmenu_empty_variant(DBUSMENU_EMPTY_ITEM_PROPERTIES);
 	}
 
 	if (removeitem_init) {
@@ -1078,18 +1898,10 @@ menuitem_property_idle (gpointer user_data)
 		g_variant_ref_sink(megadata[1]);
 		gotsomething = TRUE;
 	} else {
-		GError * error = NULL;
-		megadata[1] = g_variant_parse(G_VARIANT_TYPE("a(ias)"), "[ ]", NULL, NULL, &error);
-
-		if (error != NULL) {
-			g_warning("Unable to parse '[ ]' as a 'a(ias)': %s", error->message);
-			g_error_free(error);
-			megadata[1] = NULL;
-			error_nosend = TRUE;
-		}
+		megadata[1] = _dbusmenu_empty_variant(DBUSMENU_EMPTY_ITEM_REMOVALS);
 	}
 
-	if (gotsomething && !error_nosend && priv->dbusobject != NULL && priv->bus != NULL) {
+	if (gotsomething && priv->dbusobject != NULL && priv->bus != NULL) {
 		g_dbus_connection_emit_signal(priv->bus,
 		                              NULL,
 		                              priv->dbusobject,
@@ -1097,74 +1909,48 @@ menuitem_property_idle (gpointer user_data)
 		                              "ItemsPropertiesUpdated",
 		                              g_variant_new_tuple(megadata, 2),
 		                              NULL);
-	}
 
-	if (megadata[0] != NULL) {
-		g_variant_unref(megadata[0]);
+		priv->property_signals++;
+		priv->property_entries += g_variant_n_children(megadata[0]) + g_variant_n_children(megadata[1]);
 	}
 
-	if (megadata[1] != NULL) {
-		g_variant_unref(megadata[1]);
-	}
+	g_variant_unref(megadata[0]);
+	g_variant_unref(megadata[1]);
 
 	/* Clean everything up */
-	prop_array_teardown(priv->prop_array);
-	priv->prop_array = NULL;
+	prop_array_teardown(priv);
 
 	return FALSE;
 }
 
 static void 
-menuitem_property_changed (DbusmenuMenuitem * mi, gchar * property, GVariant * variant, DbusmenuServer * server)
+menuitem_property_changed (DbusmenuMenuitem * mi, const gchar * property, GVariant * variant, gpointer user_data)
 {
-	int i;
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
 	gint item_id;
 
 	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
 
 	item_id = dbusmenu_menuitem_get_id(mi);
 
+	layout_cache_invalidate(server, mi);
+
 	g_signal_emit(G_OBJECT(server), signals[ID_PROP_UPDATE], 0, item_id, property, variant, TRUE);
 
 	/* See if we have a property array, if not, we need to
 	   build one of these suckers */
 	if (priv->prop_array == NULL) {
 		priv->prop_array = g_array_new(FALSE, FALSE, sizeof(prop_idle_item_t));
+		priv->prop_index = g_hash_table_new(g_direct_hash, g_direct_equal);
 	}
 
-	/* Look to see if we already have this item in the list
-	   and use it if so */
-	prop_idle_item_t * item = NULL;
-	for (i = 0; i < priv->prop_array->len; i++) {
-		prop_idle_item_t * iitem = &g_array_index(priv->prop_array, prop_idle_item_t, i);
-		if (iitem->mi == mi) {
-			item = iitem;
-			break;
-		}
-	}
-
-	GArray * properties = NULL;
-	/* If not, we'll need to build ourselves one */
-	if (item == NULL) {
-		prop_idle_item_t myitem;
-		myitem.mi = mi;
-		g_object_ref(G_OBJECT(mi));
-		myitem.array = g_array_new(FALSE, FALSE, sizeof(prop_idle_prop_t));
-
-		g_array_append_val(priv->prop_array, myitem);
-		properties = myitem.array;
-	} else {
-		properties = item->array;
-	}
+	prop_idle_item_t * item = prop_array_item(priv, mi);
+	guint pending = item->array->len;
+	prop_idle_prop_t * prop = prop_array_prop(item, g_quark_from_string(property));
 
-	/* Check to see if this property is in the list */
-	prop_idle_prop_t * prop = NULL;
-	for (i = 0; i < properties->len; i++) {
-		prop_idle_prop_t * iprop = &g_array_index(properties, prop_idle_prop_t, i);
-		if (g_strcmp0(iprop->property, property) == 0) {
-			prop = iprop;
-			break;
-		}
+	/* It was already waiting to go out, this value replaces that one */
+	if (item->array->len == pending) {
+		priv->property_coalesced++;
 	}
 
 	/* If it's the default value we want to treat it like a clearing
@@ -1174,82 +1960,72 @@ menuitem_property_changed (DbusmenuMenuitem * mi, gchar * property, GVariant * v
 		variant = NULL;
 	}
 
-	/* If so, we need to swap the value */
-	if (prop != NULL) {
-		if (prop->variant != NULL) {
-			g_variant_unref(prop->variant);
-		}
-		prop->variant = variant;
-	} else {
-	/* else we need to add it */
-		prop_idle_prop_t myprop;
-		myprop.property = g_strdup(property);
-		myprop.variant = variant;
-
-		g_array_append_val(properties, myprop);
+	/* Swap in the new value */
+	if (prop->variant != NULL) {
+		g_variant_unref(prop->variant);
 	}
+	prop->variant = variant;
 	if (variant != NULL) {
 		g_variant_ref_sink(variant);
 	}
 
 	/* Check to see if the idle is already queued, and queue it
 	   if not. */
-	if (priv->property_idle == 0) {
-		priv->property_idle = g_idle_add(menuitem_property_idle, server);
+	if (priv->property_idle == 0 && !priv->property_after_layout) {
+		priv->property_idle = emit_schedule(server, priv->property_last_emit, menuitem_property_idle);
+	} else {
+		priv->property_merged++;
 	}
 
 	return;
 }
 
-/* Adds the signals for this entry to the list and looks at
-   the children of this entry to add the signals we need
-   as well.  We like signals. */
+/* Callback for when a child is added.  The observer on the root
+   already covers it and everything below it, so we only need to
+   be able to find them and signal that the layout has changed. */
 static void
-added_check_children (gpointer data, gpointer user_data)
+menuitem_child_added (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint pos, gpointer user_data)
 {
-	DbusmenuMenuitem * mi = (DbusmenuMenuitem *)data;
-	DbusmenuServer * server = (DbusmenuServer *)user_data;
-
-	menuitem_signals_create(mi, server);
-	g_list_foreach(dbusmenu_menuitem_get_children(mi), added_check_children, server);
-
-	return;
-}
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
 
-/* Callback for when a child is added.  We need to connect everything
-   up and signal that the layout has changed. */
-static void
-menuitem_child_added (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint pos, DbusmenuServer * server)
-{
-	menuitem_signals_create(child, server);
 	cache_add_entries_for_menuitem(server->priv->lookup_cache, child);
-	g_list_foreach(dbusmenu_menuitem_get_children(child), added_check_children, server);
 
-	layout_update_signal(server);
+	layout_cache_invalidate(server, parent);
+	layout_update_signal(server, parent);
+	layout_edits_record(server, DBUSMENU_LAYOUT_EDIT_INSERT, parent, child, pos);
 	return;
 }
 
 static void 
-menuitem_child_removed (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, DbusmenuServer * server)
+menuitem_child_removed (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, gpointer user_data)
 {
-	menuitem_signals_remove(child, server);
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
+
 	cache_remove_entries_for_menuitem(server->priv->lookup_cache, child);
-	layout_update_signal(server);
+	layout_cache_remove_subtree(server, child);
+	layout_cache_invalidate(server, parent);
+	layout_update_signal(server, parent);
+	layout_edits_record(server, DBUSMENU_LAYOUT_EDIT_REMOVE, parent, child, 0);
 	return;
 }
 
 static void 
-menuitem_child_moved (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint newpos, guint oldpos, DbusmenuServer * server)
+menuitem_child_moved (DbusmenuMenuitem * parent, DbusmenuMenuitem * child, guint newpos, guint oldpos, gpointer user_data)
 {
-	layout_update_signal(server);
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
+
+	layout_cache_invalidate(server, parent);
+	layout_update_signal(server, parent);
+	layout_edits_record(server, DBUSMENU_LAYOUT_EDIT_MOVE, parent, child, newpos);
 	return;
 }
 
 /* Called when a menu item emits its activated signal so it
    gets passed across the bus. */
 static void 
-menuitem_shown (DbusmenuMenuitem * mi, guint timestamp, DbusmenuServer * server)
+menuitem_shown (DbusmenuMenuitem * mi, guint timestamp, gpointer user_data)
 {
+	DbusmenuServer * server = DBUSMENU_SERVER(user_data);
 	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
 
 	g_signal_emit(G_OBJECT(server), signals[ITEM_ACTIVATION], 0, dbusmenu_menuitem_get_id(mi), timestamp, TRUE);
@@ -1267,32 +2043,6 @@ menuitem_shown (DbusmenuMenuitem * mi, guint timestamp, DbusmenuServer * server)
 	return;
 }
 
-/* Connects all the signals that we're interested in
-   coming from a menuitem */
-static void
-menuitem_signals_create (DbusmenuMenuitem * mi, gpointer data)
-{
-	g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_CHILD_ADDED, G_CALLBACK(menuitem_child_added), data);
-	g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_CHILD_REMOVED, G_CALLBACK(menuitem_child_removed), data);
-	g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_CHILD_MOVED, G_CALLBACK(menuitem_child_moved), data);
-	g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, G_CALLBACK(menuitem_property_changed), data);
-	g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_SHOW_TO_USER, G_CALLBACK(menuitem_shown), data);
-	return;
-}
-
-/* Removes all the signals that we're interested in
-   coming from a menuitem */
-static void
-menuitem_signals_remove (DbusmenuMenuitem * mi, gpointer data)
-{
-	g_signal_handlers_disconnect_by_func(G_OBJECT(mi), G_CALLBACK(menuitem_child_added), data);
-	g_signal_handlers_disconnect_by_func(G_OBJECT(mi), G_CALLBACK(menuitem_child_removed), data);
-	g_signal_handlers_disconnect_by_func(G_OBJECT(mi), G_CALLBACK(menuitem_child_moved), data);
-	g_signal_handlers_disconnect_by_func(G_OBJECT(mi), G_CALLBACK(menuitem_property_changed), data);
-	g_signal_handlers_disconnect_by_func(G_OBJECT(mi), G_CALLBACK(menuitem_shown), data);
-	return;
-}
-
 static GQuark
 error_quark (void)
 {
@@ -1326,9 +2076,23 @@ bus_get_layout (DbusmenuServer * server, GVariant * params, GDBusMethodInvocatio
 		DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, parent);
 
 		if (mi != NULL) {
-			items = dbusmenu_menuitem_build_variant(mi, props, recurse);
-			if (items) {
-				g_variant_ref_sink(items);
+			/* Several clients tend to ask for the same thing, so
+			   reuse what we built for them if nothing changed. */
+			items = layout_cache_lookup(server, mi, recurse, props);
+
+			if (items == NULL) {
+				items = dbusmenu_menuitem_build_variant(mi, props, recurse);
+				if (items) {
+					g_variant_ref_sink(items);
+					layout_cache_store(server, mi, recurse, props, items);
+				}
+			}
+		} else {
+			guint index;
+			source_t * source = source_lookup(server, parent, &index);
+
+			if (source != NULL) {
+				items = g_variant_ref_sink(source_build_item(source, index, props));
 			}
 		}
 	}
@@ -1339,7 +2103,7 @@ bus_get_layout (DbusmenuServer * server, GVariant * params, GDBusMethodInvocatio
 		if (parent == 0) {
 			/* We should always have a root, so we'll make up one for
 			   right now. */
-			items = g_variant_parse(G_VARIANT_TYPE("(ia{sv}av)"), "(0, [], [])", NULL, NULL, NULL);
+			items = _dbusmenu_empty_variant(DBUSMENU_EMPTY_LAYOUT);
 		} else {
 			/* If we were looking for a specific ID that's an error that
 			   we should send back, so let's do that. */
@@ -1363,11 +2127,96 @@ bus_get_layout (DbusmenuServer * server, GVariant * params, GDBusMethodInvocatio
 
 	GVariant * retval = g_variant_builder_end(&tuplebuilder);
 	// g_debug("Sending layout type: %s", g_variant_get_type_string(retval));
+	priv->layout_calls++;
+	priv->layout_bytes += g_variant_get_size(retval);
+
 	g_dbus_method_invocation_return_value(invocation,
 	                                      retval);
 	return;
 }
 
+/* Like GetLayout one level deep, but with only the children of
+   the item from @offset to @offset + @count in it so that long
+   menus can be sent a page at a time */
+static void
+bus_get_layout_page (DbusmenuServer * server, GVariant * params, GDBusMethodInvocation * invocation)
+{
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	if (priv->root == NULL) {
+		g_dbus_method_invocation_return_error(invocation,
+			            error_quark(),
+			            NO_VALID_LAYOUT,
+			            "There currently isn't a layout in this server");
+		return;
+	}
+
+	gint32 parent;
+	guint32 offset;
+	guint32 count;
+	const gchar ** props;
+
+	g_variant_get(params, "(iuu^a&s)", &parent, &offset, &count, &props);
+
+	DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, parent);
+
+	if (mi == NULL) {
+		g_free(props);
+		g_dbus_method_invocation_return_error(invocation,
+			                                  error_quark(),
+			                                  INVALID_MENUITEM_ID,
+			                                  "The ID supplied %d does not refer to a menu item we have",
+			                                  parent);
+		return;
+	}
+
+	/* The item itself, without any children */
+	GVariant * node = dbusmenu_menuitem_build_variant(mi, props, 0);
+	g_variant_ref_sink(node);
+
+	GVariantBuilder children;
+	g_variant_builder_init(&children, G_VARIANT_TYPE("av"));
+	guint total = 0;
+
+	source_t * source = source_find(server, mi, NULL);
+	if (source != NULL) {
+		total = source->funcs.get_n_items(source->user_data);
+
+		guint index;
+		for (index = offset; index < total && index - offset < count; index++) {
+			g_variant_builder_add_value(&children, g_variant_new_variant(source_build_item(source, index, props)));
+		}
+	} else {
+		GList * child;
+		total = _dbusmenu_menuitem_get_n_children(mi);
+
+		guint sent = 0;
+		for (child = _dbusmenu_menuitem_get_child_link(mi, offset); child != NULL && sent < count; child = g_list_next(child), sent++) {
+			GVariant * layout = dbusmenu_menuitem_build_variant(DBUSMENU_MENUITEM(child->data), props, 0);
+			g_variant_builder_add_value(&children, g_variant_new_variant(layout));
+		}
+	}
+	g_free(props);
+
+	GVariant * layout[3];
+	layout[0] = g_variant_get_child_value(node, 0);
+	layout[1] = g_variant_get_child_value(node, 1);
+	layout[2] = g_variant_builder_end(&children);
+
+	GVariant * page = g_variant_new_tuple(layout, 3);
+
+	g_variant_unref(layout[0]);
+	g_variant_unref(layout[1]);
+	g_variant_unref(node);
+
+	GVariant * retval = g_variant_new("(uu@(ia{sv}av))", priv->layout_revision, total, page);
+	priv->layout_calls++;
+	priv->layout_bytes += g_variant_get_size(retval);
+
+	g_dbus_method_invocation_return_value(invocation, retval);
+	return;
+}
+
 /* Get a single property off of a single menuitem */
 static void
 bus_get_property (DbusmenuServer * server, GVariant * params, GDBusMethodInvocation * invocation)
@@ -1388,17 +2237,31 @@ bus_get_property (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 	g_variant_get(params, "(i&s)", &id, &property);
 
 	DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
+	GVariant * variant = NULL;
 
-	if (mi == NULL) {
-		g_dbus_method_invocation_return_error(invocation,
-			            error_quark(),
-			            INVALID_MENUITEM_ID,
-			            "The ID supplied %d does not refer to a menu item we have",
-			            id);
-		return;
+	if (mi != NULL) {
+		variant = dbusmenu_menuitem_property_get_variant(mi, property);
+		if (variant != NULL) {
+			g_variant_ref(variant);
+		}
+	} else {
+		guint index;
+		source_t * source = source_lookup(server, id, &index);
+
+		if (source == NULL) {
+			g_dbus_method_invocation_return_error(invocation,
+				            error_quark(),
+				            INVALID_MENUITEM_ID,
+				            "The ID supplied %d does not refer to a menu item we have",
+				            id);
+			return;
+		}
+
+		GVariant * dict = source_properties(source, index, NULL);
+		variant = g_variant_lookup_value(dict, property, NULL);
+		g_variant_unref(dict);
 	}
 
-	GVariant * variant = dbusmenu_menuitem_property_get_variant(mi, property);
 	if (variant == NULL) {
 		g_dbus_method_invocation_return_error(invocation,
 			            error_quark(),
@@ -1410,6 +2273,7 @@ bus_get_property (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 	}
 
 	g_dbus_method_invocation_return_value(invocation, g_variant_new("(v)", variant));
+	g_variant_unref(variant);
 	return;
 }
 
@@ -1431,19 +2295,32 @@ bus_get_properties (DbusmenuServer * server, GVariant * params, GDBusMethodInvoc
 	g_variant_get(params, "(i)", &id);
 
 	DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
+	GVariant * dict = NULL;
 
-	if (mi == NULL) {
-		g_dbus_method_invocation_return_error(invocation,
-			            error_quark(),
-			            INVALID_MENUITEM_ID,
-			            "The ID supplied %d does not refer to a menu item we have",
-			            id);
-		return;
+	if (mi != NULL) {
+		dict = dbusmenu_menuitem_properties_variant(mi, NULL);
+	} else {
+		guint index;
+		source_t * source = source_lookup(server, id, &index);
+
+		if (source == NULL) {
+			g_dbus_method_invocation_return_error(invocation,
+				            error_quark(),
+				            INVALID_MENUITEM_ID,
+				            "The ID supplied %d does not refer to a menu item we have",
+				            id);
+			return;
+		}
+
+		dict = source_properties(source, index, NULL);
 	}
 
-	GVariant * dict = dbusmenu_menuitem_properties_variant(mi, NULL);
+	if (dict == NULL) {
+		dict = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
+	}
 
-	g_dbus_method_invocation_return_value(invocation, g_variant_new("(a{sv})", dict));
+	g_dbus_method_invocation_return_value(invocation, g_variant_new("(@a{sv})", dict));
+	g_variant_unref(dict);
 
 	return;
 }
@@ -1469,7 +2346,7 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 
 			if (id == 0) {
 
-				GVariant * final = g_variant_parse(G_VARIANT_TYPE("(a(ia{sv}))"), "([(0, {})],)", NULL, NULL, NULL);
+				GVariant * final = _dbusmenu_empty_variant(DBUSMENU_EMPTY_GROUP_PROPERTIES);
 				g_dbus_method_invocation_return_value(invocation, final);
 				g_variant_unref(final);
 			}
@@ -1485,8 +2362,11 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 	}
 
 	GVariantIter *ids;
-	g_variant_get(params, "(aias)", &ids, NULL);
-	/* TODO: implementation ignores propertyNames declared in XML */
+	const gchar ** props;
+	g_variant_get(params, "(ai^a&s)", &ids, &props);
+
+	/* An empty list of property names means all of them, which
+	   dbusmenu_menuitem_properties_variant() takes care of */
 
 	GVariantBuilder builder;
 	gboolean builder_init = FALSE;
@@ -1494,7 +2374,13 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 	gint32 id;
 	while (g_variant_iter_loop(ids, "i", &id)) {
 		DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
-		if (mi == NULL) continue;
+		source_t * source = NULL;
+		guint index = 0;
+
+		if (mi == NULL) {
+			source = source_lookup(server, id, &index);
+			if (source == NULL) continue;
+		}
 
 		if (!builder_init) {
 			g_variant_builder_init(&builder, G_VARIANT_TYPE_ARRAY);
@@ -1504,28 +2390,25 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 		GVariantBuilder wbuilder;
 		g_variant_builder_init(&wbuilder, G_VARIANT_TYPE_TUPLE);
 		g_variant_builder_add(&wbuilder, "i", id);
-		GVariant * props = dbusmenu_menuitem_properties_variant(mi, NULL);
-		if (props != NULL) {
-			g_variant_ref(props);
+		GVariant * mi_props = NULL;
+		if (mi != NULL) {
+			mi_props = dbusmenu_menuitem_properties_variant(mi, props);
+		} else {
+			mi_props = source_properties(source, index, props);
 		}
 
-		if (props == NULL) {
-			GError * error = NULL;
-			props = g_variant_parse(G_VARIANT_TYPE("a{sv}"), "{}", NULL, NULL, &error);
-			if (error != NULL) {
-				g_warning("Unable to parse '{}' as a 'a{sv}': %s", error->message);
-				g_error_free(error);
-				props = NULL;
-			}
+		if (mi_props == NULL) {
+			mi_props = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
 		}
 
-		g_variant_builder_add_value(&wbuilder, props);
-		g_variant_unref(props);
+		g_variant_builder_add_value(&wbuilder, mi_props);
+		g_variant_unref(mi_props);
 		GVariant * mi_data = g_variant_builder_end(&wbuilder);
 
 		g_variant_builder_add_value(&builder, mi_data);
 	}
 	g_variant_iter_free(ids);
+	g_free(props);
 
 	/* a standard reference that must be unrefed */
 	GVariant * ret = NULL;
@@ -1534,12 +2417,7 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 		ret = g_variant_builder_end(&builder);
 		g_variant_ref_sink(ret);
 	} else {
-		GError * error = NULL;
-		ret = g_variant_parse(G_VARIANT_TYPE("a(ia{sv})"), "[]", NULL, NULL, &error);
-		if (error != NULL) {
-			g_warning("Unable to parse '[]' as a 'a(ia{sv})': %s", error->message);
-			g_error_free(error);
-		}
+		ret = _dbusmenu_empty_variant(DBUSMENU_EMPTY_ITEM_PROPERTIES);
 	}
 
 	GVariant * final = NULL;
@@ -1548,6 +2426,7 @@ bus_get_group_properties (DbusmenuServer * server, GVariant * params, GDBusMetho
 		g_variant_builder_add_value(&builder, ret);
 		g_variant_unref(ret);
 		final = g_variant_builder_end(&builder);
+		priv->group_calls++;
 	} else {
 		g_warning("Error building property list, final variant is NULL");
 	}
@@ -1572,7 +2451,11 @@ serialize_menuitem(gpointer data, gpointer user_data)
 	g_variant_builder_add_value(&tuple, g_variant_new_int32(id));
 
 	GVariant * props = dbusmenu_menuitem_properties_variant(mi, NULL);
+	if (props == NULL) {
+		props = _dbusmenu_empty_variant(DBUSMENU_EMPTY_PROPERTIES);
+	}
 	g_variant_builder_add_value(&tuple, props);
+	g_variant_unref(props);
 
 	g_variant_builder_add_value(builder, g_variant_builder_end(&tuple));
 
@@ -1597,8 +2480,17 @@ bus_get_children (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 	}
 
 	DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
+	guint index;
 
 	if (mi == NULL) {
+		if (source_lookup(server, id, &index) != NULL) {
+			/* Items from a source don't have children */
+			GVariant * empty = _dbusmenu_empty_variant(DBUSMENU_EMPTY_GROUP_PROPERTIES);
+			g_dbus_method_invocation_return_value(invocation, empty);
+			g_variant_unref(empty);
+			return;
+		}
+
 		g_dbus_method_invocation_return_error(invocation,
 			                                  error_quark(),
 			                                  INVALID_MENUITEM_ID,
@@ -1608,9 +2500,24 @@ bus_get_children (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 	}
 
 	GList * children = dbusmenu_menuitem_get_children(mi);
+	source_t * source = source_find(server, mi, NULL);
 	GVariant * ret = NULL;
 
-	if (children != NULL) {
+	if (source != NULL && source->funcs.get_n_items(source->user_data) > 0) {
+		GVariantBuilder builder;
+		g_variant_builder_init(&builder, G_VARIANT_TYPE("a(ia{sv})"));
+
+		guint count = source->funcs.get_n_items(source->user_data);
+		for (index = 0; index < count; index++) {
+			GVariant * props = source_properties(source, index, NULL);
+			g_variant_builder_add(&builder, "(i@a{sv})", source->funcs.get_id(index, source->user_data), props);
+			g_variant_unref(props);
+		}
+
+		GVariant * end = g_variant_builder_end(&builder);
+		ret = g_variant_new_tuple(&end, 1);
+		g_variant_ref_sink(ret);
+	} else if (source == NULL && children != NULL) {
 		GVariantBuilder builder;
 		g_variant_builder_init(&builder, G_VARIANT_TYPE_ARRAY); 
 
@@ -1620,13 +2527,7 @@ bus_get_children (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 		ret = g_variant_new_tuple(&end, 1);
 		g_variant_ref_sink(ret);
 	} else {
-		GError * error = NULL;
-		ret = g_variant_parse(G_VARIANT_TYPE("(a(ia{sv}))"), "([(0, {})],)", NULL, NULL, &error);
-		if (error != NULL) {
-			g_warning("Unable to parse '([(0, {})],)' as a '(a(ia{sv}))': %s", error->message);
-			g_error_free(error);
-			ret = NULL;
-		}
+		ret = _dbusmenu_empty_variant(DBUSMENU_EMPTY_GROUP_PROPERTIES);
 	}
 
 	g_dbus_method_invocation_return_value(invocation, ret);
@@ -1639,6 +2540,8 @@ bus_get_children (DbusmenuServer * server, GVariant * params, GDBusMethodInvocat
 typedef struct _idle_event_t idle_event_t;
 struct _idle_event_t {
 	DbusmenuMenuitem * mi;
+	DbusmenuServer * server; /* Only for items from a source */
+	gint32 id;
 	gchar * eventid;
 	GVariant * variant;
 	guint timestamp;
@@ -1651,9 +2554,21 @@ event_local_handler (gpointer user_data)
 {
 	idle_event_t * data = (idle_event_t *)user_data;
 
-	dbusmenu_menuitem_handle_event(data->mi, data->eventid, data->variant, data->timestamp);
+	if (data->mi != NULL) {
+		dbusmenu_menuitem_handle_event(data->mi, data->eventid, data->variant, data->timestamp);
+		g_object_unref(data->mi);
+	} else {
+		/* Look again, the source could have changed since */
+		guint index;
+		source_t * source = source_lookup(data->server, data->id, &index);
+
+		if (source != NULL && source->funcs.event != NULL) {
+			source->funcs.event(data->id, data->eventid, data->variant, data->timestamp, source->user_data);
+		}
+
+		g_object_unref(data->server);
+	}
 
-	g_object_unref(data->mi);
 	g_free(data->eventid);
 	g_variant_unref(data->variant);
 	g_free(data);
@@ -1666,13 +2581,21 @@ static gboolean
 bus_event_core (DbusmenuServer * server, gint32 id, gchar * event_type, GVariant * data, guint32 timestamp)
 {
 	DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
+	guint index;
 
-	if (mi == NULL) {
+	idle_event_t * event_data = NULL;
+
+	if (mi != NULL) {
+		event_data = g_new0(idle_event_t, 1);
+		event_data->mi = g_object_ref(mi);
+	} else if (source_lookup(server, id, &index) != NULL) {
+		event_data = g_new0(idle_event_t, 1);
+		event_data->server = g_object_ref(server);
+		event_data->id = id;
+	} else {
 		return FALSE;
 	}
 
-	idle_event_t * event_data = g_new0(idle_event_t, 1);
-	event_data->mi = g_object_ref(mi);
 	event_data->eventid = g_strdup(event_type);
 	event_data->timestamp = timestamp;
 	event_data->variant = g_variant_ref(data);
@@ -1783,9 +2706,35 @@ bus_event_group (DbusmenuServer * server, GVariant * params, GDBusMethodInvocati
 	return;
 }
 
+/* Key for the populate_t on a menuitem */
+static const gchar * data_populate = "dbusmenu-server-populate";
+
+/* A reply to AboutToShow waiting on submenus being built */
+typedef struct _about_to_show_t about_to_show_t;
+struct _about_to_show_t {
+	GDBusMethodInvocation * invocation;
+	gboolean group;
+	guint pending; /* Submenus still being built */
+	GArray * updates; /* gint32 IDs that need an update */
+	GVariant * errors; /* ai, only for the group */
+};
+
+/* The populate function of a menuitem and the replies
+   waiting on it */
+typedef struct _populate_t populate_t;
+struct _populate_t {
+	DbusmenuServer * server; /* weak */
+	gint32 id;
+	DbusmenuServerPopulateFunc func;
+	gpointer user_data;
+	GDestroyNotify destroy;
+	gboolean running;
+	GList * waiting; /* about_to_show_t * */
+};
+
 /* Does the about-to-show in an idle loop so we don't block things */
-/* NOTE: this only works so easily as we don't return the value, if we
-   were to do that it would get more complex. */
+/* NOTE: this only works so easily as we don't return the value, the
+   replies that wait for a submenu to be built go through populate_t */
 static gboolean
 bus_about_to_show_idle (gpointer user_data)
 {
@@ -1795,6 +2744,138 @@ bus_about_to_show_idle (gpointer user_data)
 	return FALSE;
 }
 
+/* A reply to AboutToShow or AboutToShowGroup that is waiting
+   for @pending submenus to be built */
+static about_to_show_t *
+about_to_show_new (GDBusMethodInvocation * invocation, gboolean group)
+{
+	about_to_show_t * waiter = g_new0(about_to_show_t, 1);
+	waiter->invocation = invocation;
+	waiter->group = group;
+	waiter->pending = 0;
+	waiter->updates = g_array_new(FALSE, FALSE, sizeof(gint32));
+	waiter->errors = NULL;
+	return waiter;
+}
+
+/* Send the reply, with the IDs of the submenus that were built
+   as the ones that need an update */
+static void
+about_to_show_reply (about_to_show_t * waiter)
+{
+	if (g_dbus_message_get_flags(g_dbus_method_invocation_get_message(waiter->invocation)) & G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED) {
+		g_object_unref(waiter->invocation);
+	} else if (waiter->group) {
+		GVariantBuilder tuple;
+		g_variant_builder_init(&tuple, G_VARIANT_TYPE_TUPLE);
+
+		/* Updates needed */
+		g_variant_builder_add_value(&tuple, g_variant_new_fixed_array(G_VARIANT_TYPE_INT32, waiter->updates->data, waiter->updates->len, sizeof(gint32)));
+		/* Errors */
+		g_variant_builder_add_value(&tuple, waiter->errors);
+
+		g_dbus_method_invocation_return_value(waiter->invocation, g_variant_builder_end(&tuple));
+	} else {
+		g_dbus_method_invocation_return_value(waiter->invocation, g_variant_new("(b)", waiter->updates->len > 0));
+	}
+
+	if (waiter->errors != NULL) {
+		g_variant_unref(waiter->errors);
+	}
+	g_array_free(waiter->updates, TRUE);
+	g_free(waiter);
+	return;
+}
+
+/* One of the submenus the reply is waiting on is done */
+static void
+about_to_show_populated (about_to_show_t * waiter, gint32 id, gboolean updated)
+{
+	if (updated) {
+		g_array_append_val(waiter->updates, id);
+	}
+
+	waiter->pending--;
+	if (waiter->pending == 0) {
+		about_to_show_reply(waiter);
+	}
+	return;
+}
+
+/* Tells all the replies waiting on @populate that it's done */
+static void
+populate_finish (populate_t * populate, gboolean updated)
+{
+	GList * waiting = populate->waiting;
+	GList * waiter;
+
+	populate->waiting = NULL;
+	populate->running = FALSE;
+
+	for (waiter = waiting; waiter != NULL; waiter = g_list_next(waiter)) {
+		about_to_show_populated((about_to_show_t *)waiter->data, populate->id, updated);
+	}
+	g_list_free(waiting);
+
+	return;
+}
+
+/* Goes away with the item or when it gets another function,
+   nothing was built for whoever is still waiting */
+static void
+populate_free (gpointer data)
+{
+	populate_t * populate = (populate_t *)data;
+
+	populate_finish(populate, FALSE);
+
+	if (populate->destroy != NULL) {
+		populate->destroy(populate->user_data);
+	}
+
+	if (populate->server != NULL) {
+		g_object_remove_weak_pointer(G_OBJECT(populate->server), (gpointer *)&populate->server);
+	}
+
+	g_free(populate);
+	return;
+}
+
+/* Build the submenu outside of the method call */
+static gboolean
+populate_idle (gpointer user_data)
+{
+	DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(user_data);
+	populate_t * populate = g_object_get_data(G_OBJECT(mi), data_populate);
+
+	if (populate != NULL && populate->running) {
+		if (populate->server != NULL) {
+			populate->func(populate->server, mi, populate->user_data);
+		} else {
+			populate_finish(populate, FALSE);
+		}
+	}
+
+	g_object_unref(mi);
+	return FALSE;
+}
+
+/* Make @waiter wait on the submenu of @mi being built, and start
+   building it if that isn't happening already */
+static void
+populate_queue (DbusmenuMenuitem * mi, populate_t * populate, about_to_show_t * waiter)
+{
+	waiter->pending++;
+	populate->waiting = g_list_prepend(populate->waiting, waiter);
+
+	if (!populate->running) {
+		populate->running = TRUE;
+		g_idle_add(populate_idle, g_object_ref(mi));
+	}
+
+	return;
+}
+
 /* Recieve the About To Show function.  Pass it to our menu item. */
 static void
 bus_about_to_show (DbusmenuServer * server, GVariant * params, GDBusMethodInvocation * invocation)
@@ -1824,9 +2905,16 @@ bus_about_to_show (DbusmenuServer * server, GVariant * params, GDBusMethodInvoca
 
 	g_timeout_add(0, bus_about_to_show_idle, g_object_ref(mi));
 
-	/* GTK+ does not support about-to-show concept for now */
-	g_dbus_method_invocation_return_value(invocation,
-	                                      g_variant_new("(b)", FALSE));
+	/* Without a populate function there's nothing that could
+	   change because of this */
+	populate_t * populate = g_object_get_data(G_OBJECT(mi), data_populate);
+	if (populate == NULL) {
+		g_dbus_method_invocation_return_value(invocation,
+		                                      g_variant_new("(b)", FALSE));
+		return;
+	}
+
+	populate_queue(mi, populate, about_to_show_new(invocation, FALSE));
 	return;
 }
 
@@ -1854,11 +2942,27 @@ bus_about_to_show_group (DbusmenuServer * server, GVariant * params, GDBusMethod
 	g_variant_builder_init(&builder, G_VARIANT_TYPE("ai"));
 	gboolean gotone = FALSE;
 
+	/* An ID that's in there twice only gets shown once, otherwise
+	   the reply would wait on its submenu twice */
+	GHashTable * seen = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	about_to_show_t * waiter = about_to_show_new(invocation, TRUE);
+
 	while (g_variant_iter_loop(&iter, "i", &id)) {
+		if (g_hash_table_contains(seen, GINT_TO_POINTER(id))) {
+			continue;
+		}
+		g_hash_table_add(seen, GINT_TO_POINTER(id));
+
 		DbusmenuMenuitem * mi = lookup_menuitem_by_id(server, id);
 		if (mi != NULL) {
 			g_timeout_add(0, bus_about_to_show_idle, g_object_ref(mi));
 			gotone = TRUE;
+
+			populate_t * populate = g_object_get_data(G_OBJECT(mi), data_populate);
+			if (populate != NULL) {
+				populate_queue(mi, populate, waiter);
+			}
 		} else {
 			g_variant_builder_add_value(&builder, g_variant_new_int32(id));
 		}
@@ -1868,18 +2972,11 @@ bus_about_to_show_group (DbusmenuServer * server, GVariant * params, GDBusMethod
 	g_variant_ref_sink(errors);
 
 	if (gotone) {
-		if (~g_dbus_message_get_flags (g_dbus_method_invocation_get_message (invocation)) & G_DBUS_MESSAGE_FLAGS_NO_REPLY_EXPECTED) {
-			GVariantBuilder tuple;
-			g_variant_builder_init(&tuple, G_VARIANT_TYPE_TUPLE);
-
-			/* Updates needed */
-			g_variant_builder_add_value(&tuple, g_variant_new_array(G_VARIANT_TYPE_INT32, NULL, 0));
-			/* Errors */
-			g_variant_builder_add_value(&tuple, errors);
-
-			g_dbus_method_invocation_return_value(invocation, g_variant_builder_end(&tuple));
-		} else {
-			g_object_unref(invocation);
+		/* Replies when the last submenu is built, or now if
+		   there are none */
+		waiter->errors = g_variant_ref(errors);
+		if (waiter->pending == 0) {
+			about_to_show_reply(waiter);
 		}
 	} else {
 		gchar * ids = g_variant_print(errors, FALSE);
@@ -1889,8 +2986,12 @@ bus_about_to_show_group (DbusmenuServer * server, GVariant * params, GDBusMethod
 			                                  "The IDs supplied '%s' do not refer to any menu items we have",
 			                                  ids);
 		g_free(ids);
+
+		g_array_free(waiter->updates, TRUE);
+		g_free(waiter);
 	}
 
+	g_hash_table_destroy(seen);
 	g_variant_unref(errors);
 	g_variant_unref(items);
 
@@ -1947,6 +3048,62 @@ dbusmenu_server_set_root (DbusmenuServer * self, DbusmenuMenuitem * root)
 	return;
 }
 
+/**
+	dbusmenu_server_save_snapshot:
+	@server: The #DbusmenuServer whose tree should be saved
+	@filename: File to write the snapshot to
+	@error: Return location for a #GError or %NULL
+
+	Saves the whole tree under the root of @server to @filename
+	using #dbusmenu_menuitem_snapshot_save.
+
+	Return value: Whether the file was written
+*/
+gboolean
+dbusmenu_server_save_snapshot (DbusmenuServer * server, const gchar * filename, GError ** error)
+{
+	g_return_val_if_fail(DBUSMENU_IS_SERVER(server), FALSE);
+	g_return_val_if_fail(filename != NULL, FALSE);
+
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	if (priv->root == NULL) {
+		g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "Server has no root to save");
+		return FALSE;
+	}
+
+	return dbusmenu_menuitem_snapshot_save(priv->root, filename, error);
+}
+
+/**
+	dbusmenu_server_load_snapshot:
+	@server: The #DbusmenuServer to load the tree into
+	@filename: File written by #dbusmenu_server_save_snapshot
+	@error: Return location for a #GError or %NULL
+
+	Builds the tree stored in @filename in one pass, without
+	any signals, and then sets it as the root of @server.  The
+	current root is kept if the file can't be loaded.
+
+	Return value: Whether the tree was loaded
+*/
+gboolean
+dbusmenu_server_load_snapshot (DbusmenuServer * server, const gchar * filename, GError ** error)
+{
+	g_return_val_if_fail(DBUSMENU_IS_SERVER(server), FALSE);
+	g_return_val_if_fail(filename != NULL, FALSE);
+
+	DbusmenuMenuitem * root = dbusmenu_menuitem_snapshot_load(filename, error);
+	if (root == NULL) {
+		return FALSE;
+	}
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	return TRUE;
+}
+
 /**
 	dbusmenu_server_get_text_direction:
 	@server: The #DbusmenuServer object to get the text direction from
@@ -2108,3 +3265,198 @@ dbusmenu_server_set_icon_paths (DbusmenuServer * server, GStrv icon_paths)
 
 	return;
 }
+
+/**
+	dbusmenu_server_set_populate_func:
+	@server: The #DbusmenuServer @item is shown through
+	@item: The #DbusmenuMenuitem whose children are built on demand
+	@func: (allow-none): Builds the children of @item, or %NULL to remove it
+	@user_data: Data passed to @func
+	@destroy: (allow-none): Frees @user_data when @func is replaced or @item goes away
+
+	Builds the submenu of @item only when a client is about to show
+	it.  When an AboutToShow comes in for @item, @func gets called
+	from an idle and the reply holds off until
+	#dbusmenu_server_populate_done is called, which then tells the
+	client that @item needs an update.  Requests that come in while
+	@func is running wait on the same call.
+*/
+void
+dbusmenu_server_set_populate_func (DbusmenuServer * server, DbusmenuMenuitem * item, DbusmenuServerPopulateFunc func, gpointer user_data, GDestroyNotify destroy)
+{
+	g_return_if_fail(DBUSMENU_IS_SERVER(server));
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(item));
+
+	if (func == NULL) {
+		g_object_set_data(G_OBJECT(item), data_populate, NULL);
+		return;
+	}
+
+	populate_t * populate = g_new0(populate_t, 1);
+	populate->server = server;
+	populate->id = dbusmenu_menuitem_get_id(item);
+	populate->func = func;
+	populate->user_data = user_data;
+	populate->destroy = destroy;
+	populate->running = FALSE;
+	populate->waiting = NULL;
+
+	g_object_add_weak_pointer(G_OBJECT(server), (gpointer *)&populate->server);
+
+	g_object_set_data_full(G_OBJECT(item), data_populate, populate, populate_free);
+	return;
+}
+
+/**
+	dbusmenu_server_populate_done:
+	@server: The #DbusmenuServer @item is shown through
+	@item: The #DbusmenuMenuitem whose children were built
+
+	Tells the clients waiting on the #DbusmenuServerPopulateFunc of
+	@item that its children are there.  They get the reply to their
+	AboutToShow with @item as needing an update.
+*/
+void
+dbusmenu_server_populate_done (DbusmenuServer * server, DbusmenuMenuitem * item)
+{
+	g_return_if_fail(DBUSMENU_IS_SERVER(server));
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(item));
+
+	populate_t * populate = g_object_get_data(G_OBJECT(item), data_populate);
+	if (populate == NULL || !populate->running) {
+		return;
+	}
+
+	populate_finish(populate, TRUE);
+	return;
+}
+
+/**
+	dbusmenu_server_set_source:
+	@server: The #DbusmenuServer @item is shown through
+	@item: The #DbusmenuMenuitem whose children come from @source
+	@source: (allow-none): The functions to get at the children, or %NULL to remove it
+	@user_data: Data passed to the functions in @source
+	@destroy: (allow-none): Frees @user_data when @source is dropped, see #DbusmenuServerSource
+
+	Serves the children of @item from @source instead of its
+	#DbusmenuMenuitem children.  No object is built for the items
+	in @source, their layout and properties are asked for only when
+	a client wants them and events sent to them go to its event
+	function.  The IDs in @source must not be used by any other
+	item on @server, and the items can't have children of their own.
+
+	Call #dbusmenu_server_source_changed whenever the items in
+	@source change.
+*/
+void
+dbusmenu_server_set_source (DbusmenuServer * server, DbusmenuMenuitem * item, const DbusmenuServerSource * source, gpointer user_data, GDestroyNotify destroy)
+{
+	g_return_if_fail(DBUSMENU_IS_SERVER(server));
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(item));
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	guint position;
+	if (source_find(server, item, &position) != NULL) {
+		g_ptr_array_remove_index_fast(priv->sources, position);
+	}
+
+	if (source != NULL) {
+		g_return_if_fail(source->get_n_items != NULL && source->get_id != NULL && source->lookup_id != NULL && source->get_properties != NULL);
+
+		source_t * newsource = g_new0(source_t, 1);
+		newsource->server = server;
+		newsource->parent = item;
+		g_object_weak_ref(G_OBJECT(item), source_parent_gone, newsource);
+		newsource->funcs = *source;
+		newsource->user_data = user_data;
+		newsource->destroy = destroy;
+
+		if (priv->sources == NULL) {
+			priv->sources = g_ptr_array_new_with_free_func(source_free);
+		}
+		g_ptr_array_add(priv->sources, newsource);
+
+		_dbusmenu_menuitem_set_build_children(item, source_build_children, newsource);
+	}
+
+	dbusmenu_server_source_changed(server, item);
+	return;
+}
+
+/**
+	dbusmenu_server_source_changed:
+	@server: The #DbusmenuServer @item is shown through
+	@item: The #DbusmenuMenuitem whose source changed
+
+	Tells the clients that the items in the source of @item were
+	added, removed or changed so that they get its layout again.
+*/
+void
+dbusmenu_server_source_changed (DbusmenuServer * server, DbusmenuMenuitem * item)
+{
+	g_return_if_fail(DBUSMENU_IS_SERVER(server));
+	g_return_if_fail(DBUSMENU_IS_MENUITEM(item));
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	/* Nothing to tell if it isn't in our tree */
+	if (item != priv->root && lookup_menuitem_by_id(server, dbusmenu_menuitem_get_id(item)) != item) {
+		return;
+	}
+
+	/* There's no edit that describes this */
+	priv->layout_edits_broken = TRUE;
+
+	layout_cache_invalidate(server, item);
+	layout_update_signal(server, item);
+	return;
+}
+
+/**
+	dbusmenu_server_get_stats:
+	@server: The #DbusmenuServer to get the counters of
+
+	Gets counters about the menu and the traffic it has caused on
+	the bus, to see why it might be slow.  The dictionary has
+	"items", "properties" and "property-bytes" for the size of the
+	tree, "layout-revision", "layout-calls" and "layout-bytes" for
+	the layout, "group-property-calls" for GetGroupProperties and
+	"property-signals", "property-entries" and
+	"properties-coalesced" for the changes that have been sent.
+
+	If the application is started with DBUSMENU_STATS set in its
+	environment the same dictionary can be read over DBus as the
+	Stats property of com.canonical.dbusmenu.Stats on the menu.
+
+	Return value: (transfer full): A #GVariant of type "a{sv}"
+*/
+GVariant *
+dbusmenu_server_get_stats (DbusmenuServer * server)
+{
+	g_return_val_if_fail(DBUSMENU_IS_SERVER(server), NULL);
+	DbusmenuServerPrivate * priv = DBUSMENU_SERVER_GET_PRIVATE(server);
+
+	guint items = 0;
+	guint properties = 0;
+	guint64 bytes = 0;
+
+	if (priv->root != NULL) {
+		_dbusmenu_menuitem_tree_stats(priv->root, &items, &properties, &bytes);
+	}
+
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+	g_variant_builder_add(&builder, "{sv}", "items", g_variant_new_uint32(items));
+	g_variant_builder_add(&builder, "{sv}", "properties", g_variant_new_uint32(properties));
+	g_variant_builder_add(&builder, "{sv}", "property-bytes", g_variant_new_uint64(bytes));
+	g_variant_builder_add(&builder, "{sv}", "layout-revision", g_variant_new_uint32(priv->layout_revision));
+	g_variant_builder_add(&builder, "{sv}", "layout-calls", g_variant_new_uint32(priv->layout_calls));
+	g_variant_builder_add(&builder, "{sv}", "layout-bytes", g_variant_new_uint64(priv->layout_bytes));
+	g_variant_builder_add(&builder, "{sv}", "group-property-calls", g_variant_new_uint32(priv->group_calls));
+	g_variant_builder_add(&builder, "{sv}", "property-signals", g_variant_new_uint32(priv->property_signals));
+	g_variant_builder_add(&builder, "{sv}", "property-entries", g_variant_new_uint32(priv->property_entries));
+	g_variant_builder_add(&builder, "{sv}", "properties-coalesced", g_variant_new_uint32(priv->property_coalesced));
+
+	return g_variant_ref_sink(g_variant_builder_end(&builder));
+}
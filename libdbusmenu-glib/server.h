@@ -105,6 +105,36 @@ G_BEGIN_DECLS
  * String to access property #DbusmenuServer:status
  */
 #define DBUSMENU_SERVER_PROP_STATUS            "status"
+/**
+ * DBUSMENU_SERVER_PROP_EMIT_INTERVAL:
+ *
+ * String to access property #DbusmenuServer:emit-interval
+ */
+#define DBUSMENU_SERVER_PROP_EMIT_INTERVAL     "emit-interval"
+/**
+ * DBUSMENU_SERVER_PROP_BATCH_LATENCY:
+ *
+ * String to access property #DbusmenuServer:batch-latency
+ */
+#define DBUSMENU_SERVER_PROP_BATCH_LATENCY     "batch-latency"
+/**
+ * DBUSMENU_SERVER_PROP_LAYOUT_MERGED:
+ *
+ * String to access property #DbusmenuServer:layout-updates-merged
+ */
+#define DBUSMENU_SERVER_PROP_LAYOUT_MERGED     "layout-updates-merged"
+/**
+ * DBUSMENU_SERVER_PROP_PROPERTY_MERGED:
+ *
+ * String to access property #DbusmenuServer:property-updates-merged
+ */
+#define DBUSMENU_SERVER_PROP_PROPERTY_MERGED   "property-updates-merged"
+/**
+ * DBUSMENU_SERVER_PROP_LAYOUT_EDITS:
+ *
+ * String to access property #DbusmenuServer:layout-edits
+ */
+#define DBUSMENU_SERVER_PROP_LAYOUT_EDITS      "layout-edits"
 
 typedef struct _DbusmenuServerPrivate DbusmenuServerPrivate;
 
@@ -158,6 +188,61 @@ struct _DbusmenuServer {
 	DbusmenuServerPrivate * priv;
 };
 
+/**
+	DbusmenuServerPopulateFunc:
+	@server: The #DbusmenuServer the item is shown through
+	@item: The #DbusmenuMenuitem that is about to be shown
+	@user_data: The data you gave us
+
+	Called when a client is about to show @item so that its
+	children can be built.  The reply to the client waits until
+	#dbusmenu_server_populate_done is called, which can be from
+	this function or later on.
+*/
+typedef void (*DbusmenuServerPopulateFunc) (DbusmenuServer * server, DbusmenuMenuitem * item, gpointer user_data);
+
+/**
+	DbusmenuServerSource:
+	@get_n_items: Returns how many items there are
+	@get_id: Returns the ID of the item at @index
+	@lookup_id: Returns the index of the item with @id or -1
+		if it isn't one of ours
+	@get_properties: Returns the properties of the item at @index
+		as an "a{sv}" #GVariant, floating or a full reference
+	@event: (allow-none): Handles an event sent to the item with @id
+	@reserved1: Reserved for future use, leave %NULL.
+	@reserved2: Reserved for future use, leave %NULL.
+	@reserved3: Reserved for future use, leave %NULL.
+	@reserved4: Reserved for future use, leave %NULL.
+
+	The functions a #DbusmenuServer uses to get at the children of
+	an item that aren't #DbusmenuMenuitem objects.  They all get
+	the @user_data given to #dbusmenu_server_set_source.  Only the
+	items a client asks for are looked at, so a source can serve
+	very long lists without building anything for each entry.
+
+	The server doesn't hold a reference on the item a source is set
+	on.  The source stays with the item while it's moved around the
+	tree or taken out of it, and is dropped, calling the destroy
+	function given for its user data, when the item is finalized,
+	when it's replaced or unset with #dbusmenu_server_set_source or
+	when the server goes away.
+*/
+typedef struct _DbusmenuServerSource DbusmenuServerSource;
+struct _DbusmenuServerSource {
+	guint      (*get_n_items)    (gpointer user_data);
+	gint       (*get_id)         (guint index, gpointer user_data);
+	gint       (*lookup_id)      (gint id, gpointer user_data);
+	GVariant * (*get_properties) (guint index, gpointer user_data);
+	void       (*event)          (gint id, const gchar * name, GVariant * value, guint timestamp, gpointer user_data);
+
+	/*< Private >*/
+	void (*reserved1) (void);
+	void (*reserved2) (void);
+	void (*reserved3) (void);
+	void (*reserved4) (void);
+};
+
 GType                   dbusmenu_server_get_type            (void);
 DbusmenuServer *        dbusmenu_server_new                 (const gchar *          object);
 void                    dbusmenu_server_set_root            (DbusmenuServer *       self,
@@ -171,6 +256,27 @@ void                    dbusmenu_server_set_status          (DbusmenuServer *
 GStrv                   dbusmenu_server_get_icon_paths      (DbusmenuServer *       server);
 void                    dbusmenu_server_set_icon_paths      (DbusmenuServer *       server,
                                                              GStrv                  icon_paths);
+void                    dbusmenu_server_set_populate_func   (DbusmenuServer *       server,
+                                                             DbusmenuMenuitem *     item,
+                                                             DbusmenuServerPopulateFunc func,
+                                                             gpointer               user_data,
+                                                             GDestroyNotify         destroy);
+void                    dbusmenu_server_populate_done       (DbusmenuServer *       server,
+                                                             DbusmenuMenuitem *     item);
+void                    dbusmenu_server_set_source          (DbusmenuServer *       server,
+                                                             DbusmenuMenuitem *     item,
+                                                             const DbusmenuServerSource * source,
+                                                             gpointer               user_data,
+                                                             GDestroyNotify         destroy);
+void                    dbusmenu_server_source_changed      (DbusmenuServer *       server,
+                                                             DbusmenuMenuitem *     item);
+gboolean                dbusmenu_server_save_snapshot       (DbusmenuServer *       server,
+                                                             const gchar *          filename,
+                                                             GError **              error);
+gboolean                dbusmenu_server_load_snapshot       (DbusmenuServer *       server,
+                                                             const gchar *          filename,
+                                                             GError **              error);
+GVariant *              dbusmenu_server_get_stats           (DbusmenuServer *       server);
 
 /**
 	SECTION:server
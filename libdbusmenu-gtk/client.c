@@ -32,6 +32,7 @@ License version 3 and version 2.1 along with this program.  If not, see
 
 #include <gtk/gtk.h>
 #include <glib.h>
+#include <glib/gi18n-lib.h>
 #include <atk/atk.h>
 
 #include "client.h"
@@ -63,6 +64,10 @@ static void item_activate (DbusmenuClient * client, DbusmenuMenuitem * mi, guint
 static void theme_dir_changed (DbusmenuClient * client, GStrv theme_dirs, gpointer userdata);
 static void remove_theme_dirs (GtkIconTheme * theme, GStrv dirs);
 static void event_result (DbusmenuClient * client, DbusmenuMenuitem * mi, const gchar * event, GVariant * variant, guint timestamp, GError * error);
+static void placeholder_changed (DbusmenuClient * client, DbusmenuMenuitem * mi, gboolean placeholder, gpointer userdata);
+static void process_placeholder (DbusmenuMenuitem * mi, DbusmenuGtkClient * gtkclient);
+static void more_children_changed (DbusmenuClient * client, DbusmenuMenuitem * mi, gboolean more, gpointer userdata);
+static void process_more (DbusmenuMenuitem * mi, DbusmenuGtkClient * gtkclient);
 
 static gboolean new_item_normal     (DbusmenuMenuitem * newitem, DbusmenuMenuitem * parent, DbusmenuClient * client, gpointer user_data);
 static gboolean new_item_seperator  (DbusmenuMenuitem * newitem, DbusmenuMenuitem * parent, DbusmenuClient * client, gpointer user_data);
@@ -70,6 +75,7 @@ static gboolean new_item_seperator  (DbusmenuMenuitem * newitem, DbusmenuMenuite
 static void process_visible (DbusmenuMenuitem * mi, GtkMenuItem * gmi, GVariant * value);
 static void process_sensitive (DbusmenuMenuitem * mi, GtkMenuItem * gmi, GVariant * value);
 static void image_property_handle (DbusmenuMenuitem * item, const gchar * property, GVariant * invalue, gpointer userdata);
+static void image_properties_handle (DbusmenuMenuitem * item, const gchar ** props, gpointer userdata);
 
 /* GObject Stuff */
 G_DEFINE_TYPE (DbusmenuGtkClient, dbusmenu_gtkclient, DBUSMENU_TYPE_CLIENT);
@@ -124,6 +130,8 @@ dbusmenu_gtkclient_init (DbusmenuGtkClient *self)
 	g_signal_connect(G_OBJECT(self), DBUSMENU_CLIENT_SIGNAL_ITEM_ACTIVATE, G_CALLBACK(item_activate), NULL);
 	g_signal_connect(G_OBJECT(self), DBUSMENU_CLIENT_SIGNAL_ICON_THEME_DIRS_CHANGED, G_CALLBACK(theme_dir_changed), NULL);
 	g_signal_connect(G_OBJECT(self), DBUSMENU_CLIENT_SIGNAL_EVENT_RESULT, G_CALLBACK(event_result), NULL);
+	g_signal_connect(G_OBJECT(self), DBUSMENU_CLIENT_SIGNAL_PLACEHOLDER_CHANGED, G_CALLBACK(placeholder_changed), NULL);
+	g_signal_connect(G_OBJECT(self), DBUSMENU_CLIENT_SIGNAL_MORE_CHILDREN_CHANGED, G_CALLBACK(more_children_changed), NULL);
 
 	theme_dir_changed(DBUSMENU_CLIENT(self), dbusmenu_client_get_icon_paths(DBUSMENU_CLIENT(self)), NULL);
 
@@ -470,6 +478,8 @@ static const gchar * data_menu =          "dbusmenugtk-data-gtkmenu";
 static const gchar * data_activating =    "dbusmenugtk-data-activating";
 static const gchar * data_idle_close_id = "dbusmenugtk-data-idle-close-id";
 static const gchar * data_delayed_close = "dbusmenugtk-data-delayed-close";
+static const gchar * data_placeholder =   "dbusmenugtk-data-placeholder";
+static const gchar * data_more =          "dbusmenugtk-data-more";
 
 static void
 menu_item_start_activating(DbusmenuMenuitem * mi)
@@ -571,6 +581,17 @@ menu_pressed_cb (GtkMenuItem * gmi, DbusmenuMenuitem * mi)
 	return TRUE;
 }
 
+/* When the pointer is over a submenu that is still showing its
+   placeholder, start getting the children before it opens. */
+static void
+menu_selected_cb (GtkMenuItem * gmi, DbusmenuMenuitem * mi)
+{
+	if (g_object_get_data(G_OBJECT(mi), data_placeholder) != NULL) {
+		dbusmenu_menuitem_send_about_to_show(mi, NULL, NULL);
+	}
+	return;
+}
+
 static gboolean
 close_in_idle (DbusmenuMenuitem * mi)
 {
@@ -713,16 +734,113 @@ process_submenu (DbusmenuMenuitem * mi, GtkMenuItem * gmi, GVariant * variant, D
 		/* We need to build a menu for these guys to live in. */
 		GtkMenu * menu = GTK_MENU(gtk_menu_new());
 		g_object_ref_sink(menu);
+		g_object_set_data(G_OBJECT(mi), data_placeholder, NULL);
+		g_object_set_data(G_OBJECT(mi), data_more, NULL);
 		g_object_set_data_full(G_OBJECT(mi), data_menu, menu, g_object_unref);
 
 		gtk_menu_item_set_submenu(gmi, GTK_WIDGET(menu));
 
 		g_signal_connect(menu, "notify::visible", G_CALLBACK(submenu_notify_visible_cb), mi);
+
+		process_placeholder(mi, gtkclient);
+		process_more(mi, gtkclient);
+	}
+
+	return;
+}
+
+/* Put an insensitive item in the menu of a placeholder so that
+   it can open right away while its children are fetched, and
+   take it out again when they're in. */
+static void
+process_placeholder (DbusmenuMenuitem * mi, DbusmenuGtkClient * gtkclient)
+{
+	gpointer pmenu = g_object_get_data(G_OBJECT(mi), data_menu);
+	GtkWidget * loading = GTK_WIDGET(g_object_get_data(G_OBJECT(mi), data_placeholder));
+
+	gboolean needed = pmenu != NULL
+		&& dbusmenu_menuitem_get_children(mi) == NULL
+		&& dbusmenu_client_is_placeholder(DBUSMENU_CLIENT(gtkclient), mi);
+
+	if (needed && loading == NULL) {
+		loading = gtk_menu_item_new_with_label(C_("submenu still loading", "..."));
+		gtk_widget_set_sensitive(loading, FALSE);
+		gtk_widget_show(loading);
+		gtk_menu_shell_append(GTK_MENU_SHELL(pmenu), loading);
+		g_object_set_data_full(G_OBJECT(mi), data_placeholder, g_object_ref(loading), g_object_unref);
+	} else if (!needed && loading != NULL) {
+		gtk_widget_destroy(loading);
+		g_object_set_data(G_OBJECT(mi), data_placeholder, NULL);
+	}
+
+	return;
+}
+
+/* The client got the children of a placeholder, or made a
+   submenu into one */
+static void
+placeholder_changed (DbusmenuClient * client, DbusmenuMenuitem * mi, gboolean placeholder, gpointer userdata)
+{
+	if (g_object_get_data(G_OBJECT(mi), data_menuitem) == NULL) {
+		return;
+	}
+
+	process_placeholder(mi, DBUSMENU_GTKCLIENT(client));
+	return;
+}
+
+/* The pointer got to the end of a submenu that only has some
+   of its children, get the next page of them. */
+static void
+more_selected_cb (GtkMenuItem * gmi, DbusmenuGtkClient * gtkclient)
+{
+	DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(g_object_get_data(G_OBJECT(gmi), data_more));
+	if (mi != NULL) {
+		dbusmenu_client_fetch_more_children(DBUSMENU_CLIENT(gtkclient), mi);
+	}
+	return;
+}
+
+/* Put an item at the end of the menu of a submenu that has more
+   children to fetch, selecting it fetches them, and take it out
+   when they're all in. */
+static void
+process_more (DbusmenuMenuitem * mi, DbusmenuGtkClient * gtkclient)
+{
+	gpointer pmenu = g_object_get_data(G_OBJECT(mi), data_menu);
+	GtkWidget * more = GTK_WIDGET(g_object_get_data(G_OBJECT(mi), data_more));
+
+	gboolean needed = pmenu != NULL
+		&& dbusmenu_client_has_more_children(DBUSMENU_CLIENT(gtkclient), mi);
+
+	if (needed && more == NULL) {
+		more = gtk_menu_item_new_with_label(C_("submenu has more items", "More..."));
+		g_object_set_data(G_OBJECT(more), data_more, mi);
+		g_signal_connect(more, "select", G_CALLBACK(more_selected_cb), gtkclient);
+		gtk_widget_show(more);
+		gtk_menu_shell_append(GTK_MENU_SHELL(pmenu), more);
+		g_object_set_data_full(G_OBJECT(mi), data_more, g_object_ref(more), g_object_unref);
+	} else if (!needed && more != NULL) {
+		gtk_widget_destroy(more);
+		g_object_set_data(G_OBJECT(mi), data_more, NULL);
 	}
 
 	return;
 }
 
+/* The client got the last children of a submenu, or only the
+   first page of them */
+static void
+more_children_changed (DbusmenuClient * client, DbusmenuMenuitem * mi, gboolean more, gpointer userdata)
+{
+	if (g_object_get_data(G_OBJECT(mi), data_menuitem) == NULL) {
+		return;
+	}
+
+	process_more(mi, DBUSMENU_GTKCLIENT(client));
+	return;
+}
+
 /* Process the disposition changing */
 static void
 process_disposition (DbusmenuMenuitem * mi, GtkMenuItem * gmi, GVariant * variant, DbusmenuGtkClient * gtkclient)
@@ -806,6 +924,31 @@ menu_prop_change_cb (DbusmenuMenuitem * mi, gchar * prop, GVariant * variant, Db
 	return;
 }
 
+/* All the properties that changed in one update, so that the
+   GTK item gets updated once for each of them and the shortcut
+   is only refreshed once no matter how many are set. */
+static void
+menu_props_change_cb (DbusmenuMenuitem * mi, const gchar ** props, DbusmenuGtkClient * gtkclient)
+{
+	gboolean shortcut = FALSE;
+	guint i;
+
+	for (i = 0; props[i] != NULL; i++) {
+		if (!g_strcmp0(props[i], DBUSMENU_MENUITEM_PROP_SHORTCUT)) {
+			shortcut = TRUE;
+			continue;
+		}
+
+		menu_prop_change_cb(mi, (gchar *)props[i], dbusmenu_menuitem_property_get_variant(mi, props[i]), gtkclient);
+	}
+
+	if (shortcut) {
+		refresh_shortcut(gtkclient, mi);
+	}
+
+	return;
+}
+
 /* The new menuitem signal only happens if we don't have a type handler
    for the type of the item.  This should be an error condition and we're
    printing out a message. */
@@ -920,12 +1063,13 @@ dbusmenu_gtkclient_newitem_base (DbusmenuGtkClient * client, DbusmenuMenuitem *
 	g_object_set_data_full(G_OBJECT(item), data_menuitem, gmi, (GDestroyNotify)destroy_gmi);
 
 	/* DbusmenuMenuitem signals */
-	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, G_CALLBACK(menu_prop_change_cb), client);
+	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED, G_CALLBACK(menu_props_change_cb), client);
 	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_CHILD_REMOVED, G_CALLBACK(delete_child), client);
 	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_CHILD_MOVED,   G_CALLBACK(move_child),   client);
 
 	/* GtkMenuitem signals */
 	g_signal_connect(G_OBJECT(gmi), "activate", G_CALLBACK(menu_pressed_cb), item);
+	g_signal_connect(G_OBJECT(gmi), "select", G_CALLBACK(menu_selected_cb), item);
 
 	/* Check our set of props to see if any are set already */
 	process_visible(item, gmi, dbusmenu_menuitem_property_get_variant(item, DBUSMENU_MENUITEM_PROP_VISIBLE));
@@ -970,6 +1114,8 @@ new_child (DbusmenuMenuitem * mi, DbusmenuMenuitem * child, guint position, Dbus
 
 	GtkMenuItem * childmi  = dbusmenu_gtkclient_menuitem_get(gtkclient, child);
 	gtk_menu_shell_insert(GTK_MENU_SHELL(menu), GTK_WIDGET(childmi), position);
+
+	process_placeholder(mi, gtkclient);
 	
 	return;
 }
@@ -985,6 +1131,8 @@ delete_child (DbusmenuMenuitem * mi, DbusmenuMenuitem * child, DbusmenuGtkClient
 		GtkMenu * menu = GTK_MENU(ann_menu);
 
 		if (menu != NULL) {
+			g_object_set_data(G_OBJECT(mi), data_placeholder, NULL);
+			g_object_set_data(G_OBJECT(mi), data_more, NULL);
 			gtk_widget_destroy(GTK_WIDGET(menu));
 			g_object_steal_data(G_OBJECT(mi), data_menu);
 		}
@@ -1107,8 +1255,8 @@ new_item_normal (DbusmenuMenuitem * newitem, DbusmenuMenuitem * parent, Dbusmenu
 	                      dbusmenu_menuitem_property_get_variant(newitem, DBUSMENU_MENUITEM_PROP_ICON_DATA),
 	                      client);
 	g_signal_connect(G_OBJECT(newitem),
-	                 DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED,
-	                 G_CALLBACK(image_property_handle),
+	                 DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED,
+	                 G_CALLBACK(image_properties_handle),
 	                 client);
 
 	return TRUE;
@@ -1291,3 +1439,17 @@ image_property_handle (DbusmenuMenuitem * item, const gchar * property, GVariant
 	return;
 }
 
+/* Image properties out of a batch of changes, in the order
+   they were set */
+static void
+image_properties_handle (DbusmenuMenuitem * item, const gchar ** props, gpointer userdata)
+{
+	guint i;
+
+	for (i = 0; props[i] != NULL; i++) {
+		image_property_handle(item, props[i], dbusmenu_menuitem_property_get_variant(item, props[i]), userdata);
+	}
+
+	return;
+}
+
@@ -0,0 +1,328 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* Changes a property on an item and times the ItemsPropertiesUpdated
+   signals that come out of it:
+
+   STEP_IMMEDIATE: without an interval two changes go out together
+                   on the next idle.
+   STEP_INTERVAL:  changes spread over the interval go out as one
+                   signal, no sooner than the interval after the last.
+   STEP_LATENCY:   a change inside a long interval goes out when the
+                   batch latency is up instead.
+   STEP_EDITS:     a change while layout edits are waiting out their
+                   interval goes out after them, it doesn't hurry
+                   them along. */
+#define TEST_ID        1
+#define TEST_PROP      "x-test"
+#define INTERVAL_MS    400
+#define LONG_MS        1000
+#define LATENCY_MS     150
+#define SLACK_MS       50
+
+typedef enum {
+	STEP_EXPORT,
+	STEP_IMMEDIATE,
+	STEP_INTERVAL_FIRST,
+	STEP_INTERVAL,
+	STEP_LATENCY,
+	STEP_EDITS_FIRST,
+	STEP_EDITS,
+	STEP_DONE
+} step_t;
+
+static DbusmenuServer * server = NULL;
+static DbusmenuMenuitem * item = NULL;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+static step_t step = STEP_EXPORT;
+static gint64 step_start = 0;
+static gint next_value = 0;
+static gboolean layout_sent = FALSE;
+
+static void get_layout (void);
+
+/* Gets the value of TEST_PROP on TEST_ID out of a signal, -1 if
+   it isn't in there */
+static gint
+signal_value (GVariant * params)
+{
+	GVariant * updated = g_variant_get_child_value(params, 0);
+	GVariantIter iter;
+	gint id;
+	GVariant * props;
+	gint value = -1;
+
+	g_variant_iter_init(&iter, updated);
+	while (g_variant_iter_loop(&iter, "(i@a{sv})", &id, &props)) {
+		if (id == TEST_ID) {
+			g_variant_lookup(props, TEST_PROP, "i", &value);
+		}
+	}
+
+	g_variant_unref(updated);
+	return value;
+}
+
+static void
+set_value (gint value)
+{
+	dbusmenu_menuitem_property_set_int(item, TEST_PROP, value);
+	return;
+}
+
+/* Changes the value a couple more times while the interval
+   is running, up to 13 */
+static gboolean
+interval_change (gpointer user_data)
+{
+	set_value(next_value++);
+	return next_value <= 13;
+}
+
+/* Puts a new item on the end of the root */
+static void
+add_item (gint id)
+{
+	DbusmenuMenuitem * newitem = dbusmenu_menuitem_new_with_id(id);
+	dbusmenu_menuitem_property_set(newitem, DBUSMENU_MENUITEM_PROP_LABEL, "Edit");
+	dbusmenu_menuitem_child_append(dbusmenu_menuitem_get_parent(item), newitem);
+	g_object_unref(newitem);
+	return;
+}
+
+/* Once the first edit has gone out the next one has to wait for
+   a long interval, and the property change made right away has to
+   wait for it.  Without an interval of its own it'd go out on the
+   next idle if nothing held it. */
+static void
+layout_updated (DbusmenuServer * srv, guint revision, gint parent, gpointer user_data)
+{
+	switch (step) {
+	case STEP_EDITS_FIRST:
+		step = STEP_EDITS;
+		step_start = g_get_monotonic_time();
+
+		g_object_set(G_OBJECT(srv), DBUSMENU_SERVER_PROP_EMIT_INTERVAL, LONG_MS, NULL);
+		add_item(TEST_ID + 2);
+
+		g_object_set(G_OBJECT(srv), DBUSMENU_SERVER_PROP_EMIT_INTERVAL, 0, NULL);
+		set_value(30);
+		break;
+	case STEP_EDITS:
+		layout_sent = TRUE;
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+/* Checks each signal against what the step should have sent */
+static void
+properties_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	gint value = signal_value(params);
+	gint64 now = g_get_monotonic_time();
+	gint64 elapsed = (now - step_start) / 1000;
+
+	switch (step) {
+	case STEP_IMMEDIATE:
+		if (value != 2 || elapsed > SLACK_MS * 2) {
+			g_warning("Immediate signal had %d after %d ms", value, (gint)elapsed);
+			passed = FALSE;
+		}
+
+		g_object_set(G_OBJECT(server),
+		             DBUSMENU_SERVER_PROP_EMIT_INTERVAL, INTERVAL_MS,
+		             DBUSMENU_SERVER_PROP_BATCH_LATENCY, 0,
+		             NULL);
+		step = STEP_INTERVAL_FIRST;
+		set_value(10);
+		break;
+	case STEP_INTERVAL_FIRST:
+		/* Times the next one from here */
+		step = STEP_INTERVAL;
+		step_start = now;
+		next_value = 11;
+		set_value(next_value++);
+		g_timeout_add(INTERVAL_MS / 4, interval_change, NULL);
+		break;
+	case STEP_INTERVAL:
+		/* Has to have waited for every change of the interval */
+		if (value != 13 || elapsed < INTERVAL_MS - SLACK_MS) {
+			g_warning("Interval signal had %d after %d ms", value, (gint)elapsed);
+			passed = FALSE;
+		}
+
+		g_object_set(G_OBJECT(server),
+		             DBUSMENU_SERVER_PROP_EMIT_INTERVAL, LONG_MS,
+		             DBUSMENU_SERVER_PROP_BATCH_LATENCY, LATENCY_MS,
+		             NULL);
+		step = STEP_LATENCY;
+		step_start = g_get_monotonic_time();
+		set_value(20);
+		break;
+	case STEP_LATENCY:
+		if (value != 20 || elapsed < LATENCY_MS - SLACK_MS || elapsed > LONG_MS - SLACK_MS) {
+			g_warning("Latency signal had %d after %d ms", value, (gint)elapsed);
+			passed = FALSE;
+		}
+
+		/* Edits need the layout to have just gone out to have an
+		   interval to wait for, that starts from the next one */
+		g_object_set(G_OBJECT(server),
+		             DBUSMENU_SERVER_PROP_EMIT_INTERVAL, 0,
+		             DBUSMENU_SERVER_PROP_BATCH_LATENCY, 0,
+		             DBUSMENU_SERVER_PROP_LAYOUT_EDITS, TRUE,
+		             NULL);
+		step = STEP_EDITS_FIRST;
+		add_item(TEST_ID + 1);
+		break;
+	case STEP_EDITS:
+		if (value != 30 || !layout_sent || elapsed < LONG_MS - SLACK_MS) {
+			g_warning("Edits signal had %d after %d ms %s the layout", value, (gint)elapsed, layout_sent ? "after" : "before");
+			passed = FALSE;
+		}
+
+		step = STEP_DONE;
+		g_main_loop_quit(mainloop);
+		break;
+	default:
+		g_warning("Unexpected signal with %d", value);
+		passed = FALSE;
+		break;
+	}
+
+	return;
+}
+
+/* Start changing things once the item has been sent, before
+   that its properties don't go out */
+static gboolean
+get_layout_retry (gpointer user_data)
+{
+	get_layout();
+	return FALSE;
+}
+
+static void
+get_layout_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), res, &error);
+
+	if (error != NULL) {
+		/* Not on the bus yet */
+		g_error_free(error);
+		g_timeout_add(100, get_layout_retry, NULL);
+		return;
+	}
+
+	g_variant_unref(reply);
+
+	/* Two changes in one go, one signal without any delay */
+	step = STEP_IMMEDIATE;
+	step_start = g_get_monotonic_time();
+	set_value(1);
+	set_value(2);
+
+	return;
+}
+
+/* Gets the layout from the server the way a client would */
+static void
+get_layout (void)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	g_dbus_connection_call(bus,
+	                       g_dbus_connection_get_unique_name(bus),
+	                       "/org/test",
+	                       "com.canonical.dbusmenu",
+	                       "GetLayout",
+	                       g_variant_new("(ii@as)", 0, -1, g_variant_new_strv(NULL, 0)),
+	                       G_VARIANT_TYPE("(u(ia{sv}av))"),
+	                       G_DBUS_CALL_FLAGS_NONE,
+	                       -1, NULL,
+	                       get_layout_cb, NULL);
+
+	g_object_unref(bus);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.  Got to: %d", step);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "ItemsPropertiesUpdated", /* member */
+	                                   "/org/test", /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   properties_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	item = dbusmenu_menuitem_new_with_id(TEST_ID);
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, "Test");
+	dbusmenu_menuitem_child_append(root, item);
+
+	dbusmenu_server_set_root(server, root);
+	g_signal_connect(G_OBJECT(server), DBUSMENU_SERVER_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	get_layout();
+	g_timeout_add_seconds(10, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(item));
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
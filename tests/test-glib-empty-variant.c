@@ -0,0 +1,183 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "callgrind.h"
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* Enough items and calls that a per item cost stands out
+   against the cost of the calls themselves */
+#define EMPTY_ITEMS       2000
+#define EMPTY_CALLS       10
+#define EMPTY_FIRST_ID    100
+
+static guint callson = 0;
+static gboolean passed = TRUE;
+static DbusmenuMenuitem * root = NULL;
+static GDBusConnection * bus = NULL;
+static GMainLoop * mainloop = NULL;
+
+static void next_call (void);
+
+/* Every item has to have come back without any properties */
+static void
+call_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * ret = g_dbus_connection_call_finish(bus, res, &error);
+
+	if (error != NULL) {
+		g_warning("Call %d failed: %s", callson, error->message);
+		g_error_free(error);
+		passed = FALSE;
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (g_variant_is_of_type(ret, G_VARIANT_TYPE("(a(ia{sv}))"))) {
+		GVariant * items = g_variant_get_child_value(ret, 0);
+		if (g_variant_n_children(items) != EMPTY_ITEMS) {
+			g_warning("Got properties for %d items", (gint)g_variant_n_children(items));
+			passed = FALSE;
+		}
+		g_variant_unref(items);
+	} else {
+		GVariant * layout = g_variant_get_child_value(ret, 1);
+		GVariant * children = g_variant_get_child_value(layout, 2);
+		if (g_variant_n_children(children) != EMPTY_ITEMS) {
+			g_warning("Got a layout with %d items", (gint)g_variant_n_children(children));
+			passed = FALSE;
+		}
+		g_variant_unref(children);
+		g_variant_unref(layout);
+	}
+
+	g_variant_unref(ret);
+
+	callson++;
+	next_call();
+	return;
+}
+
+/* Let the property signal with nothing but removals go out
+   and then stop counting */
+static gboolean
+stop_func (gpointer data)
+{
+	g_debug("Dumping callgrind data");
+	CALLGRIND_DUMP_STATS_AT("empty");
+	CALLGRIND_STOP_INSTRUMENTATION;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Alternate between GetLayout and GetGroupProperties asking for
+   a property no one has, a different one each time so that the
+   server can't just hand back what it sent last time */
+static void
+next_call (void)
+{
+	if (callson >= EMPTY_CALLS * 2) {
+		GList * child;
+		for (child = dbusmenu_menuitem_get_children(root); child != NULL; child = g_list_next(child)) {
+			dbusmenu_menuitem_property_remove(DBUSMENU_MENUITEM(child->data), "x-empty");
+		}
+		g_timeout_add(250, stop_func, NULL);
+		return;
+	}
+
+	gchar * missing = g_strdup_printf("x-missing-%d", callson);
+	const gchar * props[2] = { missing, NULL };
+	GVariant * params;
+
+	if (callson % 2 == 0) {
+		params = g_variant_new("(ii^as)", 0, -1, props);
+		g_dbus_connection_call(bus, g_dbus_connection_get_unique_name(bus), "/org/test",
+		                       "com.canonical.dbusmenu", "GetLayout", params,
+		                       G_VARIANT_TYPE("(u(ia{sv}av))"), G_DBUS_CALL_FLAGS_NONE,
+		                       -1, NULL, call_cb, NULL);
+	} else {
+		GVariantBuilder ids;
+		guint i;
+		g_variant_builder_init(&ids, G_VARIANT_TYPE("ai"));
+		for (i = 0; i < EMPTY_ITEMS; i++) {
+			g_variant_builder_add(&ids, "i", EMPTY_FIRST_ID + i);
+		}
+		params = g_variant_new("(ai^as)", &ids, props);
+		g_dbus_connection_call(bus, g_dbus_connection_get_unique_name(bus), "/org/test",
+		                       "com.canonical.dbusmenu", "GetGroupProperties", params,
+		                       G_VARIANT_TYPE("(a(ia{sv}))"), G_DBUS_CALL_FLAGS_NONE,
+		                       -1, NULL, call_cb, NULL);
+	}
+
+	g_free(missing);
+	return;
+}
+
+static gboolean
+start_func (gpointer data)
+{
+	g_debug("Starting Callgrind");
+	CALLGRIND_START_INSTRUMENTATION;
+	CALLGRIND_ZERO_STATS;
+	CALLGRIND_TOGGLE_COLLECT;
+
+	next_call();
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	guint i;
+
+	bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	root = dbusmenu_menuitem_new_with_id(0);
+
+	for (i = 0; i < EMPTY_ITEMS; i++) {
+		DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(EMPTY_FIRST_ID + i);
+		dbusmenu_menuitem_property_set_bool(mi, "x-empty", TRUE);
+		dbusmenu_menuitem_child_append(root, mi);
+		g_object_unref(G_OBJECT(mi));
+	}
+
+	dbusmenu_server_set_root(server, root);
+
+	/* Give the server a chance to get on the bus */
+	g_timeout_add(500, start_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,273 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-bench.h"
+
+static guint stepon = 0;
+static GArray * order = NULL;
+static DbusmenuMenuitem * submenu = NULL;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+
+static gint64 update_start = 0;
+static guint moves = 0;
+static guint adds = 0;
+static guint removes = 0;
+
+/* The reconcile time the client had at the last update, and what
+   the steps after each build took at the smallest and largest size */
+static guint64 reconcile_seen = 0;
+static guint64 small_usec = 0;
+static guint64 large_usec = 0;
+
+/* Counting what the client did to the submenu */
+static void
+child_moved (DbusmenuMenuitem * mi, DbusmenuMenuitem * child, guint newpos, guint oldpos, gpointer data)
+{
+	moves++;
+	return;
+}
+
+static void
+child_added (DbusmenuMenuitem * mi, DbusmenuMenuitem * child, guint pos, gpointer data)
+{
+	adds++;
+	return;
+}
+
+static void
+child_removed (DbusmenuMenuitem * mi, DbusmenuMenuitem * child, gpointer data)
+{
+	removes++;
+	return;
+}
+
+/* Start the clock when the server tells us things changed */
+static void
+layout_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	update_start = g_get_monotonic_time();
+	return;
+}
+
+static gboolean
+verify_order (DbusmenuMenuitem * mi)
+{
+	GList * children = dbusmenu_menuitem_get_children(mi);
+	guint i;
+
+	for (i = 0; i < order->len; i++, children = g_list_next(children)) {
+		if (children == NULL) {
+			g_debug("Failed as there are only %d children, expected %d", i, order->len);
+			return FALSE;
+		}
+
+		if (dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data)) != g_array_index(order, gint, i)) {
+			g_debug("Failed as child %d has ID %d instead of %d", i, dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data)), g_array_index(order, gint, i));
+			return FALSE;
+		}
+	}
+
+	if (children != NULL) {
+		g_debug("Failed as there are more than %d children", order->len);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Gets how long the client spent reconciling since it was last
+   asked */
+static guint64
+reconcile_delta (DbusmenuClient * client)
+{
+	guint64 usec = 0;
+
+	GVariant * stats = dbusmenu_client_get_stats(client);
+	g_variant_lookup(stats, "reconcile-usec", "t", &usec);
+	g_variant_unref(stats);
+
+	guint64 delta = usec - reconcile_seen;
+	reconcile_seen = usec;
+	return delta;
+}
+
+/* The number of children in the last steps */
+static guint
+largest_size (void)
+{
+	guint i = 0;
+	while (bench_steps[i + 1].type != BENCH_STEP_END) {
+		i++;
+	}
+	return bench_steps[i].size;
+}
+
+/* Checks that the reconcile time grew with the number of children
+   and not faster */
+static void
+linear_check (void)
+{
+	guint small = bench_steps[0].size;
+	guint large = largest_size();
+
+	gdouble growth = (gdouble)large_usec / (gdouble)MAX(small_usec, BENCH_MIN_USEC);
+	gdouble limit = (gdouble)BENCH_LINEAR_SLACK * large / small;
+
+	g_print("{\"small\": %d, \"small-usec\": %" G_GUINT64_FORMAT ", \"large\": %d, \"large-usec\": %" G_GUINT64_FORMAT ", \"growth\": %.2f, \"limit\": %.2f}\n",
+	        small, small_usec, large, large_usec, growth, limit);
+
+	if (small == large) {
+		g_debug("Failed as only one size was run");
+		passed = FALSE;
+	} else if (growth > limit) {
+		g_debug("Failed as the reconcile grew %.2f times from %d to %d children", growth, small, large);
+		passed = FALSE;
+	}
+
+	return;
+}
+
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	gint64 elapsed = g_get_monotonic_time() - update_start;
+	guint64 reconcile = reconcile_delta(client);
+
+	DbusmenuMenuitem * menuroot = dbusmenu_client_get_root(client);
+	if (menuroot == NULL) {
+		g_debug("Root NULL, waiting");
+		return;
+	}
+
+	if (submenu == NULL) {
+		GList * children = dbusmenu_menuitem_get_children(menuroot);
+		if (children == NULL) {
+			g_debug("No submenu yet, waiting");
+			return;
+		}
+
+		submenu = DBUSMENU_MENUITEM(children->data);
+		g_signal_connect(G_OBJECT(submenu), DBUSMENU_MENUITEM_SIGNAL_CHILD_MOVED, G_CALLBACK(child_moved), NULL);
+		g_signal_connect(G_OBJECT(submenu), DBUSMENU_MENUITEM_SIGNAL_CHILD_ADDED, G_CALLBACK(child_added), NULL);
+		g_signal_connect(G_OBJECT(submenu), DBUSMENU_MENUITEM_SIGNAL_CHILD_REMOVED, G_CALLBACK(child_removed), NULL);
+	}
+
+	/* The server may tell us about the same layout more than once
+	   while we're connecting, only count real changes. */
+	if (stepon > 0 && moves == 0 && adds == 0 && removes == 0) {
+		g_debug("Nothing changed, waiting");
+		return;
+	}
+
+	bench_step_t * step = &bench_steps[stepon];
+	guint oldlen = order->len;
+	bench_step_apply(step, order);
+
+	if (!verify_order(submenu)) {
+		g_debug("Failed step %d: %s", stepon, step->name);
+		passed = FALSE;
+	}
+
+	gint expected = bench_step_moves(step, order);
+	if (expected >= 0 && expected != moves) {
+		g_debug("Failed step %d: %s moved %d children, expected %d", stepon, step->name, moves, expected);
+		passed = FALSE;
+	}
+
+	if (step->type != BENCH_STEP_BUILD && oldlen + adds - removes != order->len) {
+		g_debug("Failed step %d: %s added %d and removed %d children", stepon, step->name, adds, removes);
+		passed = FALSE;
+	}
+
+	g_print("{\"step\": \"%s\", \"children\": %d, \"moves\": %d, \"adds\": %d, \"removes\": %d, \"usec\": %" G_GINT64_FORMAT "}\n",
+	        step->name, order->len, moves, adds, removes, elapsed);
+
+	/* The builds make every child, only time reconciling them */
+	if (step->type != BENCH_STEP_BUILD) {
+		if (step->size == bench_steps[0].size) {
+			small_usec += reconcile;
+		} else if (step->size == largest_size()) {
+			large_usec += reconcile;
+		}
+	}
+
+	moves = 0;
+	adds = 0;
+	removes = 0;
+	stepon++;
+
+	if (bench_steps[stepon].type == BENCH_STEP_END) {
+		linear_check();
+		g_main_loop_quit(mainloop);
+	}
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.  Got to: %d", stepon);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	order = g_array_new(FALSE, FALSE, sizeof(gint));
+
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "LayoutUpdated", /* member */
+	                                   "/org/test", /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   layout_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(120, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
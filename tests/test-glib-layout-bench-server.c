@@ -0,0 +1,127 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-bench.h"
+
+static guint stepon = 0;
+static GArray * order = NULL;
+static GHashTable * items = NULL;
+static DbusmenuMenuitem * submenu = NULL;
+static DbusmenuServer * server = NULL;
+static GMainLoop * mainloop = NULL;
+
+/* Get the item for an ID, keeping them around so that the
+   same item gets reused across steps */
+static DbusmenuMenuitem *
+get_item (gint id)
+{
+	DbusmenuMenuitem * mi = g_hash_table_lookup(items, GINT_TO_POINTER(id));
+
+	if (mi == NULL) {
+		gchar * label = g_strdup_printf("Item %d", id);
+		mi = dbusmenu_menuitem_new_with_id(id);
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, label);
+		g_hash_table_insert(items, GINT_TO_POINTER(id), mi);
+		g_free(label);
+	}
+
+	return mi;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	bench_step_t * step = &bench_steps[stepon];
+
+	if (step->type == BENCH_STEP_END) {
+		g_main_loop_quit(mainloop);
+		return FALSE;
+	}
+	g_debug("Step %d: %s with %d children", stepon, step->name, step->size);
+
+	bench_step_apply(step, order);
+
+	/* Rebuild the children in the new order, the client only
+	   sees the final layout so it has to figure out the moves. */
+	GList * children = dbusmenu_menuitem_take_children(submenu);
+	g_list_free_full(children, g_object_unref);
+
+	guint i;
+	for (i = 0; i < order->len; i++) {
+		dbusmenu_menuitem_child_append(submenu, get_item(g_array_index(order, gint, i)));
+	}
+
+	stepon++;
+
+	return TRUE;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	server = dbusmenu_server_new("/org/test");
+
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	submenu = dbusmenu_menuitem_new_with_id(BENCH_SUBMENU_ID);
+	dbusmenu_menuitem_property_set(submenu, DBUSMENU_MENUITEM_PROP_LABEL, "Submenu");
+	dbusmenu_menuitem_child_append(root, submenu);
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	timer_func(NULL);
+	g_timeout_add(1500, timer_func, NULL);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	order = g_array_new(FALSE, FALSE, sizeof(gint));
+	items = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_object_unref);
+
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_debug("Quiting");
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The ID of the submenu that holds all the children being
+   shuffled around, and the first ID used for those children. */
+#define BENCH_SUBMENU_ID  1
+#define BENCH_FIRST_ID    100
+
+/* How much more the reconcile can cost per child at the largest
+   size than at the smallest before it's no longer linear, and the
+   least time we count for the smallest size so that timer noise
+   on a quick run doesn't make it fail. */
+#define BENCH_LINEAR_SLACK  3
+#define BENCH_MIN_USEC      1000
+
+typedef enum _bench_step_type_t bench_step_type_t;
+enum _bench_step_type_t {
+	BENCH_STEP_BUILD,
+	BENCH_STEP_ROTATE,
+	BENCH_STEP_SWAP_ENDS,
+	BENCH_STEP_REVERSE,
+	BENCH_STEP_INSERT_MIDDLE,
+	BENCH_STEP_REMOVE_ODD,
+	BENCH_STEP_END
+};
+
+typedef struct _bench_step_t bench_step_t;
+struct _bench_step_t {
+	bench_step_type_t type;
+	guint size;
+	const gchar * name;
+};
+
+bench_step_t bench_steps[] = {
+	{type: BENCH_STEP_BUILD,         size: 1000, name: "build"},
+	{type: BENCH_STEP_ROTATE,        size: 1000, name: "rotate"},
+	{type: BENCH_STEP_SWAP_ENDS,     size: 1000, name: "swap-ends"},
+	{type: BENCH_STEP_INSERT_MIDDLE, size: 1000, name: "insert-middle"},
+	{type: BENCH_STEP_REMOVE_ODD,    size: 1000, name: "remove-odd"},
+	{type: BENCH_STEP_REVERSE,       size: 1000, name: "reverse"},
+	{type: BENCH_STEP_BUILD,         size: 2500, name: "build"},
+	{type: BENCH_STEP_ROTATE,        size: 2500, name: "rotate"},
+	{type: BENCH_STEP_SWAP_ENDS,     size: 2500, name: "swap-ends"},
+	{type: BENCH_STEP_INSERT_MIDDLE, size: 2500, name: "insert-middle"},
+	{type: BENCH_STEP_REMOVE_ODD,    size: 2500, name: "remove-odd"},
+	{type: BENCH_STEP_REVERSE,       size: 2500, name: "reverse"},
+	{type: BENCH_STEP_BUILD,         size: 5000, name: "build"},
+	{type: BENCH_STEP_ROTATE,        size: 5000, name: "rotate"},
+	{type: BENCH_STEP_SWAP_ENDS,     size: 5000, name: "swap-ends"},
+	{type: BENCH_STEP_INSERT_MIDDLE, size: 5000, name: "insert-middle"},
+	{type: BENCH_STEP_REMOVE_ODD,    size: 5000, name: "remove-odd"},
+	{type: BENCH_STEP_REVERSE,       size: 5000, name: "reverse"},
+	{type: BENCH_STEP_END,           size: 0,    name: NULL}
+};
+
+/* Applies a step to the list of child IDs in @order */
+static inline void
+bench_step_apply (const bench_step_t * step, GArray * order)
+{
+	gint first, last, newid;
+	guint i;
+
+	switch (step->type) {
+	case BENCH_STEP_BUILD:
+		g_array_set_size(order, 0);
+		for (i = 0; i < step->size; i++) {
+			gint id = BENCH_FIRST_ID + i;
+			g_array_append_val(order, id);
+		}
+		break;
+	case BENCH_STEP_ROTATE:
+		last = g_array_index(order, gint, order->len - 1);
+		g_array_remove_index(order, order->len - 1);
+		g_array_prepend_val(order, last);
+		break;
+	case BENCH_STEP_SWAP_ENDS:
+		first = g_array_index(order, gint, 0);
+		g_array_index(order, gint, 0) = g_array_index(order, gint, order->len - 1);
+		g_array_index(order, gint, order->len - 1) = first;
+		break;
+	case BENCH_STEP_REVERSE:
+		for (i = 0; i < order->len / 2; i++) {
+			first = g_array_index(order, gint, i);
+			g_array_index(order, gint, i) = g_array_index(order, gint, order->len - 1 - i);
+			g_array_index(order, gint, order->len - 1 - i) = first;
+		}
+		break;
+	case BENCH_STEP_INSERT_MIDDLE:
+		newid = BENCH_FIRST_ID + step->size;
+		g_array_insert_val(order, order->len / 2, newid);
+		break;
+	case BENCH_STEP_REMOVE_ODD:
+		for (i = 1; i < order->len; i++) {
+			g_array_remove_index(order, i);
+		}
+		break;
+	case BENCH_STEP_END:
+		break;
+	}
+
+	return;
+}
+
+/* The number of children that really have to move for a step,
+   or -1 if we don't care. */
+static inline gint
+bench_step_moves (const bench_step_t * step, GArray * order)
+{
+	switch (step->type) {
+	case BENCH_STEP_ROTATE:
+		return 1;
+	case BENCH_STEP_SWAP_ENDS:
+		return 2;
+	case BENCH_STEP_REVERSE:
+		return order->len - 1;
+	case BENCH_STEP_INSERT_MIDDLE:
+	case BENCH_STEP_REMOVE_ODD:
+		return 0;
+	default:
+		return -1;
+	}
+}
@@ -0,0 +1,351 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-cache.h"
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+static guint realized = 0;
+static guint settle = 0;
+static DbusmenuMenuitem * cached[CACHE_ITEMS];
+
+static void
+new_menuitem (DbusmenuClient * client, DbusmenuMenuitem * mi, gpointer data)
+{
+	realized++;
+	return;
+}
+
+/* The value of the property that doesn't come with the layout,
+   the first item gets changed on the server along the way */
+static gint
+expected_prop (gint id, gboolean changed)
+{
+	if (changed && id == CACHE_FIRST_ID) {
+		return id + CACHE_CHANGED;
+	}
+	return id;
+}
+
+/* Checks that the client has every item with all of its
+   properties, not just the ones from the layout */
+static gboolean
+check_items (DbusmenuClient * client, gboolean changed, gboolean quiet)
+{
+	DbusmenuMenuitem * root = dbusmenu_client_get_root(client);
+	if (root == NULL) {
+		if (!quiet) {
+			g_warning("No root");
+		}
+		return FALSE;
+	}
+
+	GList * children = dbusmenu_menuitem_get_children(root);
+	if (g_list_length(children) != CACHE_ITEMS) {
+		if (!quiet) {
+			g_warning("Got %d items instead of %d", g_list_length(children), CACHE_ITEMS);
+		}
+		return FALSE;
+	}
+
+	GList * child;
+	for (child = children; child != NULL; child = g_list_next(child)) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(child->data);
+		gint id = dbusmenu_menuitem_get_id(mi);
+
+		if (dbusmenu_menuitem_property_get_int(mi, CACHE_PROP) != expected_prop(id, changed)) {
+			if (!quiet) {
+				g_warning("Item %d has '" CACHE_PROP "' %d instead of %d", id, dbusmenu_menuitem_property_get_int(mi, CACHE_PROP), expected_prop(id, changed));
+			}
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Gets one of the counters from the client */
+static guint
+client_stat (DbusmenuClient * client, const gchar * name)
+{
+	GVariant * stats = dbusmenu_client_get_stats(client);
+	guint value = 0;
+	g_variant_lookup(stats, name, "u", &value);
+	g_variant_unref(stats);
+	return value;
+}
+
+/* First time around wait until the properties have all come
+   in from the server */
+static gboolean
+first_check (gpointer user_data)
+{
+	if (!check_items(DBUSMENU_CLIENT(user_data), FALSE, TRUE)) {
+		return TRUE;
+	}
+
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Give the client a chance to ask for properties before we
+   look at what it did */
+static gboolean
+settled (gpointer user_data)
+{
+	settle = 0;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	if (settle == 0) {
+		settle = g_timeout_add(200, settled, NULL);
+	}
+	return;
+}
+
+/* Remember the items that came out of the cache so we can tell
+   whether the live layout recycled them */
+static gboolean
+cached_items (DbusmenuClient * client, gboolean changed)
+{
+	if (!check_items(client, changed, FALSE)) {
+		return FALSE;
+	}
+
+	GList * child = dbusmenu_menuitem_get_children(dbusmenu_client_get_root(client));
+	guint i;
+
+	for (i = 0; child != NULL; i++, child = g_list_next(child)) {
+		cached[i] = DBUSMENU_MENUITEM(child->data);
+	}
+
+	return TRUE;
+}
+
+static void
+check_recycled (DbusmenuClient * client)
+{
+	GList * child = dbusmenu_menuitem_get_children(dbusmenu_client_get_root(client));
+	guint i;
+
+	for (i = 0; child != NULL; i++, child = g_list_next(child)) {
+		if (child->data != cached[i]) {
+			g_warning("Item %d wasn't recycled", dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(child->data)));
+			passed = FALSE;
+		}
+	}
+
+	return;
+}
+
+/* Click on the first item behind the back of any client and wait
+   for the server to have changed it */
+static void
+change_on_server (void)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	GVariant * reply = g_dbus_connection_call_sync(bus, "org.dbusmenu.test", "/org/test",
+	                                               "com.canonical.dbusmenu", "Event",
+	                                               g_variant_new("(isvu)", CACHE_FIRST_ID, "clicked", g_variant_new_int32(0), 0),
+	                                               NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+	if (reply == NULL) {
+		g_warning("Unable to send the event");
+		passed = FALSE;
+	} else {
+		g_variant_unref(reply);
+	}
+
+	guint tries;
+	gboolean changed = FALSE;
+
+	for (tries = 0; passed && !changed && tries < 100; tries++) {
+		reply = g_dbus_connection_call_sync(bus, "org.dbusmenu.test", "/org/test",
+		                                    "com.canonical.dbusmenu", "GetProperty",
+		                                    g_variant_new("(is)", CACHE_FIRST_ID, CACHE_PROP),
+		                                    NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+		if (reply != NULL) {
+			GVariant * value = NULL;
+			g_variant_get(reply, "(v)", &value);
+			changed = g_variant_get_int32(value) == CACHE_FIRST_ID + CACHE_CHANGED;
+			g_variant_unref(value);
+			g_variant_unref(reply);
+		}
+
+		if (!changed) {
+			g_usleep(10000);
+		}
+	}
+
+	if (!changed) {
+		g_warning("The server never changed the property");
+		passed = FALSE;
+	}
+
+	g_object_unref(bus);
+	return;
+}
+
+/* Takes the cache directory back out */
+static void
+remove_tree (const gchar * path)
+{
+	if (g_file_test(path, G_FILE_TEST_IS_DIR)) {
+		GDir * dir = g_dir_open(path, 0, NULL);
+		const gchar * name;
+
+		while (dir != NULL && (name = g_dir_read_name(dir)) != NULL) {
+			gchar * child = g_build_filename(path, name, NULL);
+			remove_tree(child);
+			g_free(child);
+		}
+
+		if (dir != NULL) {
+			g_dir_close(dir);
+		}
+	}
+
+	g_remove(path);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* A client that starts from the cache */
+static DbusmenuClient *
+cached_client (void)
+{
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_NEW_MENUITEM, G_CALLBACK(new_menuitem), NULL);
+	g_object_set(G_OBJECT(client), DBUSMENU_CLIENT_PROP_LAYOUT_CACHE, TRUE, NULL);
+	return client;
+}
+
+int
+main (int argc, char ** argv)
+{
+	/* Start with an empty cache */
+	gchar * cachedir = g_dir_make_tmp("test-glib-layout-cache-XXXXXX", NULL);
+	g_setenv("XDG_CACHE_HOME", cachedir, TRUE);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	guint timer = g_timeout_add_seconds(10, timer_func, NULL);
+
+	/* Get the menu from the server, it's saved when we're done */
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_object_set(G_OBJECT(client), DBUSMENU_CLIENT_PROP_LAYOUT_CACHE, TRUE, NULL);
+
+	if (dbusmenu_client_get_root(client) != NULL) {
+		g_warning("Got a root before there was a cache");
+		passed = FALSE;
+	}
+
+	g_timeout_add(100, first_check, client);
+	g_main_loop_run(mainloop);
+	g_object_unref(G_OBJECT(client));
+
+	/* Now it should all be there before the server answers, and
+	   as nothing changed the properties shouldn't be asked for */
+	client = cached_client();
+
+	if (passed && cached_items(client, FALSE)) {
+		g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+		g_main_loop_run(mainloop);
+
+		if (!check_items(client, FALSE, FALSE)) {
+			passed = FALSE;
+		}
+		check_recycled(client);
+
+		if (realized != CACHE_ITEMS + 1) {
+			g_warning("Realized %d items instead of %d", realized, CACHE_ITEMS + 1);
+			passed = FALSE;
+		}
+
+		if (client_stat(client, "group-property-calls") != 0) {
+			g_warning("Asked for properties %d times with a current cache", client_stat(client, "group-property-calls"));
+			passed = FALSE;
+		}
+
+		if (client_stat(client, "layout-calls") != 1) {
+			g_warning("Got the layout %d times instead of once", client_stat(client, "layout-calls"));
+			passed = FALSE;
+		}
+	} else {
+		passed = FALSE;
+	}
+
+	g_object_unref(G_OBJECT(client));
+
+	/* A property that isn't in the layout changes while nobody is
+	   looking, the cache still has the old one and it shouldn't
+	   be kept */
+	if (passed) {
+		change_on_server();
+	}
+
+	if (passed) {
+		client = cached_client();
+
+		if (cached_items(client, FALSE)) {
+			g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+			g_main_loop_run(mainloop);
+
+			if (!check_items(client, TRUE, FALSE)) {
+				passed = FALSE;
+			}
+			check_recycled(client);
+		} else {
+			passed = FALSE;
+		}
+
+		g_object_unref(G_OBJECT(client));
+	}
+
+	if (passed) {
+		g_source_remove(timer);
+	}
+
+	remove_tree(cachedir);
+	g_free(cachedir);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,94 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-cache.h"
+
+static GMainLoop * mainloop = NULL;
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Change a property that doesn't come with the layout */
+static void
+item_activated (DbusmenuMenuitem * mi, guint timestamp, gpointer user_data)
+{
+	dbusmenu_menuitem_property_set_int(mi, CACHE_PROP, dbusmenu_menuitem_get_id(mi) + CACHE_CHANGED);
+	return;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	guint i;
+
+	for (i = 0; i < CACHE_ITEMS; i++) {
+		DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(CACHE_FIRST_ID + i);
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, "Cached");
+		dbusmenu_menuitem_property_set_int(mi, CACHE_PROP, CACHE_FIRST_ID + i);
+		g_signal_connect(G_OBJECT(mi), DBUSMENU_MENUITEM_SIGNAL_ITEM_ACTIVATED, G_CALLBACK(item_activated), NULL);
+		dbusmenu_menuitem_child_append(root, mi);
+		g_object_unref(mi);
+	}
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	g_timeout_add_seconds(10, timer_func, server);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_debug("Quiting");
+
+	return 0;
+}
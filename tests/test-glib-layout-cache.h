@@ -0,0 +1,27 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Every item has a property that doesn't come with the layout
+   so we can tell that it came out of the cache */
+#define CACHE_ITEMS     20
+#define CACHE_FIRST_ID  100
+#define CACHE_PROP      "x-cache"
+
+/* Activating an item adds this to its property while no client
+   is watching, so the cached value goes stale */
+#define CACHE_CHANGED   1000
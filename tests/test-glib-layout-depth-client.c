@@ -0,0 +1,168 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-depth.h"
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = FALSE;
+static gboolean opened = FALSE;
+
+/* Checks that the submenu @i has what we expect.  Only the
+   first one has been opened and it should have its items, with
+   their own submenus still waiting. */
+static gboolean
+check_menu (DbusmenuClient * client, DbusmenuMenuitem * menu, guint i)
+{
+	GList * children = dbusmenu_menuitem_get_children(menu);
+	gboolean filled = opened && i == 0;
+
+	if (dbusmenu_client_is_placeholder(client, menu) == filled) {
+		g_warning("Menu %d is%s a placeholder", i, filled ? "" : " not");
+		return FALSE;
+	}
+
+	if (g_list_length(children) != (filled ? DEPTH_ITEMS : 0)) {
+		g_warning("Menu %d has %d children", i, g_list_length(children));
+		return FALSE;
+	}
+
+	guint j;
+	for (j = 0; children != NULL; children = g_list_next(children), j++) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(children->data);
+
+		if (dbusmenu_menuitem_get_id(mi) != DEPTH_ITEM_ID(i, j)) {
+			g_warning("Item %d of menu %d has ID %d", j, i, dbusmenu_menuitem_get_id(mi));
+			return FALSE;
+		}
+
+		if (!dbusmenu_client_is_placeholder(client, mi) || dbusmenu_menuitem_get_children(mi) != NULL) {
+			g_warning("Item %d of menu %d isn't an empty placeholder", j, i);
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+check_root (DbusmenuClient * client)
+{
+	DbusmenuMenuitem * root = dbusmenu_client_get_root(client);
+	GList * child;
+	guint i = 0;
+
+	for (child = dbusmenu_menuitem_get_children(root); child != NULL; child = g_list_next(child), i++) {
+		DbusmenuMenuitem * menu = DBUSMENU_MENUITEM(child->data);
+
+		if (dbusmenu_menuitem_get_id(menu) != DEPTH_FIRST_ID + i) {
+			g_warning("Menu %d has ID %d", i, dbusmenu_menuitem_get_id(menu));
+			return FALSE;
+		}
+
+		if (!check_menu(client, menu, i)) {
+			return FALSE;
+		}
+	}
+
+	if (i != DEPTH_MENUS) {
+		g_warning("Got %d menus instead of %d", i, DEPTH_MENUS);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* The first submenu got its children */
+static void
+placeholder_changed (DbusmenuClient * client, DbusmenuMenuitem * mi, gboolean placeholder, gpointer data)
+{
+	if (placeholder || dbusmenu_menuitem_get_id(mi) != DEPTH_FIRST_ID) {
+		return;
+	}
+
+	opened = TRUE;
+	passed = check_root(client);
+
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+/* Only the top level should be here, open the first submenu
+   to get the next one */
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	if (opened) {
+		return;
+	}
+
+	if (!check_root(client)) {
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	GList * first = dbusmenu_menuitem_get_children(dbusmenu_client_get_root(client));
+	dbusmenu_menuitem_send_about_to_show(DBUSMENU_MENUITEM(first->data), NULL, NULL);
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	const gchar * all[] = { NULL };
+
+	DbusmenuClient * client = g_object_new(DBUSMENU_TYPE_CLIENT,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES, all,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_DEPTH, 1,
+	                                       DBUSMENU_CLIENT_PROP_DBUS_NAME, "org.dbusmenu.test",
+	                                       DBUSMENU_CLIENT_PROP_DBUS_OBJECT, "/org/test",
+	                                       NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_PLACEHOLDER_CHANGED, G_CALLBACK(placeholder_changed), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
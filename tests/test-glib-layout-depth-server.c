@@ -0,0 +1,98 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-depth.h"
+
+static GMainLoop * mainloop = NULL;
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	guint i, j;
+
+	for (i = 0; i < DEPTH_MENUS; i++) {
+		DbusmenuMenuitem * menu = dbusmenu_menuitem_new_with_id(DEPTH_FIRST_ID + i);
+		dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_LABEL, "Menu");
+		dbusmenu_menuitem_child_append(root, menu);
+
+		for (j = 0; j < DEPTH_ITEMS; j++) {
+			DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(DEPTH_ITEM_ID(i, j));
+			dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, "Item");
+			dbusmenu_menuitem_child_append(menu, mi);
+
+			DbusmenuMenuitem * sub = dbusmenu_menuitem_new_with_id(DEPTH_ITEM_ID(i, j) + 1);
+			dbusmenu_menuitem_property_set(sub, DBUSMENU_MENUITEM_PROP_LABEL, "Deeper");
+			dbusmenu_menuitem_child_append(mi, sub);
+
+			g_object_unref(sub);
+			g_object_unref(mi);
+		}
+
+		g_object_unref(menu);
+	}
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	g_timeout_add_seconds(10, timer_func, server);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_debug("Quiting");
+
+	return 0;
+}
@@ -0,0 +1,24 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* DEPTH_MENUS submenus under the root, each with DEPTH_ITEMS
+   items that have a submenu of their own */
+#define DEPTH_MENUS       5
+#define DEPTH_ITEMS       10
+#define DEPTH_FIRST_ID    100
+#define DEPTH_ITEM_ID(menu, item)  (1000 + (menu) * 100 + (item) * 2)
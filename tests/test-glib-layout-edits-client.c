@@ -0,0 +1,143 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-edits.h"
+
+static guint stepon = 0;
+static guint edits = 0;
+static guint layout_calls = 0;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+
+/* Count the edit signals so we know they're being sent */
+static void
+edits_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	edits++;
+	return;
+}
+
+/* How many times the client has asked for the layout */
+static guint
+get_layout_calls (DbusmenuClient * client)
+{
+	GVariant * stats = dbusmenu_client_get_stats(client);
+	guint calls = 0;
+	g_variant_lookup(stats, "layout-calls", "u", &calls);
+	g_variant_unref(stats);
+	return calls;
+}
+
+/* Check the layout against the steps we've still got to see,
+   we might not catch all of them if they come quickly. */
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	DbusmenuMenuitem * root = dbusmenu_client_get_root(client);
+	if (root == NULL) {
+		return;
+	}
+
+	gchar * desc = edits_describe(root);
+	guint i;
+
+	for (i = stepon; edits_expected[i] != NULL; i++) {
+		if (g_strcmp0(desc, edits_expected[i]) == 0) {
+			break;
+		}
+	}
+
+	if (edits_expected[i] == NULL) {
+		g_warning("Layout '%s' doesn't match any step after %d", desc, stepon);
+		passed = FALSE;
+		g_main_loop_quit(mainloop);
+	} else {
+		g_debug("Layout matches step %d", i);
+		/* Everything after the first layout should come as edits */
+		if (i == 0) {
+			layout_calls = get_layout_calls(client);
+		} else if (get_layout_calls(client) != layout_calls) {
+			g_warning("Got the layout again for step %d", i);
+			passed = FALSE;
+		}
+		stepon = i + 1;
+	}
+
+	g_free(desc);
+
+	if (edits_expected[stepon] == NULL) {
+		g_main_loop_quit(mainloop);
+	}
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.  Got to: %d", stepon);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "LayoutEdits", /* member */
+	                                   "/org/test", /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   edits_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(30, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	if (edits == 0) {
+		g_warning("Never got a LayoutEdits signal");
+		passed = FALSE;
+	}
+
+	g_object_unref(G_OBJECT(client));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
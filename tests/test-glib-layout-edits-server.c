@@ -0,0 +1,136 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-edits.h"
+
+static guint stepon = 0;
+static DbusmenuMenuitem * root = NULL;
+static DbusmenuServer * server = NULL;
+static GMainLoop * mainloop = NULL;
+
+/* Append a new item with @id to @parent */
+static DbusmenuMenuitem *
+append_new (DbusmenuMenuitem * parent, gint id)
+{
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(id);
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, "Edit");
+	dbusmenu_menuitem_child_append(parent, mi);
+	g_object_unref(mi);
+	return mi;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	DbusmenuMenuitem * one = dbusmenu_menuitem_find_id(root, 1);
+
+	switch (stepon) {
+	case 0:
+		append_new(root, 4);
+		break;
+	case 1:
+		dbusmenu_menuitem_child_delete(root, dbusmenu_menuitem_find_id(root, 2));
+		break;
+	case 2:
+		dbusmenu_menuitem_child_reorder(root, dbusmenu_menuitem_find_id(root, 4), 0);
+		break;
+	case 3: {
+		DbusmenuMenuitem * twelve = dbusmenu_menuitem_new_with_id(12);
+		append_new(twelve, 20);
+		dbusmenu_menuitem_child_add_position(one, twelve, 0);
+		g_object_unref(twelve);
+		break;
+	}
+	case 4:
+		/* A few in one go so they get batched */
+		dbusmenu_menuitem_child_delete(one, dbusmenu_menuitem_find_id(root, 10));
+		dbusmenu_menuitem_child_reorder(root, dbusmenu_menuitem_find_id(root, 3), 1);
+		append_new(root, 5);
+		break;
+	default:
+		g_main_loop_quit(mainloop);
+		return FALSE;
+	}
+
+	stepon++;
+
+	gchar * desc = edits_describe(root);
+	if (g_strcmp0(desc, edits_expected[stepon]) != 0) {
+		g_warning("Server is at '%s' instead of '%s'", desc, edits_expected[stepon]);
+	}
+	g_free(desc);
+
+	return TRUE;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	server = dbusmenu_server_new("/org/test");
+	g_object_set(G_OBJECT(server), DBUSMENU_SERVER_PROP_LAYOUT_EDITS, TRUE, NULL);
+
+	root = dbusmenu_menuitem_new_with_id(0);
+	DbusmenuMenuitem * one = append_new(root, 1);
+	append_new(root, 2);
+	append_new(root, 3);
+	append_new(one, 10);
+	append_new(one, 11);
+
+	dbusmenu_server_set_root(server, root);
+
+	g_timeout_add(1500, timer_func, NULL);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(G_OBJECT(root));
+
+	g_debug("Quiting");
+
+	return 0;
+}
@@ -0,0 +1,66 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <libdbusmenu-glib/menuitem.h>
+
+/* What the menu looks like after each step, every item that has
+   children is listed as "id:child,child" in depth first order */
+static const gchar * edits_expected[] = {
+	"0:1,2,3;1:10,11",
+	"0:1,2,3,4;1:10,11",
+	"0:1,3,4;1:10,11",
+	"0:4,1,3;1:10,11",
+	"0:4,1,3;1:12,10,11;12:20",
+	"0:4,3,1,5;1:12,11;12:20",
+	NULL
+};
+
+static inline void
+edits_describe_item (DbusmenuMenuitem * mi, GString * str)
+{
+	GList * children = dbusmenu_menuitem_get_children(mi);
+	GList * child;
+
+	if (children == NULL) {
+		return;
+	}
+
+	if (str->len > 0) {
+		g_string_append_c(str, ';');
+	}
+	g_string_append_printf(str, "%d:", dbusmenu_menuitem_get_id(mi));
+
+	for (child = children; child != NULL; child = g_list_next(child)) {
+		g_string_append_printf(str, child == children ? "%d" : ",%d", dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(child->data)));
+	}
+
+	for (child = children; child != NULL; child = g_list_next(child)) {
+		edits_describe_item(DBUSMENU_MENUITEM(child->data), str);
+	}
+
+	return;
+}
+
+/* Describe the menu under @root the same way as edits_expected */
+static inline gchar *
+edits_describe (DbusmenuMenuitem * root)
+{
+	GString * str = g_string_new("");
+	edits_describe_item(root, str);
+	return g_string_free(str, FALSE);
+}
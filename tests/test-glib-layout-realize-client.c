@@ -0,0 +1,112 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-layout-realize.h"
+
+static guint realized = 0;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = FALSE;
+
+static void
+new_menuitem (DbusmenuClient * client, DbusmenuMenuitem * mi, gpointer data)
+{
+	realized++;
+	return;
+}
+
+/* By the time the layout is in, every item should already have
+   all of its properties and be realized.  Nothing else has been
+   asked of the server. */
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	DbusmenuMenuitem * root = dbusmenu_client_get_root(client);
+	GList * child;
+	guint count = 0;
+
+	passed = TRUE;
+
+	for (child = dbusmenu_menuitem_get_children(root); child != NULL; child = g_list_next(child)) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(child->data);
+		gint id = dbusmenu_menuitem_get_id(mi);
+
+		if (dbusmenu_menuitem_property_get_int(mi, REALIZE_PROP) != id) {
+			g_warning("Item %d doesn't have its '" REALIZE_PROP "' property", id);
+			passed = FALSE;
+		}
+		count++;
+	}
+
+	if (count != REALIZE_ITEMS) {
+		g_warning("Got %d items instead of %d", count, REALIZE_ITEMS);
+		passed = FALSE;
+	}
+
+	/* The root is realized as well */
+	if (realized != REALIZE_ITEMS + 1) {
+		g_warning("Realized %d items instead of %d", realized, REALIZE_ITEMS + 1);
+		passed = FALSE;
+	}
+
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	const gchar * all[] = { NULL };
+
+	DbusmenuClient * client = g_object_new(DBUSMENU_TYPE_CLIENT,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES, all,
+	                                       DBUSMENU_CLIENT_PROP_DBUS_NAME, "org.dbusmenu.test",
+	                                       DBUSMENU_CLIENT_PROP_DBUS_OBJECT, "/org/test",
+	                                       NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_NEW_MENUITEM, G_CALLBACK(new_menuitem), NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,304 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-lazy-populate.h"
+
+/* Where we are in showing the two submenus */
+typedef enum {
+	STEP_START,
+	STEP_SHOW_SENT,
+	STEP_SHOWN,
+	STEP_GROUP_SENT,
+	STEP_GROUP_SHOWN
+} step_t;
+
+static GMainLoop * mainloop = NULL;
+static GDBusConnection * bus = NULL;
+static gboolean passed = FALSE;
+static step_t step = STEP_START;
+
+/* How many children the submenu @id has in the client */
+static guint
+menu_count (DbusmenuClient * client, gint id)
+{
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_find_id(dbusmenu_client_get_root(client), id);
+	if (menu == NULL) {
+		return 0;
+	}
+	return g_list_length(dbusmenu_menuitem_get_children(menu));
+}
+
+/* Checks that the submenu @id has @count children */
+static gboolean
+check_menu (DbusmenuClient * client, gint id, guint count)
+{
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_find_id(dbusmenu_client_get_root(client), id);
+	GList * children;
+	guint i;
+
+	if (menu == NULL) {
+		g_warning("Unable to find the submenu %d", id);
+		return FALSE;
+	}
+
+	children = dbusmenu_menuitem_get_children(menu);
+	if (g_list_length(children) != count) {
+		g_warning("Submenu %d has %d children instead of %d", id, g_list_length(children), count);
+		return FALSE;
+	}
+
+	for (i = 0; children != NULL; children = g_list_next(children), i++) {
+		if (dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data)) != POPULATE_FIRST_ID(id) + i) {
+			g_warning("Child %d has ID %d", i, dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data)));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Asks the server itself how many children @id has, they have
+   to be there by the time it replies to the about to show */
+static gboolean
+check_server (gint id)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_sync(bus,
+	                                               "org.dbusmenu.test",
+	                                               "/org/test",
+	                                               "com.canonical.dbusmenu",
+	                                               "GetLayout",
+	                                               g_variant_new("(ii@as)", id, 1, g_variant_new_strv(NULL, 0)),
+	                                               G_VARIANT_TYPE("(u(ia{sv}av))"),
+	                                               G_DBUS_CALL_FLAGS_NONE,
+	                                               -1, NULL, &error);
+
+	if (error != NULL) {
+		g_warning("Unable to get the layout of %d: %s", id, error->message);
+		g_error_free(error);
+		return FALSE;
+	}
+
+	GVariant * children = NULL;
+	g_variant_get(reply, "(u(ia{sv}@av))", NULL, NULL, NULL, &children);
+	guint count = g_variant_n_children(children);
+	g_variant_unref(children);
+	g_variant_unref(reply);
+
+	if (count != POPULATE_ITEMS) {
+		g_warning("Server replied with %d children in %d", count, id);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* The submenu has to be marked as needing an update */
+static void
+about_to_show_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_finish(bus, res, &error);
+	gboolean need_update = FALSE;
+
+	if (error != NULL) {
+		g_warning("About to show failed: %s", error->message);
+		g_error_free(error);
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	g_variant_get(reply, "(b)", &need_update);
+	g_variant_unref(reply);
+
+	if (!need_update) {
+		g_warning("About to show didn't ask for an update");
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (!check_server(POPULATE_MENU_ID)) {
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	g_debug("About to show replied");
+	step = STEP_SHOWN;
+	return;
+}
+
+/* The submenu was in the group twice but should only be in
+   the updates once */
+static void
+about_to_show_group_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_finish(bus, res, &error);
+
+	if (error != NULL) {
+		g_warning("About to show group failed: %s", error->message);
+		g_error_free(error);
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	GVariant * updates = NULL;
+	GVariant * errors = NULL;
+	g_variant_get(reply, "(@ai@ai)", &updates, &errors);
+
+	gboolean updated = g_variant_n_children(updates) == 1 && g_variant_n_children(errors) == 0;
+	if (updated) {
+		gint32 id;
+		g_variant_get_child(updates, 0, "i", &id);
+		updated = id == POPULATE_GROUP_ID;
+	}
+
+	if (!updated) {
+		gchar * desc = g_variant_print(reply, FALSE);
+		g_warning("About to show group replied with '%s'", desc);
+		g_free(desc);
+	}
+
+	g_variant_unref(updates);
+	g_variant_unref(errors);
+	g_variant_unref(reply);
+
+	if (!updated || !check_server(POPULATE_GROUP_ID)) {
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	g_debug("About to show group replied");
+	step = STEP_GROUP_SHOWN;
+	return;
+}
+
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	if (dbusmenu_client_get_root(client) == NULL) {
+		return;
+	}
+
+	switch (step) {
+	case STEP_START:
+		/* Nothing there until we ask for it */
+		if (!check_menu(client, POPULATE_MENU_ID, 0) || !check_menu(client, POPULATE_GROUP_ID, 0)) {
+			g_main_loop_quit(mainloop);
+			return;
+		}
+
+		g_dbus_connection_call(bus,
+		                       "org.dbusmenu.test",
+		                       "/org/test",
+		                       "com.canonical.dbusmenu",
+		                       "AboutToShow",
+		                       g_variant_new("(i)", POPULATE_MENU_ID),
+		                       G_VARIANT_TYPE("(b)"),
+		                       G_DBUS_CALL_FLAGS_NONE,
+		                       -1, NULL,
+		                       about_to_show_cb, NULL);
+		step = STEP_SHOW_SENT;
+		break;
+	case STEP_SHOW_SENT:
+		/* Still nothing while the server is building it */
+		if (!check_menu(client, POPULATE_MENU_ID, 0)) {
+			g_warning("Children showed up before the about to show reply");
+			g_main_loop_quit(mainloop);
+		}
+		break;
+	case STEP_SHOWN: {
+		if (menu_count(client, POPULATE_MENU_ID) == 0) {
+			return;
+		}
+		if (!check_menu(client, POPULATE_MENU_ID, POPULATE_ITEMS) || !check_menu(client, POPULATE_GROUP_ID, 0)) {
+			g_main_loop_quit(mainloop);
+			return;
+		}
+
+		gint32 ids[] = { POPULATE_GROUP_ID, POPULATE_GROUP_ID };
+		g_dbus_connection_call(bus,
+		                       "org.dbusmenu.test",
+		                       "/org/test",
+		                       "com.canonical.dbusmenu",
+		                       "AboutToShowGroup",
+		                       g_variant_new("(@ai)", g_variant_new_fixed_array(G_VARIANT_TYPE_INT32, ids, G_N_ELEMENTS(ids), sizeof(gint32))),
+		                       G_VARIANT_TYPE("(aiai)"),
+		                       G_DBUS_CALL_FLAGS_NONE,
+		                       -1, NULL,
+		                       about_to_show_group_cb, NULL);
+		step = STEP_GROUP_SENT;
+		break;
+	}
+	case STEP_GROUP_SENT:
+		if (!check_menu(client, POPULATE_GROUP_ID, 0)) {
+			g_warning("Children showed up before the about to show group reply");
+			g_main_loop_quit(mainloop);
+		}
+		break;
+	case STEP_GROUP_SHOWN:
+		if (menu_count(client, POPULATE_GROUP_ID) == 0) {
+			return;
+		}
+		passed = check_menu(client, POPULATE_GROUP_ID, POPULATE_ITEMS);
+		g_main_loop_quit(mainloop);
+		break;
+	}
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
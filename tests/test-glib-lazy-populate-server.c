@@ -0,0 +1,135 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-lazy-populate.h"
+
+static GMainLoop * mainloop = NULL;
+static DbusmenuServer * server = NULL;
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Add the children a little while after being asked, the
+   reply has to wait for them */
+static gboolean
+populate_timeout (gpointer user_data)
+{
+	DbusmenuMenuitem * menu = DBUSMENU_MENUITEM(user_data);
+	gint first = POPULATE_FIRST_ID(dbusmenu_menuitem_get_id(menu));
+	guint i;
+
+	for (i = 0; i < POPULATE_ITEMS; i++) {
+		DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(first + i);
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, "Item");
+		dbusmenu_menuitem_child_append(menu, mi);
+		g_object_unref(mi);
+	}
+
+	dbusmenu_server_populate_done(server, menu);
+	g_object_unref(menu);
+
+	return FALSE;
+}
+
+/* Each submenu should only be built once, even when it's in
+   an AboutToShowGroup more than once */
+static void
+populate (DbusmenuServer * server, DbusmenuMenuitem * item, gpointer user_data)
+{
+	guint populated = GPOINTER_TO_UINT(g_object_get_data(G_OBJECT(item), "test-populated")) + 1;
+	g_object_set_data(G_OBJECT(item), "test-populated", GUINT_TO_POINTER(populated));
+
+	if (populated != 1) {
+		g_error("Populated %d %d times", dbusmenu_menuitem_get_id(item), populated);
+	}
+
+	g_timeout_add(200, populate_timeout, g_object_ref(item));
+	return;
+}
+
+/* Adds a submenu that gets built by populate() */
+static void
+append_lazy (DbusmenuMenuitem * root, gint id)
+{
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_new_with_id(id);
+	dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_LABEL, "Menu");
+	dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+	dbusmenu_menuitem_child_append(root, menu);
+
+	dbusmenu_server_set_populate_func(server, menu, populate, NULL, NULL);
+	g_object_unref(menu);
+
+	return;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	append_lazy(root, POPULATE_MENU_ID);
+	append_lazy(root, POPULATE_GROUP_ID);
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	g_timeout_add_seconds(10, timer_func, server);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(server));
+
+	g_debug("Quiting");
+
+	return 0;
+}
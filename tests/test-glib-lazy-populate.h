@@ -0,0 +1,25 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The submenus that get built when they're shown, the first
+   with AboutToShow and the other with AboutToShowGroup.  Each
+   gets POPULATE_ITEMS children starting at POPULATE_FIRST_ID. */
+#define POPULATE_MENU_ID   100
+#define POPULATE_GROUP_ID  101
+#define POPULATE_ITEMS     10
+#define POPULATE_FIRST_ID(menu)  (((menu) - POPULATE_MENU_ID + 2) * 100)
@@ -0,0 +1,112 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-memory-bench.h"
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = FALSE;
+static gsize before = 0;
+static guint measure = 0;
+
+/* Counts the items in the tree that have their label */
+static guint
+count_items (DbusmenuMenuitem * mi)
+{
+	guint count = dbusmenu_menuitem_property_get(mi, DBUSMENU_MENUITEM_PROP_LABEL) != NULL ? 1 : 0;
+	GList * child;
+
+	for (child = dbusmenu_menuitem_get_children(mi); child != NULL; child = g_list_next(child)) {
+		count += count_items(DBUSMENU_MENUITEM(child->data));
+	}
+
+	return count;
+}
+
+/* Once the layout that came in has been let go of, all that
+   is left is the tree */
+static gboolean
+measure_func (gpointer data)
+{
+	DbusmenuClient * client = DBUSMENU_CLIENT(data);
+	gsize after = memory_heap_used();
+
+	memory_report("client", dbusmenu_client_get_root(client), after - before);
+
+	passed = TRUE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	DbusmenuMenuitem * root = dbusmenu_client_get_root(client);
+
+	if (measure != 0 || root == NULL || count_items(root) != MEMORY_TOTAL) {
+		return;
+	}
+
+	measure = g_idle_add(measure_func, client);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	const gchar * all[] = { NULL };
+
+	g_type_class_ref(DBUSMENU_TYPE_MENUITEM);
+	before = memory_heap_used();
+
+	DbusmenuClient * client = g_object_new(DBUSMENU_TYPE_CLIENT,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES, all,
+	                                       DBUSMENU_CLIENT_PROP_DBUS_NAME, "org.dbusmenu.test",
+	                                       DBUSMENU_CLIENT_PROP_DBUS_OBJECT, "/org/test",
+	                                       NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,122 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-memory-bench.h"
+
+static GMainLoop * mainloop = NULL;
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* An item with the handful of properties most menus have */
+static DbusmenuMenuitem *
+build_item (gint id, guint j)
+{
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(id);
+	gchar * label = g_strdup_printf("Item %d", id);
+
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, label);
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_ICON_NAME, "document-open");
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_ACCESSIBLE_DESC, label);
+
+	if (j % 3 == 0) {
+		dbusmenu_menuitem_property_set_bool(mi, DBUSMENU_MENUITEM_PROP_ENABLED, FALSE);
+	}
+
+	if (j % 5 == 0) {
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_TYPE, DBUSMENU_MENUITEM_TOGGLE_CHECK);
+		dbusmenu_menuitem_property_set_int(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_STATE, DBUSMENU_MENUITEM_TOGGLE_STATE_CHECKED);
+	}
+
+	g_free(label);
+	return mi;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	gsize before = memory_heap_used();
+
+	guint i, j;
+	for (i = 0; i < MEMORY_MENUS; i++) {
+		DbusmenuMenuitem * menu = build_item(MEMORY_MENU_ID(i), i);
+
+		for (j = 0; j < MEMORY_ITEMS; j++) {
+			DbusmenuMenuitem * mi = build_item(MEMORY_ITEM_ID(i, j), j);
+			dbusmenu_menuitem_child_append(menu, mi);
+			g_object_unref(mi);
+		}
+
+		dbusmenu_menuitem_child_append(root, menu);
+		g_object_unref(menu);
+	}
+
+	gsize after = memory_heap_used();
+
+	memory_report("server", root, after - before);
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	g_timeout_add_seconds(10, timer_func, server);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_type_class_ref(DBUSMENU_TYPE_MENUITEM);
+
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_debug("Quiting");
+
+	return 0;
+}
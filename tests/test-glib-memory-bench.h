@@ -0,0 +1,117 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/* MEMORY_MENUS submenus of MEMORY_ITEMS items each, with IDs
+   that tell where they are */
+#define MEMORY_MENUS         100
+#define MEMORY_ITEMS         100
+#define MEMORY_MENU_ID(i)    (1 + (i))
+#define MEMORY_ITEM_ID(i, j) (1000 + (i) * MEMORY_ITEMS + (j))
+#define MEMORY_TOTAL         (MEMORY_MENUS * (MEMORY_ITEMS + 1))
+
+/* How many bytes of the heap are in use right now.  The test
+   script turns off the slice allocator so that the small things
+   GLib allocates show up here too. */
+static gsize
+memory_heap_used (void)
+{
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 33)
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
+
+/* Adds @mi and everything under it to @items */
+static void
+memory_collect (DbusmenuMenuitem * mi, GPtrArray * items)
+{
+	GList * child;
+
+	g_ptr_array_add(items, mi);
+
+	for (child = dbusmenu_menuitem_get_children(mi); child != NULL; child = g_list_next(child)) {
+		memory_collect(DBUSMENU_MENUITEM(child->data), items);
+	}
+
+	return;
+}
+
+/* Prints the bytes per item of the tree under @root, which took
+   @used bytes of the heap, along with an estimate of what they were
+   when every item kept its properties in a GHashTable with copied
+   names.  That isn't measured from the old code, the properties are
+   stored again both ways, sharing the values, and the difference
+   between the two is taken off @used. */
+static void
+memory_report (const gchar * side, DbusmenuMenuitem * root, gsize used)
+{
+	GPtrArray * items = g_ptr_array_new();
+	memory_collect(root, items);
+
+	GPtrArray * copies = g_ptr_array_new_full(items->len, g_object_unref);
+	GPtrArray * tables = g_ptr_array_new_full(items->len, (GDestroyNotify)g_hash_table_destroy);
+	guint i;
+
+	for (i = 0; i < items->len; i++) {
+		g_ptr_array_add(copies, dbusmenu_menuitem_new());
+	}
+
+	gsize bare = memory_heap_used();
+	for (i = 0; i < items->len; i++) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(g_ptr_array_index(items, i));
+		GList * names = dbusmenu_menuitem_properties_list(mi);
+		GList * name;
+
+		for (name = names; name != NULL; name = g_list_next(name)) {
+			dbusmenu_menuitem_property_set_variant(DBUSMENU_MENUITEM(g_ptr_array_index(copies, i)), name->data, dbusmenu_menuitem_property_get_variant(mi, name->data));
+		}
+
+		g_list_free(names);
+	}
+	gsize array = memory_heap_used() - bare;
+
+	gsize before = memory_heap_used();
+	for (i = 0; i < items->len; i++) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(g_ptr_array_index(items, i));
+		GHashTable * table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_variant_unref);
+		GList * names = dbusmenu_menuitem_properties_list(mi);
+		GList * name;
+
+		for (name = names; name != NULL; name = g_list_next(name)) {
+			g_hash_table_insert(table, g_strdup(name->data), g_variant_ref(dbusmenu_menuitem_property_get_variant(mi, name->data)));
+		}
+
+		g_list_free(names);
+		g_ptr_array_add(tables, table);
+	}
+	gsize hash = memory_heap_used() - before;
+
+	g_print("{\"side\": \"%s\", \"items\": %d, \"bytes_per_item_before_estimate\": %" G_GSIZE_FORMAT ", \"bytes_per_item_after\": %" G_GSIZE_FORMAT "}\n",
+	        side, items->len, (used - array + hash) / items->len, used / items->len);
+
+	g_ptr_array_unref(tables);
+	g_ptr_array_unref(copies);
+	g_ptr_array_unref(items);
+
+	return;
+}
@@ -20,7 +20,9 @@ with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include <libdbusmenu-glib/menuitem.h>
 
@@ -305,6 +307,388 @@ test_object_menuitem_props_removal (void)
 	return;
 }
 
+/* Counts the property-changed signals */
+static void
+test_object_menuitem_props_many_single (DbusmenuMenuitem * mi, gchar * property, GVariant * value, guint * count)
+{
+	(*count)++;
+	return;
+}
+
+/* Checks that the properties on @item are "prop-N" for each of
+   the numbers in @order, in that order */
+static void
+test_object_menuitem_props_order_check (DbusmenuMenuitem * item, const gint * order, guint count)
+{
+	GList * names = dbusmenu_menuitem_properties_list(item);
+	GList * name = names;
+	guint i;
+
+	g_assert(g_list_length(names) == count);
+
+	for (i = 0; i < count; i++, name = g_list_next(name)) {
+		gchar * expected = g_strdup_printf("prop-%d", order[i]);
+		g_assert_cmpstr(name->data, ==, expected);
+		g_assert(dbusmenu_menuitem_property_get_int(item, expected) == order[i]);
+		g_free(expected);
+	}
+
+	g_list_free(names);
+	return;
+}
+
+/* Keeps the order the properties were set in, even with too
+   many of them to search through */
+static void
+test_object_menuitem_props_order (void)
+{
+	DbusmenuMenuitem * item = dbusmenu_menuitem_new();
+	gint order[24];
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(order); i++) {
+		gchar * name = g_strdup_printf("prop-%d", i);
+		dbusmenu_menuitem_property_set_int(item, name, i);
+		g_free(name);
+		order[i] = i;
+	}
+	test_object_menuitem_props_order_check(item, order, G_N_ELEMENTS(order));
+
+	/* Setting one again keeps it where it was */
+	dbusmenu_menuitem_property_set_int(item, "prop-3", 3);
+	test_object_menuitem_props_order_check(item, order, G_N_ELEMENTS(order));
+
+	/* The ones after a removed one move up */
+	dbusmenu_menuitem_property_remove(item, "prop-5");
+	g_assert(!dbusmenu_menuitem_property_exist(item, "prop-5"));
+	for (i = 5; i < G_N_ELEMENTS(order) - 1; i++) {
+		order[i] = order[i + 1];
+	}
+	test_object_menuitem_props_order_check(item, order, G_N_ELEMENTS(order) - 1);
+
+	/* And setting it again puts it at the end */
+	dbusmenu_menuitem_property_set_int(item, "prop-5", 5);
+	order[G_N_ELEMENTS(order) - 1] = 5;
+	test_object_menuitem_props_order_check(item, order, G_N_ELEMENTS(order));
+
+	g_object_unref(item);
+
+	return;
+}
+
+/* Checks the name that comes with the property-changed signal */
+static void
+test_object_menuitem_props_unknown_changed (DbusmenuMenuitem * mi, gchar * property, GVariant * value, gchar ** name)
+{
+	g_free(*name);
+	*name = g_strdup(property);
+	return;
+}
+
+/* Names that come from somewhere else don't get interned, but
+   they still work like any other */
+static void
+test_object_menuitem_props_unknown (void)
+{
+	DbusmenuMenuitem * item = dbusmenu_menuitem_new();
+	gchar * changed = NULL;
+
+	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, G_CALLBACK(test_object_menuitem_props_unknown_changed), &changed);
+
+	dbusmenu_menuitem_property_set(item, "test-unknown-single", "Single");
+	g_assert(g_quark_try_string("test-unknown-single") == 0);
+	g_assert_cmpstr(dbusmenu_menuitem_property_get(item, "test-unknown-single"), ==, "Single");
+
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_LABEL, g_variant_new_string("Known"));
+	g_variant_builder_add(&builder, "{sv}", "test-unknown-many", g_variant_new_int32(34));
+	g_assert(dbusmenu_menuitem_properties_set_many(item, g_variant_builder_end(&builder)));
+
+	g_assert(g_quark_try_string("test-unknown-many") == 0);
+	g_assert(dbusmenu_menuitem_property_get_int(item, "test-unknown-many") == 34);
+	g_assert_cmpstr(dbusmenu_menuitem_property_get(item, DBUSMENU_MENUITEM_PROP_LABEL), ==, "Known");
+
+	/* Removing one by the name we got from the item */
+	GList * names = dbusmenu_menuitem_properties_list(item);
+	g_assert(g_list_length(names) == 3);
+	g_assert_cmpstr(names->data, ==, "test-unknown-single");
+
+	dbusmenu_menuitem_property_remove(item, names->data);
+	g_assert_cmpstr(changed, ==, "test-unknown-single");
+	g_assert(!dbusmenu_menuitem_property_exist(item, "test-unknown-single"));
+	g_assert(dbusmenu_menuitem_property_exist(item, "test-unknown-many"));
+	g_list_free(names);
+
+	g_object_unref(item);
+	g_free(changed);
+
+	return;
+}
+
+/* Counts the properties-changed signals and the names in them */
+static void
+test_object_menuitem_props_many_batch (DbusmenuMenuitem * mi, const gchar ** properties, guint * count)
+{
+	count[0]++;
+	count[1] += g_strv_length((gchar **)properties);
+	return;
+}
+
+/* Set a bunch of properties at once */
+static void
+test_object_menuitem_props_many (void)
+{
+	/* Build a menu item */
+	DbusmenuMenuitem * item = dbusmenu_menuitem_new();
+	guint singles = 0;
+	guint batches[2] = {0, 0};
+
+	/* Test to make sure it's a happy object */
+	g_assert(item != NULL);
+
+	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, G_CALLBACK(test_object_menuitem_props_many_single), &singles);
+	g_signal_connect(G_OBJECT(item), DBUSMENU_MENUITEM_SIGNAL_PROPERTIES_CHANGED, G_CALLBACK(test_object_menuitem_props_many_batch), batches);
+
+	/* One of these is the default so it shouldn't count */
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_LABEL, g_variant_new_string("Many"));
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_ENABLED, g_variant_new_boolean(FALSE));
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_VISIBLE, g_variant_new_boolean(TRUE));
+	g_variant_builder_add(&builder, "{sv}", "myprop", g_variant_new_int32(34));
+
+	g_assert(dbusmenu_menuitem_properties_set_many(item, g_variant_builder_end(&builder)));
+
+	g_assert(singles == 3);
+	g_assert(batches[0] == 1);
+	g_assert(batches[1] == 3);
+
+	g_assert(!g_strcmp0(dbusmenu_menuitem_property_get(item, DBUSMENU_MENUITEM_PROP_LABEL), "Many"));
+	g_assert(!dbusmenu_menuitem_property_get_bool(item, DBUSMENU_MENUITEM_PROP_ENABLED));
+	g_assert(dbusmenu_menuitem_property_get_int(item, "myprop") == 34);
+
+	/* Setting one on its own is a batch of one */
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, "One");
+	g_assert(singles == 4);
+	g_assert(batches[0] == 2);
+	g_assert(batches[1] == 4);
+
+	g_object_unref(item);
+
+	return;
+}
+
+/* Checks that the list of children and the positions
+   agree with @ids */
+static void
+test_object_menuitem_children_check (DbusmenuMenuitem * parent, const gint * ids, guint count)
+{
+	GList * children = dbusmenu_menuitem_get_children(parent);
+	guint i;
+
+	g_assert(g_list_length(children) == count);
+
+	for (i = 0; i < count; i++, children = g_list_next(children)) {
+		DbusmenuMenuitem * child = DBUSMENU_MENUITEM(children->data);
+
+		g_assert(dbusmenu_menuitem_get_id(child) == ids[i]);
+		g_assert(dbusmenu_menuitem_get_position(child, parent) == i);
+		g_assert(dbusmenu_menuitem_child_find(parent, ids[i]) == child);
+		g_assert(children->prev == NULL || children->prev->next == children);
+	}
+
+	return;
+}
+
+/* Move children around and make sure their positions
+   follow along */
+static void
+test_object_menuitem_children (void)
+{
+	DbusmenuMenuitem * parent = dbusmenu_menuitem_new();
+	DbusmenuMenuitem * items[6];
+	guint i;
+
+	for (i = 0; i < 6; i++) {
+		items[i] = dbusmenu_menuitem_new_with_id(i + 1);
+	}
+
+	dbusmenu_menuitem_child_append(parent, items[1]);
+	dbusmenu_menuitem_child_append(parent, items[3]);
+	dbusmenu_menuitem_child_prepend(parent, items[0]);
+	dbusmenu_menuitem_child_add_position(parent, items[2], 2);
+	dbusmenu_menuitem_child_add_position(parent, items[4], 100);
+
+	gint added[] = {1, 2, 3, 4, 5};
+	test_object_menuitem_children_check(parent, added, 5);
+
+	dbusmenu_menuitem_child_reorder(parent, items[4], 0);
+	dbusmenu_menuitem_child_reorder(parent, items[1], 4);
+
+	gint moved[] = {5, 1, 3, 4, 2};
+	test_object_menuitem_children_check(parent, moved, 5);
+
+	dbusmenu_menuitem_child_delete(parent, items[2]);
+	dbusmenu_menuitem_child_add_position(parent, items[5], 1);
+
+	gint deleted[] = {5, 6, 1, 4, 2};
+	test_object_menuitem_children_check(parent, deleted, 5);
+	g_assert(dbusmenu_menuitem_get_position(items[2], parent) == 0);
+	g_assert(dbusmenu_menuitem_child_find(parent, 3) == NULL);
+
+	/* Only the realized ones count for the realized position */
+	dbusmenu_menuitem_set_realized(items[5]);
+	dbusmenu_menuitem_set_realized(items[3]);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[5], parent) == 0);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[3], parent) == 1);
+
+	dbusmenu_menuitem_set_realized(items[4]);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[4], parent) == 0);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[5], parent) == 1);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[3], parent) == 2);
+
+	dbusmenu_menuitem_child_reorder(parent, items[3], 0);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[3], parent) == 0);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[4], parent) == 1);
+	g_assert(dbusmenu_menuitem_get_position_realized(items[0], parent) == 0);
+
+	g_object_unref(parent);
+	for (i = 0; i < 6; i++) {
+		g_object_unref(items[i]);
+	}
+
+	return;
+}
+
+/* A tree that comes from a snapshot should be able to have its
+   children found, moved and taken out like any other */
+static void
+test_object_menuitem_children_snapshot (void)
+{
+	DbusmenuMenuitem * parent = dbusmenu_menuitem_new_with_id(10);
+	guint i;
+
+	for (i = 0; i < 4; i++) {
+		DbusmenuMenuitem * child = dbusmenu_menuitem_new_with_id(i + 1);
+		dbusmenu_menuitem_child_append(parent, child);
+		g_object_unref(child);
+	}
+
+	DbusmenuMenuitem * restored = dbusmenu_menuitem_new_from_snapshot(dbusmenu_menuitem_snapshot(parent));
+	g_object_unref(parent);
+	g_assert(restored != NULL);
+
+	gint loaded[] = {1, 2, 3, 4};
+	test_object_menuitem_children_check(restored, loaded, 4);
+
+	DbusmenuMenuitem * third = dbusmenu_menuitem_child_find(restored, 3);
+	g_assert(third != NULL);
+	g_object_ref(third);
+	g_assert(dbusmenu_menuitem_child_delete(restored, third));
+	g_assert(dbusmenu_menuitem_get_parent(third) == NULL);
+
+	gint deleted[] = {1, 2, 4};
+	test_object_menuitem_children_check(restored, deleted, 3);
+
+	dbusmenu_menuitem_child_add_position(restored, third, 0);
+	dbusmenu_menuitem_child_reorder(restored, dbusmenu_menuitem_child_find(restored, 4), 1);
+	g_object_unref(third);
+
+	gint added[] = {3, 4, 1, 2};
+	test_object_menuitem_children_check(restored, added, 4);
+
+	g_object_unref(restored);
+
+	return;
+}
+
+/* A node of a snapshot with @nchildren children from @children */
+static GVariant *
+snapshot_node (gint id, GVariant * props, GVariant ** children, guint nchildren)
+{
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("av"));
+
+	guint i;
+	for (i = 0; i < nchildren; i++) {
+		g_variant_builder_add(&builder, "v", children[i]);
+	}
+
+	if (props == NULL) {
+		props = g_variant_new_array(G_VARIANT_TYPE("{sv}"), NULL, 0);
+	}
+
+	return g_variant_new("(i@a{sv}@av)", id, props, g_variant_builder_end(&builder));
+}
+
+/* Writes @root as a snapshot file with @version and makes sure
+   that loading it fails instead of giving back a menu */
+static void
+snapshot_load_bad (const gchar * filename, guint32 version, GVariant * root)
+{
+	GVariant * file = g_variant_ref_sink(g_variant_new("(u@(ia{sv}av))", version, root));
+	GError * error = NULL;
+
+	g_file_set_contents(filename, g_variant_get_data(file), g_variant_get_size(file), &error);
+	g_assert_no_error(error);
+	g_variant_unref(file);
+
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_snapshot_load(filename, &error);
+	g_assert(mi == NULL);
+	g_assert_error(error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+	g_error_free(error);
+
+	return;
+}
+
+/* Snapshots with repeated or negative IDs, or with a property of
+   the wrong type, get an error and no menu */
+static void
+test_object_menuitem_snapshot_bad (void)
+{
+	GError * error = NULL;
+	gchar * dir = g_dir_make_tmp("dbusmenu-snapshot-XXXXXX", &error);
+	g_assert_no_error(error);
+	gchar * filename = g_build_filename(dir, "menu.gvariant", NULL);
+
+	/* Get the version from a good one */
+	DbusmenuMenuitem * good = dbusmenu_menuitem_new_with_id(0);
+	g_assert(dbusmenu_menuitem_snapshot_save(good, filename, &error));
+	g_assert_no_error(error);
+	g_object_unref(good);
+
+	gchar * contents = NULL;
+	gsize length = 0;
+	g_assert(g_file_get_contents(filename, &contents, &length, &error));
+	GVariant * goodfile = g_variant_ref_sink(g_variant_new_from_data(G_VARIANT_TYPE("(u(ia{sv}av))"), contents, length, FALSE, g_free, contents));
+	guint32 version = 0;
+	g_variant_get_child(goodfile, 0, "u", &version);
+	g_variant_unref(goodfile);
+
+	GVariant * children[2];
+
+	children[0] = snapshot_node(1, NULL, NULL, 0);
+	children[1] = snapshot_node(1, NULL, NULL, 0);
+	snapshot_load_bad(filename, version, snapshot_node(0, NULL, children, 2));
+
+	children[0] = snapshot_node(-5, NULL, NULL, 0);
+	snapshot_load_bad(filename, version, snapshot_node(0, NULL, children, 1));
+
+	GVariantBuilder props;
+	g_variant_builder_init(&props, G_VARIANT_TYPE("a{sv}"));
+	g_variant_builder_add(&props, "{sv}", DBUSMENU_MENUITEM_PROP_VISIBLE, g_variant_new_string("yes"));
+	children[0] = snapshot_node(1, g_variant_builder_end(&props), NULL, 0);
+	snapshot_load_bad(filename, version, snapshot_node(0, NULL, children, 1));
+
+	g_unlink(filename);
+	g_rmdir(dir);
+	g_free(filename);
+	g_free(dir);
+
+	return;
+}
+
 /* Build the test suite */
 static void
 test_glib_objects_suite (void)
@@ -318,6 +702,12 @@ test_glib_objects_suite (void)
 	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_signals", test_object_menuitem_props_signals);
 	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_boolstr", test_object_menuitem_props_boolstr);
 	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_removal", test_object_menuitem_props_removal);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_many",    test_object_menuitem_props_many);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_order",   test_object_menuitem_props_order);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/props_unknown", test_object_menuitem_props_unknown);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/children",      test_object_menuitem_children);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/children_snapshot", test_object_menuitem_children_snapshot);
+	g_test_add_func ("/dbusmenu/glib/objects/menuitem/snapshot_bad",  test_object_menuitem_snapshot_bad);
 	return;
 }
 
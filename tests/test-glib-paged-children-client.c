@@ -0,0 +1,163 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-paged-children.h"
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = FALSE;
+static gboolean opened = FALSE;
+static guint seen = 0;
+
+/* Checks the children we've got so far are the first ones
+   on the server, in order */
+static gboolean
+check_menu (DbusmenuMenuitem * menu, guint expected)
+{
+	GList * children = dbusmenu_menuitem_get_children(menu);
+	guint i;
+
+	if (g_list_length(children) != expected) {
+		g_warning("Submenu has %d children instead of %d", g_list_length(children), expected);
+		return FALSE;
+	}
+
+	for (i = 0; children != NULL; children = g_list_next(children), i++) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(children->data);
+		const gchar * label = dbusmenu_menuitem_property_get(mi, DBUSMENU_MENUITEM_PROP_LABEL);
+		gchar * wanted = g_strdup_printf("Item %d", i);
+
+		if (dbusmenu_menuitem_get_id(mi) != (gint)(PAGED_FIRST_ID + i) || g_strcmp0(label, wanted) != 0) {
+			g_warning("Child %d is %d with label '%s' instead of '%s'", i, dbusmenu_menuitem_get_id(mi), label, wanted);
+			g_free(wanted);
+			return FALSE;
+		}
+
+		g_free(wanted);
+	}
+
+	return TRUE;
+}
+
+/* Each page should bring PAGED_PAGE_SIZE more children until
+   they're all in */
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_find_id(dbusmenu_client_get_root(client), PAGED_MENU_ID);
+
+	if (menu == NULL) {
+		g_warning("Unable to find the submenu");
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (!opened) {
+		if (!dbusmenu_client_is_placeholder(client, menu) || !check_menu(menu, 0)) {
+			g_warning("Submenu should be an empty placeholder");
+			g_main_loop_quit(mainloop);
+			return;
+		}
+
+		opened = TRUE;
+		dbusmenu_menuitem_send_about_to_show(menu, NULL, NULL);
+		return;
+	}
+
+	if (dbusmenu_client_is_placeholder(client, menu)) {
+		return;
+	}
+
+	/* Nothing new since the last page */
+	if (g_list_length(dbusmenu_menuitem_get_children(menu)) == seen) {
+		return;
+	}
+
+	guint expected = MIN(seen + PAGED_PAGE_SIZE, PAGED_ITEMS);
+	seen = expected;
+
+	if (!check_menu(menu, expected)) {
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (dbusmenu_client_get_children_total(client, menu) != PAGED_ITEMS) {
+		g_warning("Submenu has a total of %d children instead of %d", dbusmenu_client_get_children_total(client, menu), PAGED_ITEMS);
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (dbusmenu_client_has_more_children(client, menu) != (expected < PAGED_ITEMS)) {
+		g_warning("Submenu with %d children says it has%s more", expected, expected < PAGED_ITEMS ? " no" : "");
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (expected < PAGED_ITEMS) {
+		dbusmenu_client_fetch_more_children(client, menu);
+		return;
+	}
+
+	passed = TRUE;
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	const gchar * all[] = { NULL };
+
+	DbusmenuClient * client = g_object_new(DBUSMENU_TYPE_CLIENT,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_PROPERTIES, all,
+	                                       DBUSMENU_CLIENT_PROP_LAYOUT_DEPTH, 1,
+	                                       DBUSMENU_CLIENT_PROP_PAGE_SIZE, PAGED_PAGE_SIZE,
+	                                       DBUSMENU_CLIENT_PROP_DBUS_NAME, "org.dbusmenu.test",
+	                                       DBUSMENU_CLIENT_PROP_DBUS_OBJECT, "/org/test",
+	                                       NULL);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,24 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The submenu with PAGED_ITEMS items in it, starting at
+   PAGED_FIRST_ID, and how many the client gets at a time */
+#define PAGED_MENU_ID      100
+#define PAGED_ITEMS        250
+#define PAGED_FIRST_ID     1000
+#define PAGED_PAGE_SIZE    100
@@ -0,0 +1,287 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* Each tick changes every property on every item once, and a
+   second time for the first half of them to make sure the
+   last value is the one that gets sent. */
+#define BENCH_ITEMS       2000
+#define BENCH_PROPS       5
+#define BENCH_TICKS      5
+#define BENCH_FIRST_ID    100
+
+/* After the ticks the first item is swapped for a new one with the
+   same ID in between two changes, only the new value can go out */
+#define REUSE_VALUE       -2
+
+static const gchar * props[BENCH_PROPS] = {
+	"x-bench-0",
+	"x-bench-1",
+	"x-bench-2",
+	"x-bench-3",
+	"x-bench-4"
+};
+
+static DbusmenuServer * server = NULL;
+static DbusmenuMenuitem * items[BENCH_ITEMS];
+static guint tickon = 0;
+static guint changes = 0;
+static gint64 queue_start = 0;
+static gint64 queue_usec = 0;
+static gboolean waiting = FALSE;
+static gboolean reusing = FALSE;
+static gboolean passed = TRUE;
+static GMainLoop * mainloop = NULL;
+
+/* The value we expect a property to end up with on a tick */
+static gint
+bench_value (guint tick, guint item, guint prop)
+{
+	return (tick * BENCH_ITEMS + item) * BENCH_PROPS + prop;
+}
+
+/* Change all the properties in a single go, the server should
+   fold them into one signal */
+static gboolean
+tick_func (gpointer data)
+{
+	guint i, j;
+
+	changes = 0;
+	queue_start = g_get_monotonic_time();
+
+	for (i = 0; i < BENCH_ITEMS; i++) {
+		for (j = 0; j < BENCH_PROPS; j++) {
+			if (i < BENCH_ITEMS / 2) {
+				dbusmenu_menuitem_property_set_int(items[i], props[j], -1);
+				changes++;
+			}
+
+			dbusmenu_menuitem_property_set_int(items[i], props[j], bench_value(tickon, i, j));
+			changes++;
+		}
+	}
+
+	queue_usec = g_get_monotonic_time() - queue_start;
+	waiting = TRUE;
+
+	return FALSE;
+}
+
+/* Replaces the first item with one that has the same ID, the
+   edits make sure the new one is exposed right away */
+static gboolean
+reuse_func (gpointer data)
+{
+	DbusmenuMenuitem * root = dbusmenu_menuitem_get_parent(items[0]);
+
+	g_object_set(G_OBJECT(server), DBUSMENU_SERVER_PROP_LAYOUT_EDITS, TRUE, NULL);
+
+	dbusmenu_menuitem_property_set_int(items[0], props[0], -1);
+	dbusmenu_menuitem_child_delete(root, items[0]);
+
+	items[0] = dbusmenu_menuitem_new_with_id(BENCH_FIRST_ID);
+	dbusmenu_menuitem_child_prepend(root, items[0]);
+	g_object_unref(G_OBJECT(items[0]));
+
+	dbusmenu_menuitem_property_set_int(items[0], props[0], REUSE_VALUE);
+
+	reusing = TRUE;
+	waiting = TRUE;
+
+	return FALSE;
+}
+
+/* Check that the reused ID is only in the signal once, with the
+   value of the item that has it now */
+static void
+reuse_check (GVariant * updated)
+{
+	guint i;
+	guint found = 0;
+
+	for (i = 0; i < g_variant_n_children(updated); i++) {
+		gint id;
+		GVariant * dict;
+		gint value = 0;
+
+		g_variant_get_child(updated, i, "(i@a{sv})", &id, &dict);
+
+		if (id == BENCH_FIRST_ID) {
+			found++;
+
+			if (!g_variant_lookup(dict, props[0], "i", &value) || value != REUSE_VALUE) {
+				g_warning("Reused ID %d has '%s' = %d", id, props[0], value);
+				passed = FALSE;
+			}
+		}
+
+		g_variant_unref(dict);
+	}
+
+	if (found != 1) {
+		g_warning("Reused ID %d is in the signal %d times", BENCH_FIRST_ID, found);
+		passed = FALSE;
+	}
+
+	return;
+}
+
+/* Check that the signal has every item, once, in order and
+   with the last values we set */
+static void
+properties_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	if (!waiting) {
+		return;
+	}
+	waiting = FALSE;
+
+	if (reusing) {
+		GVariant * reused = g_variant_get_child_value(params, 0);
+		reuse_check(reused);
+		g_variant_unref(reused);
+
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	gint64 elapsed = g_get_monotonic_time() - queue_start;
+
+	GVariant * updated = g_variant_get_child_value(params, 0);
+	GVariant * removed = g_variant_get_child_value(params, 1);
+
+	if (g_variant_n_children(updated) != BENCH_ITEMS) {
+		g_warning("Tick %d: expected %d items, got %d", tickon, BENCH_ITEMS, (gint)g_variant_n_children(updated));
+		passed = FALSE;
+	}
+
+	if (g_variant_n_children(removed) != 0) {
+		g_warning("Tick %d: got %d items with removed properties", tickon, (gint)g_variant_n_children(removed));
+		passed = FALSE;
+	}
+
+	guint i, j;
+	for (i = 0; passed && i < g_variant_n_children(updated); i++) {
+		gint id;
+		GVariant * dict;
+
+		g_variant_get_child(updated, i, "(i@a{sv})", &id, &dict);
+
+		if (id != BENCH_FIRST_ID + i || g_variant_n_children(dict) != BENCH_PROPS) {
+			g_warning("Tick %d: item %d is ID %d with %d properties", tickon, i, id, (gint)g_variant_n_children(dict));
+			passed = FALSE;
+		}
+
+		for (j = 0; passed && j < BENCH_PROPS; j++) {
+			const gchar * name;
+			GVariant * value;
+
+			g_variant_get_child(dict, j, "{&sv}", &name, &value);
+
+			if (g_strcmp0(name, props[j]) != 0 || g_variant_get_int32(value) != bench_value(tickon, i, j)) {
+				g_warning("Tick %d: item %d has '%s' = %d", tickon, id, name, g_variant_get_int32(value));
+				passed = FALSE;
+			}
+
+			g_variant_unref(value);
+		}
+
+		g_variant_unref(dict);
+	}
+
+	g_variant_unref(updated);
+	g_variant_unref(removed);
+
+	g_print("{\"tick\": %d, \"items\": %d, \"changes\": %d, \"queue_usec\": %" G_GINT64_FORMAT ", \"usec\": %" G_GINT64_FORMAT "}\n",
+	        tickon, BENCH_ITEMS, changes, queue_usec, elapsed);
+
+	tickon++;
+
+	if (!passed) {
+		g_main_loop_quit(mainloop);
+	} else if (tickon >= BENCH_TICKS) {
+		g_idle_add(reuse_func, NULL);
+	} else {
+		g_idle_add(tick_func, NULL);
+	}
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.  Got to: %d", tickon);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	guint i;
+
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "ItemsPropertiesUpdated", /* member */
+	                                   "/org/test", /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   properties_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	for (i = 0; i < BENCH_ITEMS; i++) {
+		items[i] = dbusmenu_menuitem_new_with_id(BENCH_FIRST_ID + i);
+		dbusmenu_menuitem_child_append(root, items[i]);
+		g_object_unref(G_OBJECT(items[i]));
+	}
+
+	dbusmenu_server_set_root(server, root);
+
+	/* Give the server a chance to get on the bus */
+	g_timeout_add(500, tick_func, NULL);
+	g_timeout_add_seconds(60, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
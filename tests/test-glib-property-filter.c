@@ -0,0 +1,221 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* An item with an icon gets a new label while a sibling is added
+   after it.  Getting the new layout shouldn't bring the icon over
+   the bus again. */
+#define ICON_ID        1
+#define ADDED_ID       2
+#define ICON_BYTES     4096
+
+static DbusmenuServer * server = NULL;
+static DbusmenuMenuitem * root = NULL;
+static DbusmenuClient * client = NULL;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+static gint watching = 0;
+static gint icon_fetches = 0;
+
+/* Whether a GetGroupProperties call would send the icon */
+static gboolean
+wants_icon (GVariant * body)
+{
+	GVariant * ids = g_variant_get_child_value(body, 0);
+	GVariant * names = g_variant_get_child_value(body, 1);
+	gboolean item = FALSE;
+	gboolean prop = g_variant_n_children(names) == 0;
+	gsize i;
+
+	for (i = 0; i < g_variant_n_children(ids); i++) {
+		gint32 id;
+		g_variant_get_child(ids, i, "i", &id);
+		if (id == ICON_ID) {
+			item = TRUE;
+		}
+	}
+
+	for (i = 0; !prop && i < g_variant_n_children(names); i++) {
+		const gchar * name;
+		g_variant_get_child(names, i, "&s", &name);
+		prop = g_strcmp0(name, DBUSMENU_MENUITEM_PROP_ICON_DATA) == 0;
+	}
+
+	g_variant_unref(names);
+	g_variant_unref(ids);
+
+	return item && prop;
+}
+
+/* Looks at every GetGroupProperties call the client sends, this
+   runs in the GDBus thread */
+static GDBusMessage *
+message_filter (GDBusConnection * connection, GDBusMessage * message, gboolean incoming, gpointer user_data)
+{
+	if (incoming || !g_atomic_int_get(&watching)) {
+		return message;
+	}
+
+	if (g_dbus_message_get_message_type(message) == G_DBUS_MESSAGE_TYPE_METHOD_CALL
+			&& g_strcmp0(g_dbus_message_get_member(message), "GetGroupProperties") == 0
+			&& wants_icon(g_dbus_message_get_body(message))) {
+		g_atomic_int_inc(&icon_fetches);
+	}
+
+	return message;
+}
+
+/* The item with the icon as the client sees it */
+static DbusmenuMenuitem *
+client_item (gint id)
+{
+	DbusmenuMenuitem * croot = dbusmenu_client_get_root(client);
+	if (croot == NULL) {
+		return NULL;
+	}
+	return dbusmenu_menuitem_child_find(croot, id);
+}
+
+/* Waits until the client has the new label and the new item */
+static gboolean
+changed_check (gpointer user_data)
+{
+	DbusmenuMenuitem * item = client_item(ICON_ID);
+
+	if (item == NULL || client_item(ADDED_ID) == NULL
+			|| g_strcmp0(dbusmenu_menuitem_property_get(item, DBUSMENU_MENUITEM_PROP_LABEL), "After") != 0) {
+		return TRUE;
+	}
+
+	gsize length = 0;
+	dbusmenu_menuitem_property_get_byte_array(item, DBUSMENU_MENUITEM_PROP_ICON_DATA, &length);
+	if (length != ICON_BYTES) {
+		g_warning("The icon has %d bytes instead of %d", (gint)length, ICON_BYTES);
+		passed = FALSE;
+	}
+
+	if (g_atomic_int_get(&icon_fetches) != 0) {
+		g_warning("Asked for the icon %d times for a new label", g_atomic_int_get(&icon_fetches));
+		passed = FALSE;
+	}
+
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Once the client has the whole item change its label and add
+   another item after it */
+static gboolean
+loaded_check (gpointer user_data)
+{
+	DbusmenuMenuitem * item = client_item(ICON_ID);
+	if (item == NULL || !dbusmenu_menuitem_property_exist(item, DBUSMENU_MENUITEM_PROP_ICON_DATA)) {
+		return TRUE;
+	}
+
+	g_atomic_int_set(&watching, 1);
+
+	DbusmenuMenuitem * sitem = dbusmenu_menuitem_child_find(root, ICON_ID);
+	dbusmenu_menuitem_property_set(sitem, DBUSMENU_MENUITEM_PROP_LABEL, "After");
+
+	DbusmenuMenuitem * added = dbusmenu_menuitem_new_with_id(ADDED_ID);
+	dbusmenu_menuitem_property_set(added, DBUSMENU_MENUITEM_PROP_LABEL, "Added");
+	dbusmenu_menuitem_child_append(root, added);
+	g_object_unref(added);
+
+	g_timeout_add(100, changed_check, NULL);
+	return FALSE;
+}
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_timeout_add(100, loaded_check, NULL);
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_warning("Unable to get name '%s' on DBus", name);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_add_filter(bus, message_filter, NULL, NULL);
+
+	server = dbusmenu_server_new("/org/test");
+	root = dbusmenu_menuitem_new_with_id(0);
+
+	guchar * icon = g_malloc0(ICON_BYTES);
+	DbusmenuMenuitem * item = dbusmenu_menuitem_new_with_id(ICON_ID);
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, "Before");
+	dbusmenu_menuitem_property_set_byte_array(item, DBUSMENU_MENUITEM_PROP_ICON_DATA, icon, ICON_BYTES);
+	dbusmenu_menuitem_child_append(root, item);
+	g_object_unref(item);
+	g_free(icon);
+
+	dbusmenu_server_set_root(server, root);
+
+	g_bus_own_name_on_connection(bus,
+	                             "org.dbusmenu.test",
+	                             G_BUS_NAME_OWNER_FLAGS_NONE,
+	                             on_bus,
+	                             name_lost,
+	                             NULL,
+	                             NULL);
+
+	g_timeout_add_seconds(10, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,228 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* A root with BENCH_WIDTH submenus of BENCH_WIDTH items each,
+   which is set and cleared BENCH_ROUNDS times.  Then one of the
+   submenus gets moved around BENCH_ROUNDS times. */
+#define BENCH_WIDTH    100
+#define BENCH_ROUNDS   20
+#define BENCH_PROBE    "x-bench"
+
+static DbusmenuMenuitem * submenus[BENCH_WIDTH];
+static DbusmenuMenuitem * detached = NULL;
+static gint probe_id = 0;
+static gint detached_id = 0;
+static gboolean probing = FALSE;
+static gboolean passed = TRUE;
+static GMainLoop * mainloop = NULL;
+
+/* Builds the tree, returning how many items are in it */
+static DbusmenuMenuitem *
+build_tree (guint * count)
+{
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	gint nextid = 1;
+	guint i, j;
+
+	*count = 1;
+
+	for (i = 0; i < BENCH_WIDTH; i++) {
+		submenus[i] = dbusmenu_menuitem_new_with_id(nextid++);
+		dbusmenu_menuitem_property_set(submenus[i], DBUSMENU_MENUITEM_PROP_LABEL, "Submenu");
+		dbusmenu_menuitem_child_append(root, submenus[i]);
+		g_object_unref(submenus[i]);
+		(*count)++;
+
+		for (j = 0; j < BENCH_WIDTH; j++) {
+			DbusmenuMenuitem * item = dbusmenu_menuitem_new_with_id(nextid++);
+			dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, "Item");
+			dbusmenu_menuitem_child_append(submenus[i], item);
+			g_object_unref(item);
+			(*count)++;
+		}
+	}
+
+	return root;
+}
+
+/* Only the item that is still in the tree should get sent, the
+   one that was taken out of it shouldn't be seen by the server */
+static void
+properties_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	/* The root's own properties get sent when it's set */
+	if (!probing) {
+		return;
+	}
+
+	GVariant * updated = g_variant_get_child_value(params, 0);
+	gboolean found = FALSE;
+	guint i;
+
+	for (i = 0; i < g_variant_n_children(updated); i++) {
+		gint id;
+		g_variant_get_child(updated, i, "(i@a{sv})", &id, NULL);
+
+		if (id == probe_id) {
+			found = TRUE;
+		} else if (id == detached_id) {
+			g_warning("Item %d was sent after it left the tree", id);
+			passed = FALSE;
+		}
+	}
+
+	if (!found) {
+		g_warning("Item %d wasn't sent", probe_id);
+		passed = FALSE;
+	}
+
+	g_variant_unref(updated);
+	g_main_loop_quit(mainloop);
+
+	return;
+}
+
+/* Change a property on an item in the tree and one that's been
+   taken out of it */
+static gboolean
+probe_func (gpointer data)
+{
+	GList * children = dbusmenu_menuitem_get_children(detached);
+	detached_id = dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data));
+	probing = TRUE;
+	dbusmenu_menuitem_property_set_int(DBUSMENU_MENUITEM(children->data), BENCH_PROBE, 1);
+
+	children = dbusmenu_menuitem_get_children(submenus[BENCH_WIDTH - 1]);
+	probe_id = dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(children->data));
+	dbusmenu_menuitem_property_set_int(DBUSMENU_MENUITEM(children->data), BENCH_PROBE, 1);
+
+	return FALSE;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	guint count;
+	guint i;
+
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "ItemsPropertiesUpdated", /* member */
+	                                   "/org/test", /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   properties_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = build_tree(&count);
+
+	gint64 set_usec = 0;
+	gint64 clear_usec = 0;
+
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		gint64 start = g_get_monotonic_time();
+		dbusmenu_server_set_root(server, root);
+		gint64 middle = g_get_monotonic_time();
+		g_object_set(G_OBJECT(server), DBUSMENU_SERVER_PROP_ROOT_NODE, NULL, NULL);
+		gint64 end = g_get_monotonic_time();
+
+		set_usec += middle - start;
+		clear_usec += end - middle;
+	}
+
+	g_print("{\"probe\": \"set_root\", \"items\": %d, \"rounds\": %d, \"set_usec\": %" G_GINT64_FORMAT ", \"clear_usec\": %" G_GINT64_FORMAT "}\n",
+	        count, BENCH_ROUNDS, set_usec / BENCH_ROUNDS, clear_usec / BENCH_ROUNDS);
+
+	/* Move the first submenu between the ends of the root */
+	dbusmenu_server_set_root(server, root);
+
+	DbusmenuMenuitem * moving = submenus[0];
+	g_object_ref(moving);
+
+	gint64 move_usec = 0;
+	for (i = 0; i < BENCH_ROUNDS; i++) {
+		gint64 start = g_get_monotonic_time();
+		dbusmenu_menuitem_child_delete(root, moving);
+		if (i % 2 == 0) {
+			dbusmenu_menuitem_child_append(root, moving);
+		} else {
+			dbusmenu_menuitem_child_prepend(root, moving);
+		}
+		move_usec += g_get_monotonic_time() - start;
+	}
+
+	g_print("{\"probe\": \"move_subtree\", \"items\": %d, \"rounds\": %d, \"usec\": %" G_GINT64_FORMAT "}\n",
+	        BENCH_WIDTH + 1, BENCH_ROUNDS, move_usec / BENCH_ROUNDS);
+
+	/* Take it out for good, the server shouldn't hear about it
+	   anymore */
+	dbusmenu_menuitem_child_delete(root, moving);
+	detached = moving;
+
+	/* Give the server a chance to get on the bus */
+	g_timeout_add(500, probe_func, NULL);
+	g_timeout_add_seconds(10, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	/* The counters should only see what's left in the tree */
+	GVariant * stats = dbusmenu_server_get_stats(server);
+	guint items = 0;
+	guint signals = 0;
+	g_variant_lookup(stats, "items", "u", &items);
+	g_variant_lookup(stats, "property-signals", "u", &signals);
+
+	if (items != count - (BENCH_WIDTH + 1) || signals == 0) {
+		g_warning("Stats have %d items and %d signals", items, signals);
+		passed = FALSE;
+	}
+	g_variant_unref(stats);
+
+	g_object_unref(G_OBJECT(detached));
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
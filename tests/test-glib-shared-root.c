@@ -0,0 +1,209 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* Two servers show the same root.  A change to an item has to be
+   sent by both of them, and once one of them is gone the other
+   still has to send the next one. */
+#define PATH_ONE       "/org/test/one"
+#define PATH_TWO       "/org/test/two"
+#define TEST_ID        1
+
+static DbusmenuServer * one = NULL;
+static DbusmenuServer * two = NULL;
+static DbusmenuMenuitem * item = NULL;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+static guint exported = 0;
+static guint step = 0;
+static guint heard_one = 0;
+static guint heard_two = 0;
+
+static void get_layout (const gchar * path);
+
+/* Changes the label for the next step */
+static gboolean
+change_label (gpointer user_data)
+{
+	gchar * label = g_strdup_printf("Round %d", step);
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, label);
+	g_free(label);
+	return FALSE;
+}
+
+/* Waits to see if a signal comes that shouldn't, then checks
+   what was heard in the step */
+static gboolean
+step_check (gpointer user_data)
+{
+	if (step == 0) {
+		if (heard_one != 1 || heard_two != 1) {
+			g_warning("With both servers heard %d and %d signals", heard_one, heard_two);
+			passed = FALSE;
+			g_main_loop_quit(mainloop);
+			return FALSE;
+		}
+
+		/* Only the second one is left to tell about the next */
+		g_object_unref(one);
+		one = NULL;
+		step++;
+		heard_one = heard_two = 0;
+		change_label(NULL);
+		g_timeout_add(500, step_check, NULL);
+		return FALSE;
+	}
+
+	if (heard_one != 0 || heard_two != 1) {
+		g_warning("With one server heard %d and %d signals", heard_one, heard_two);
+		passed = FALSE;
+	}
+
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Counts the signals from each of the servers */
+static void
+properties_signal (GDBusConnection * connection, const gchar * sender, const gchar * path, const gchar * interface, const gchar * signal, GVariant * params, gpointer user_data)
+{
+	if (g_strcmp0(path, PATH_ONE) == 0) {
+		heard_one++;
+	} else if (g_strcmp0(path, PATH_TWO) == 0) {
+		heard_two++;
+	}
+
+	return;
+}
+
+static gboolean
+get_layout_retry (gpointer user_data)
+{
+	get_layout((const gchar *)user_data);
+	return FALSE;
+}
+
+/* Start changing things once both have sent the item, before
+   that its properties don't go out */
+static void
+get_layout_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), res, &error);
+
+	if (error != NULL) {
+		/* Not on the bus yet */
+		g_error_free(error);
+		g_timeout_add(100, get_layout_retry, user_data);
+		return;
+	}
+
+	g_variant_unref(reply);
+
+	exported++;
+	if (exported == 2) {
+		change_label(NULL);
+		g_timeout_add(500, step_check, NULL);
+	}
+
+	return;
+}
+
+/* Gets the layout from the server at @path the way a client would */
+static void
+get_layout (const gchar * path)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	g_dbus_connection_call(bus,
+	                       g_dbus_connection_get_unique_name(bus),
+	                       path,
+	                       "com.canonical.dbusmenu",
+	                       "GetLayout",
+	                       g_variant_new("(ii@as)", 0, -1, g_variant_new_strv(NULL, 0)),
+	                       G_VARIANT_TYPE("(u(ia{sv}av))"),
+	                       G_DBUS_CALL_FLAGS_NONE,
+	                       -1, NULL,
+	                       get_layout_cb, (gpointer)path);
+
+	g_object_unref(bus);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.  Got to: %d", step);
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+	g_dbus_connection_signal_subscribe(bus,
+	                                   NULL, /* sender */
+	                                   "com.canonical.dbusmenu", /* interface */
+	                                   "ItemsPropertiesUpdated", /* member */
+	                                   NULL, /* object path */
+	                                   NULL, /* arg0 */
+	                                   G_DBUS_SIGNAL_FLAGS_NONE,
+	                                   properties_signal,
+	                                   NULL, /* data */
+	                                   NULL); /* free func */
+
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	item = dbusmenu_menuitem_new_with_id(TEST_ID);
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_LABEL, "Start");
+	dbusmenu_menuitem_child_append(root, item);
+
+	one = dbusmenu_server_new(PATH_ONE);
+	dbusmenu_server_set_root(one, root);
+	two = dbusmenu_server_new(PATH_TWO);
+	dbusmenu_server_set_root(two, root);
+
+	get_layout(PATH_ONE);
+	get_layout(PATH_TWO);
+	g_timeout_add_seconds(10, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	if (one != NULL) {
+		g_object_unref(one);
+	}
+	g_object_unref(two);
+	g_object_unref(item);
+	g_object_unref(root);
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,250 @@
+/*
+A benchmark for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "json-loader.h"
+
+/* A menu of BENCH_WIDTH items per level that is BENCH_DEPTH
+   levels deep, loaded BENCH_ROUNDS times both ways */
+#define BENCH_WIDTH    12
+#define BENCH_DEPTH    3
+#define BENCH_ROUNDS   5
+
+static gint nextid = 1;
+static guint items = 0;
+static gboolean passed = TRUE;
+
+/* Builds the menu and the JSON that json-loader needs to make
+   the same menu at the same time */
+static DbusmenuMenuitem *
+build_menu (GString * json, guint depth)
+{
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id(nextid);
+	gchar * label = g_strdup_printf("Item %d", nextid);
+
+	g_string_append_printf(json, "{\"id\": %d, \"label\": \"%s\", \"x-bench\": %d", nextid, label, nextid * 7);
+
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, label);
+	dbusmenu_menuitem_property_set_int(mi, "x-bench", nextid * 7);
+
+	if (nextid % 3 == 0) {
+		g_string_append(json, ", \"enabled\": false");
+		dbusmenu_menuitem_property_set_bool(mi, DBUSMENU_MENUITEM_PROP_ENABLED, FALSE);
+	}
+
+	g_free(label);
+	nextid++;
+	items++;
+
+	if (depth > 0) {
+		guint i;
+
+		/* json-loader uses child_append which sets this */
+		g_string_append_printf(json, ", \"%s\": \"%s\", \"submenu\": [", DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+
+		for (i = 0; i < BENCH_WIDTH; i++) {
+			if (i > 0) {
+				g_string_append(json, ", ");
+			}
+
+			DbusmenuMenuitem * child = build_menu(json, depth - 1);
+			dbusmenu_menuitem_child_append(mi, child);
+			g_object_unref(child);
+		}
+
+		g_string_append(json, "]");
+	}
+
+	g_string_append(json, "}");
+
+	return mi;
+}
+
+/* Checks that two trees have the same IDs, properties and
+   children in the same order */
+static gboolean
+compare_menus (DbusmenuMenuitem * one, DbusmenuMenuitem * two)
+{
+	if (dbusmenu_menuitem_get_id(one) != dbusmenu_menuitem_get_id(two)) {
+		g_warning("Item %d was loaded as %d", dbusmenu_menuitem_get_id(one), dbusmenu_menuitem_get_id(two));
+		return FALSE;
+	}
+
+	GList * oneprops = dbusmenu_menuitem_properties_list(one);
+	GList * twoprops = dbusmenu_menuitem_properties_list(two);
+	gboolean same = g_list_length(oneprops) == g_list_length(twoprops);
+	GList * prop;
+
+	for (prop = oneprops; same && prop != NULL; prop = prop->next) {
+		GVariant * oneval = dbusmenu_menuitem_property_get_variant(one, prop->data);
+		GVariant * twoval = dbusmenu_menuitem_property_get_variant(two, prop->data);
+
+		if (twoval == NULL || !g_variant_equal(oneval, twoval)) {
+			g_warning("Item %d has a different '%s'", dbusmenu_menuitem_get_id(one), (gchar *)prop->data);
+			same = FALSE;
+		}
+	}
+
+	g_list_free(oneprops);
+	g_list_free(twoprops);
+
+	if (!same) {
+		g_warning("Item %d has different properties", dbusmenu_menuitem_get_id(one));
+		return FALSE;
+	}
+
+	GList * onechild = dbusmenu_menuitem_get_children(one);
+	GList * twochild = dbusmenu_menuitem_get_children(two);
+
+	for ( ; onechild != NULL && twochild != NULL; onechild = onechild->next, twochild = twochild->next) {
+		if (!compare_menus(DBUSMENU_MENUITEM(onechild->data), DBUSMENU_MENUITEM(twochild->data))) {
+			return FALSE;
+		}
+
+		if (dbusmenu_menuitem_get_parent(DBUSMENU_MENUITEM(twochild->data)) != two) {
+			g_warning("Item %d has the wrong parent", dbusmenu_menuitem_get_id(DBUSMENU_MENUITEM(twochild->data)));
+			return FALSE;
+		}
+	}
+
+	if (onechild != NULL || twochild != NULL) {
+		g_warning("Item %d has a different number of children", dbusmenu_menuitem_get_id(one));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Counts every property and child signal that gets emitted
+   while a menu is loaded */
+static gboolean
+count_signal (GSignalInvocationHint * hint, guint n_params, const GValue * params, gpointer user_data)
+{
+	(*(guint *)user_data)++;
+	return TRUE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	guint i;
+	GError * error = NULL;
+
+	GString * json = g_string_new(NULL);
+	DbusmenuMenuitem * menu = build_menu(json, BENCH_DEPTH);
+
+	gchar * dir = g_dir_make_tmp("dbusmenu-snapshot-XXXXXX", &error);
+	g_assert_no_error(error);
+
+	gchar * jsonfile = g_build_filename(dir, "menu.json", NULL);
+	gchar * snapfile = g_build_filename(dir, "menu.gvariant", NULL);
+
+	g_file_set_contents(jsonfile, json->str, json->len, &error);
+	g_assert_no_error(error);
+
+	dbusmenu_menuitem_snapshot_save(menu, snapfile, &error);
+	g_assert_no_error(error);
+
+	gint64 json_usec = 0;
+	gint64 snap_usec = 0;
+	guint json_signals = 0;
+	guint snap_signals = 0;
+	guint signals = 0;
+
+	g_type_class_ref(DBUSMENU_TYPE_MENUITEM);
+	g_signal_add_emission_hook(g_signal_lookup(DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, DBUSMENU_TYPE_MENUITEM), 0, count_signal, &signals, NULL);
+	g_signal_add_emission_hook(g_signal_lookup(DBUSMENU_MENUITEM_SIGNAL_CHILD_ADDED, DBUSMENU_TYPE_MENUITEM), 0, count_signal, &signals, NULL);
+
+	for (i = 0; passed && i < BENCH_ROUNDS; i++) {
+		signals = 0;
+		gint64 start = g_get_monotonic_time();
+		DbusmenuMenuitem * fromjson = dbusmenu_json_build_from_file(jsonfile);
+		json_usec += g_get_monotonic_time() - start;
+		json_signals = signals;
+
+		signals = 0;
+		start = g_get_monotonic_time();
+		DbusmenuMenuitem * fromsnap = dbusmenu_menuitem_snapshot_load(snapfile, &error);
+		snap_usec += g_get_monotonic_time() - start;
+		snap_signals = signals;
+
+		g_assert_no_error(error);
+
+		if (fromjson == NULL || fromsnap == NULL) {
+			g_warning("Round %d: unable to load the menu", i);
+			passed = FALSE;
+		} else {
+			passed = compare_menus(menu, fromjson) && compare_menus(menu, fromsnap);
+		}
+
+		if (snap_signals != 0) {
+			g_warning("Round %d: loading the snapshot emitted %d signals", i, snap_signals);
+			passed = FALSE;
+		}
+
+		if (fromjson != NULL) {
+			g_object_unref(fromjson);
+		}
+		if (fromsnap != NULL) {
+			g_object_unref(fromsnap);
+		}
+	}
+
+	/* And the same tree once more through the server */
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	if (passed && dbusmenu_server_load_snapshot(server, snapfile, &error)) {
+		GValue root = {0};
+		g_value_init(&root, G_TYPE_OBJECT);
+		g_object_get_property(G_OBJECT(server), DBUSMENU_SERVER_PROP_ROOT_NODE, &root);
+
+		passed = compare_menus(menu, DBUSMENU_MENUITEM(g_value_get_object(&root)));
+
+		g_value_unset(&root);
+	} else {
+		g_assert_no_error(error);
+		passed = FALSE;
+	}
+
+	g_print("{\"items\": %d, \"json_bytes\": %" G_GSIZE_FORMAT ", \"json_usec\": %" G_GINT64_FORMAT ", \"json_signals\": %d, \"snapshot_usec\": %" G_GINT64_FORMAT ", \"snapshot_signals\": %d}\n",
+	        items, json->len, json_usec / BENCH_ROUNDS, json_signals, snap_usec / BENCH_ROUNDS, snap_signals);
+
+	g_object_unref(server);
+	g_object_unref(menu);
+	g_string_free(json, TRUE);
+
+	g_unlink(jsonfile);
+	g_unlink(snapfile);
+	g_rmdir(dir);
+	g_free(jsonfile);
+	g_free(snapfile);
+	g_free(dir);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
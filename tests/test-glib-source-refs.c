@@ -0,0 +1,205 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* A source may hand back a full reference to the properties
+   instead of a floating one.  After the server has sent them every
+   one of those has to be freed, none can be left with a ref the
+   server forgot about. */
+#define MENU_ID        1
+#define FIRST_ID       10
+#define ITEMS          3
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+static gint made = 0;
+static gint freed = 0;
+
+static void get_properties_call (void);
+
+static guint
+get_n_items (gpointer user_data)
+{
+	return ITEMS;
+}
+
+static gint
+get_id (guint index, gpointer user_data)
+{
+	return FIRST_ID + index;
+}
+
+static gint
+lookup_id (gint id, gpointer user_data)
+{
+	if (id < FIRST_ID || id >= FIRST_ID + ITEMS) {
+		return -1;
+	}
+	return id - FIRST_ID;
+}
+
+/* Counts the property data that has been let go, this can be
+   in the GDBus thread once the reply is written */
+static void
+properties_freed (gpointer data)
+{
+	g_variant_unref((GVariant *)data);
+	g_atomic_int_inc(&freed);
+	return;
+}
+
+/* Builds the properties so we know when they're freed and gives
+   them back as a full reference */
+static GVariant *
+get_properties (guint index, gpointer user_data)
+{
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_LABEL, g_variant_new_string("Item"));
+	GVariant * built = g_variant_ref_sink(g_variant_builder_end(&builder));
+
+	GVariant * props = g_variant_new_from_data(G_VARIANT_TYPE("a{sv}"),
+	                                           g_variant_get_data(built),
+	                                           g_variant_get_size(built),
+	                                           TRUE,
+	                                           properties_freed,
+	                                           built);
+	g_atomic_int_inc(&made);
+
+	return g_variant_ref_sink(props);
+}
+
+static const DbusmenuServerSource source = {
+	get_n_items,
+	get_id,
+	lookup_id,
+	get_properties,
+	NULL
+};
+
+/* Gives the reply time to be freed before counting */
+static gboolean
+freed_check (gpointer user_data)
+{
+	if (g_atomic_int_get(&made) != ITEMS || g_atomic_int_get(&freed) != ITEMS) {
+		g_warning("Made %d sets of properties and freed %d", g_atomic_int_get(&made), g_atomic_int_get(&freed));
+		passed = FALSE;
+	}
+
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static gboolean
+get_properties_retry (gpointer user_data)
+{
+	get_properties_call();
+	return FALSE;
+}
+
+static void
+get_properties_cb (GObject * object, GAsyncResult * res, gpointer user_data)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_finish(G_DBUS_CONNECTION(object), res, &error);
+
+	if (error != NULL) {
+		/* Not on the bus yet */
+		g_error_free(error);
+		g_timeout_add(100, get_properties_retry, NULL);
+		return;
+	}
+
+	g_variant_unref(reply);
+	g_timeout_add(200, freed_check, NULL);
+	return;
+}
+
+/* Asks for all of the source's items the way a client would */
+static void
+get_properties_call (void)
+{
+	GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	GVariantBuilder ids;
+	g_variant_builder_init(&ids, G_VARIANT_TYPE("ai"));
+	gint i;
+	for (i = 0; i < ITEMS; i++) {
+		g_variant_builder_add(&ids, "i", FIRST_ID + i);
+	}
+
+	g_dbus_connection_call(bus,
+	                       g_dbus_connection_get_unique_name(bus),
+	                       "/org/test",
+	                       "com.canonical.dbusmenu",
+	                       "GetGroupProperties",
+	                       g_variant_new("(@ai@as)", g_variant_builder_end(&ids), g_variant_new_strv(NULL, 0)),
+	                       G_VARIANT_TYPE("(a(ia{sv}))"),
+	                       G_DBUS_CALL_FLAGS_NONE,
+	                       -1, NULL,
+	                       get_properties_cb, NULL);
+
+	g_object_unref(bus);
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_new_with_id(MENU_ID);
+	dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+	dbusmenu_menuitem_child_append(root, menu);
+	dbusmenu_server_set_source(server, menu, &source, NULL, NULL);
+	g_object_unref(menu);
+
+	dbusmenu_server_set_root(server, root);
+
+	get_properties_call();
+	g_timeout_add_seconds(10, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
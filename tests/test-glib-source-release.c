@@ -0,0 +1,146 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of the GNU General Public License version 3, as published
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+/* A source can't keep the item it's on alive, but it has to stay
+   with the item for as long as the item is around.  Moving the
+   item or replacing the root it's under keeps the source, the item
+   going away drops it. */
+#define MENU_ID        1
+#define SUBMENU_ID     2
+#define OTHER_ID       3
+
+static guint
+get_n_items (gpointer user_data)
+{
+	return 0;
+}
+
+static gint
+get_id (guint index, gpointer user_data)
+{
+	return -1;
+}
+
+static gint
+lookup_id (gint id, gpointer user_data)
+{
+	return -1;
+}
+
+static GVariant *
+get_properties (guint index, gpointer user_data)
+{
+	return NULL;
+}
+
+static const DbusmenuServerSource source = {
+	get_n_items,
+	get_id,
+	lookup_id,
+	get_properties,
+	NULL
+};
+
+/* Counts the sources that have been let go */
+static void
+source_destroy (gpointer user_data)
+{
+	guint * destroyed = (guint *)user_data;
+	(*destroyed)++;
+	return;
+}
+
+/* Makes an item with a source on it under @parent, only @parent
+   holds on to it after this */
+static DbusmenuMenuitem *
+source_item (DbusmenuServer * server, DbusmenuMenuitem * parent, gint id, guint * destroyed)
+{
+	DbusmenuMenuitem * item = dbusmenu_menuitem_new_with_id(id);
+	dbusmenu_menuitem_property_set(item, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+	dbusmenu_menuitem_child_append(parent, item);
+	g_object_unref(item);
+
+	dbusmenu_server_set_source(server, item, &source, destroyed, source_destroy);
+	return item;
+}
+
+int
+main (int argc, char ** argv)
+{
+	gboolean passed = TRUE;
+	guint destroyed = 0;
+
+	DbusmenuServer * server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+	dbusmenu_server_set_root(server, root);
+
+	/* Moved to another parent, with a source under it too */
+	DbusmenuMenuitem * menu = source_item(server, root, MENU_ID, &destroyed);
+	DbusmenuMenuitem * submenu = source_item(server, menu, SUBMENU_ID, &destroyed);
+	g_object_add_weak_pointer(G_OBJECT(menu), (gpointer *)&menu);
+	g_object_add_weak_pointer(G_OBJECT(submenu), (gpointer *)&submenu);
+
+	DbusmenuMenuitem * other = dbusmenu_menuitem_new_with_id(OTHER_ID);
+	dbusmenu_menuitem_child_append(root, other);
+	g_object_unref(other);
+
+	g_object_ref(menu);
+	dbusmenu_menuitem_child_delete(root, menu);
+	dbusmenu_menuitem_child_append(other, menu);
+	g_object_unref(menu);
+
+	if (destroyed != 0) {
+		g_warning("Moving the item freed %d sources", destroyed);
+		passed = FALSE;
+	}
+
+	/* Under a root that gets replaced */
+	DbusmenuMenuitem * newroot = dbusmenu_menuitem_new_with_id(0);
+	dbusmenu_server_set_root(server, newroot);
+
+	if (destroyed != 0) {
+		g_warning("Replacing the root freed %d sources", destroyed);
+		passed = FALSE;
+	}
+
+	/* Taken out with nothing else holding it */
+	dbusmenu_menuitem_child_delete(other, menu);
+
+	if (destroyed != 2 || menu != NULL || submenu != NULL) {
+		g_warning("Removing the item freed %d sources and left it %s", destroyed, menu != NULL ? "alive" : "freed");
+		passed = FALSE;
+	}
+
+	g_object_unref(G_OBJECT(newroot));
+	g_object_unref(G_OBJECT(root));
+	g_object_unref(G_OBJECT(server));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
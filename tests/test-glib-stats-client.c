@@ -0,0 +1,278 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-stats.h"
+
+static DbusmenuClient * client = NULL;
+static GDBusConnection * bus = NULL;
+static GMainLoop * mainloop = NULL;
+static gboolean passed = TRUE;
+
+/* The counters from before the label changed */
+static GVariant * server_before = NULL;
+static GVariant * client_before = NULL;
+
+/* Reads the Stats property the way a tool would */
+static GVariant *
+server_stats (void)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_sync(bus,
+	                                               "org.dbusmenu.test",
+	                                               "/org/test",
+	                                               "org.freedesktop.DBus.Properties",
+	                                               "Get",
+	                                               g_variant_new("(ss)", "com.canonical.dbusmenu.Stats", "Stats"),
+	                                               G_VARIANT_TYPE("(v)"),
+	                                               G_DBUS_CALL_FLAGS_NONE,
+	                                               -1, NULL,
+	                                               &error);
+
+	if (error != NULL) {
+		g_warning("Unable to get the server's stats: %s", error->message);
+		g_error_free(error);
+		return NULL;
+	}
+
+	GVariant * stats = NULL;
+	g_variant_get(reply, "(v)", &stats);
+	g_variant_unref(reply);
+
+	return stats;
+}
+
+/* Gets a counter whichever size it is */
+static guint64
+stat_get (GVariant * stats, const gchar * name)
+{
+	GVariant * value = g_variant_lookup_value(stats, name, NULL);
+	guint64 ret = 0;
+
+	if (value == NULL) {
+		g_warning("No '%s' in the stats", name);
+		passed = FALSE;
+		return 0;
+	}
+
+	if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT32)) {
+		ret = g_variant_get_uint32(value);
+	} else if (g_variant_is_of_type(value, G_VARIANT_TYPE_UINT64)) {
+		ret = g_variant_get_uint64(value);
+	} else {
+		g_warning("'%s' is of type '%s'", name, g_variant_get_type_string(value));
+		passed = FALSE;
+	}
+
+	g_variant_unref(value);
+	return ret;
+}
+
+/* Checks that a counter went up by @change since @before */
+static void
+stat_check (const gchar * side, GVariant * before, GVariant * after, const gchar * name, guint64 change)
+{
+	guint64 was = stat_get(before, name);
+	guint64 now = stat_get(after, name);
+
+	if (now != was + change) {
+		g_warning("The %s's '%s' went from %" G_GUINT64_FORMAT " to %" G_GUINT64_FORMAT ", expected %" G_GUINT64_FORMAT,
+		          side, name, was, now, was + change);
+		passed = FALSE;
+	}
+
+	return;
+}
+
+/* Makes a call to the server directly, without the client */
+static void
+server_call (const gchar * method, GVariant * params)
+{
+	GError * error = NULL;
+	GVariant * reply = g_dbus_connection_call_sync(bus,
+	                                               "org.dbusmenu.test",
+	                                               "/org/test",
+	                                               "com.canonical.dbusmenu",
+	                                               method,
+	                                               params,
+	                                               NULL,
+	                                               G_DBUS_CALL_FLAGS_NONE,
+	                                               -1, NULL,
+	                                               &error);
+
+	if (error != NULL) {
+		g_warning("Unable to call %s: %s", method, error->message);
+		g_error_free(error);
+		passed = FALSE;
+		return;
+	}
+
+	g_variant_unref(reply);
+	return;
+}
+
+static DbusmenuMenuitem *
+client_item (gint id)
+{
+	DbusmenuMenuitem * croot = dbusmenu_client_get_root(client);
+	if (croot == NULL) {
+		return NULL;
+	}
+	return dbusmenu_menuitem_child_find(croot, id);
+}
+
+/* Once the new label is in the client, what it took on both sides
+   was a single signal with the changes folded into it */
+static gboolean
+changed_check (gpointer user_data)
+{
+	DbusmenuMenuitem * item = client_item(STATS_CLICKED);
+	if (item == NULL || g_strcmp0(dbusmenu_menuitem_property_get(item, DBUSMENU_MENUITEM_PROP_LABEL), STATS_LABEL) != 0) {
+		return TRUE;
+	}
+
+	GVariant * server_after = server_stats();
+	GVariant * client_after = dbusmenu_client_get_stats(client);
+
+	if (server_after == NULL) {
+		passed = FALSE;
+	} else {
+		stat_check("server", server_before, server_after, "property-signals", 1);
+		stat_check("server", server_before, server_after, "property-entries", 1);
+		stat_check("server", server_before, server_after, "properties-coalesced", STATS_CHANGES - 1);
+		stat_check("server", server_before, server_after, "layout-calls", 0);
+		g_variant_unref(server_after);
+	}
+
+	stat_check("client", client_before, client_after, "property-signals", 1);
+	stat_check("client", client_before, client_after, "property-entries", 1);
+	stat_check("client", client_before, client_after, "layout-calls", 0);
+	stat_check("client", client_before, client_after, "group-property-calls", 0);
+	g_variant_unref(client_after);
+
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+/* Once the client has every item, make some calls of our own and
+   see that the server counted them, then click the item that
+   changes its label */
+static gboolean
+loaded_check (gpointer user_data)
+{
+	gint i;
+	for (i = 0; i < STATS_ITEMS; i++) {
+		DbusmenuMenuitem * item = client_item(STATS_FIRST_ID + i);
+		if (item == NULL || !dbusmenu_menuitem_property_exist(item, DBUSMENU_MENUITEM_PROP_LABEL)) {
+			return TRUE;
+		}
+	}
+
+	GVariant * start = server_stats();
+	if (start == NULL) {
+		passed = FALSE;
+		g_main_loop_quit(mainloop);
+		return FALSE;
+	}
+
+	client_before = dbusmenu_client_get_stats(client);
+
+	if (stat_get(start, "items") != STATS_ITEMS + 1 || stat_get(client_before, "items") != STATS_ITEMS + 1) {
+		g_warning("The server has %d items and the client %d, expected %d",
+		          (gint)stat_get(start, "items"), (gint)stat_get(client_before, "items"), STATS_ITEMS + 1);
+		passed = FALSE;
+	}
+
+	if (stat_get(client_before, "layout-calls") == 0 || stat_get(start, "layout-calls") < stat_get(client_before, "layout-calls")) {
+		g_warning("The client got the layout %d times and the server sent it %d times",
+		          (gint)stat_get(client_before, "layout-calls"), (gint)stat_get(start, "layout-calls"));
+		passed = FALSE;
+	}
+
+	server_call("GetLayout", g_variant_new("(ii@as)", 0, -1, g_variant_new_strv(NULL, 0)));
+
+	GVariantBuilder ids;
+	g_variant_builder_init(&ids, G_VARIANT_TYPE("ai"));
+	for (i = 0; i < STATS_ITEMS; i++) {
+		g_variant_builder_add(&ids, "i", STATS_FIRST_ID + i);
+	}
+	server_call("GetGroupProperties", g_variant_new("(@ai@as)", g_variant_builder_end(&ids), g_variant_new_strv(NULL, 0)));
+
+	server_before = server_stats();
+	if (server_before == NULL) {
+		g_variant_unref(start);
+		passed = FALSE;
+		g_main_loop_quit(mainloop);
+		return FALSE;
+	}
+
+	stat_check("server", start, server_before, "layout-calls", 1);
+	stat_check("server", start, server_before, "group-property-calls", 1);
+	stat_check("server", start, server_before, "properties-coalesced", 0);
+	g_variant_unref(start);
+
+	dbusmenu_menuitem_handle_event(client_item(STATS_CLICKED), DBUSMENU_MENUITEM_EVENT_ACTIVATED, NULL, 0);
+	g_timeout_add(100, changed_check, NULL);
+
+	return FALSE;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+
+	client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_timeout_add(100, loaded_check, NULL);
+
+	g_timeout_add_seconds(5, timer_func, NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	if (server_before != NULL) {
+		g_variant_unref(server_before);
+	}
+	if (client_before != NULL) {
+		g_variant_unref(client_before);
+	}
+	g_object_unref(G_OBJECT(client));
+	g_object_unref(bus);
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
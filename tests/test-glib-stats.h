@@ -0,0 +1,27 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The server has STATS_ITEMS items under its root starting at
+   STATS_FIRST_ID.  Clicking STATS_CLICKED makes it change the label
+   of that item STATS_CHANGES times in a row, which have to go out
+   together in one signal. */
+#define STATS_ITEMS        2
+#define STATS_FIRST_ID     1
+#define STATS_CLICKED      1
+#define STATS_CHANGES      3
+#define STATS_LABEL        "Changed"
@@ -0,0 +1,134 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-virtual-source.h"
+
+static GMainLoop * mainloop = NULL;
+static gboolean passed = FALSE;
+static gboolean sent = FALSE;
+
+/* Checks all the items from the source are there with
+   the right labels, and if the one we clicked has changed */
+static gboolean
+check_menu (DbusmenuMenuitem * menu, gboolean * clicked)
+{
+	GList * children = dbusmenu_menuitem_get_children(menu);
+	gint i;
+
+	if (g_list_length(children) != SOURCE_ITEMS) {
+		g_warning("Submenu has %d children instead of %d", g_list_length(children), SOURCE_ITEMS);
+		return FALSE;
+	}
+
+	for (i = 0; children != NULL; children = g_list_next(children), i++) {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(children->data);
+		const gchar * label = dbusmenu_menuitem_property_get(mi, DBUSMENU_MENUITEM_PROP_LABEL);
+		gchar * expected = NULL;
+
+		if (sent && i == SOURCE_CLICKED && g_strcmp0(label, "Clicked") == 0) {
+			*clicked = TRUE;
+			continue;
+		}
+
+		expected = g_strdup_printf("Item %d", i);
+
+		if (dbusmenu_menuitem_get_id(mi) != SOURCE_FIRST_ID + i || g_strcmp0(label, expected) != 0) {
+			g_warning("Child %d is %d with label '%s' instead of '%s'", i, dbusmenu_menuitem_get_id(mi), label, expected);
+			g_free(expected);
+			return FALSE;
+		}
+
+		g_free(expected);
+	}
+
+	return TRUE;
+}
+
+static void
+layout_updated (DbusmenuClient * client, gpointer data)
+{
+	DbusmenuMenuitem * menu = dbusmenu_menuitem_find_id(dbusmenu_client_get_root(client), SOURCE_MENU_ID);
+
+	if (menu == NULL) {
+		g_warning("Unable to find the submenu");
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	gboolean clicked = FALSE;
+	if (!check_menu(menu, &clicked)) {
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (clicked) {
+		passed = TRUE;
+		g_main_loop_quit(mainloop);
+		return;
+	}
+
+	if (sent) {
+		return;
+	}
+
+	/* Click on one of them, the server tells us it got it
+	   by changing its label */
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_find_id(menu, SOURCE_FIRST_ID + SOURCE_CLICKED);
+	GVariant * empty = g_variant_new_int32(0);
+	dbusmenu_menuitem_handle_event(mi, DBUSMENU_MENUITEM_EVENT_ACTIVATED, empty, 0);
+	sent = TRUE;
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_debug("Death timer.  Oops.");
+	passed = FALSE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+int
+main (int argc, char ** argv)
+{
+	DbusmenuClient * client = dbusmenu_client_new("org.dbusmenu.test", "/org/test");
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_LAYOUT_UPDATED, G_CALLBACK(layout_updated), NULL);
+
+	g_timeout_add_seconds(5, timer_func, client);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_object_unref(G_OBJECT(client));
+
+	if (passed) {
+		g_debug("Quiting");
+		return 0;
+	} else {
+		g_debug("Quiting as we're a failure");
+		return 1;
+	}
+}
@@ -0,0 +1,150 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <libdbusmenu-glib/server.h>
+#include <libdbusmenu-glib/menuitem.h>
+
+#include "test-glib-virtual-source.h"
+
+static GMainLoop * mainloop = NULL;
+static DbusmenuServer * server = NULL;
+static DbusmenuMenuitem * menu = NULL;
+static gint clicked = -1;
+
+static gboolean
+timer_func (gpointer data)
+{
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static guint
+get_n_items (gpointer user_data)
+{
+	return SOURCE_ITEMS;
+}
+
+static gint
+get_id (guint index, gpointer user_data)
+{
+	return SOURCE_FIRST_ID + index;
+}
+
+static gint
+lookup_id (gint id, gpointer user_data)
+{
+	if (id < SOURCE_FIRST_ID || id >= SOURCE_FIRST_ID + SOURCE_ITEMS) {
+		return -1;
+	}
+	return id - SOURCE_FIRST_ID;
+}
+
+static GVariant *
+get_properties (guint index, gpointer user_data)
+{
+	GVariantBuilder builder;
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+	gchar * label = NULL;
+	if ((gint)index == clicked) {
+		label = g_strdup("Clicked");
+	} else {
+		label = g_strdup_printf("Item %d", index);
+	}
+
+	g_variant_builder_add(&builder, "{sv}", DBUSMENU_MENUITEM_PROP_LABEL, g_variant_new_string(label));
+	g_free(label);
+
+	return g_variant_builder_end(&builder);
+}
+
+/* Change the label of what got clicked so the client can see
+   that we got it */
+static void
+event (gint id, const gchar * name, GVariant * value, guint timestamp, gpointer user_data)
+{
+	if (g_strcmp0(name, DBUSMENU_MENUITEM_EVENT_ACTIVATED) != 0) {
+		return;
+	}
+
+	g_debug("Item %d clicked", id);
+	clicked = lookup_id(id, user_data);
+	dbusmenu_server_source_changed(server, menu);
+
+	return;
+}
+
+static const DbusmenuServerSource source = {
+	get_n_items,
+	get_id,
+	lookup_id,
+	get_properties,
+	event
+};
+
+static void
+on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	server = dbusmenu_server_new("/org/test");
+	DbusmenuMenuitem * root = dbusmenu_menuitem_new_with_id(0);
+
+	menu = dbusmenu_menuitem_new_with_id(SOURCE_MENU_ID);
+	dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_LABEL, "Menu");
+	dbusmenu_menuitem_property_set(menu, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+	dbusmenu_menuitem_child_append(root, menu);
+
+	dbusmenu_server_set_source(server, menu, &source, NULL, NULL);
+
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(root);
+
+	g_timeout_add_seconds(10, timer_func, server);
+
+	return;
+}
+
+static void
+name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+int
+main (int argc, char ** argv)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               "org.dbusmenu.test",
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               on_bus,
+	               NULL,
+	               name_lost,
+	               NULL,
+	               NULL);
+
+	mainloop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(mainloop);
+
+	g_debug("Quiting");
+
+	return 0;
+}
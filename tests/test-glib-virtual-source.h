@@ -0,0 +1,24 @@
+/*
+A test for libdbusmenu to ensure its quality.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it 
+under the terms of the GNU General Public License version 3, as published 
+by the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but 
+WITHOUT ANY WARRANTY; without even the implied warranties of 
+MERCHANTABILITY, SATISFACTORY QUALITY, or FITNESS FOR A PARTICULAR 
+PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along 
+with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The submenu whose children come from a source and the
+   SOURCE_ITEMS items in it, starting at SOURCE_FIRST_ID */
+#define SOURCE_MENU_ID     100
+#define SOURCE_ITEMS       5000
+#define SOURCE_FIRST_ID    1000
+#define SOURCE_CLICKED     2500
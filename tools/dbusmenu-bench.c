@@ -0,0 +1,666 @@
+/*
+A library to communicate a menu object set accross DBus and
+track updates and maintain consistency.
+
+Copyright 2026 AyatanaIndicators
+
+This program is free software: you can redistribute it and/or modify it
+under the terms of either or both of the following licenses:
+
+1) the GNU Lesser General Public License version 3, as published by the
+Free Software Foundation; and/or
+2) the GNU Lesser General Public License version 2.1, as published by
+the Free Software Foundation.
+
+This program is distributed in the hope that it will be useful, but
+WITHOUT ANY WARRANTY; without even the implied warranties of
+MERCHANTABILITY, SATISFACTORY QUALITY or FITNESS FOR A PARTICULAR
+PURPOSE.  See the applicable version of the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of both the GNU Lesser General Public
+License version 3 and version 2.1 along with this program.  If not, see
+<http://www.gnu.org/licenses/>
+*/
+
+#include <signal.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <json-glib/json-glib.h>
+
+#include <libdbusmenu-glib/client.h>
+#include <libdbusmenu-glib/menuitem.h>
+#include <libdbusmenu-glib/server.h>
+
+#include "tests/json-loader.h"
+
+#define BENCH_SERVICE    "org.dbusmenu.test"
+#define BENCH_PATH       "/MenuBar"
+#define BENCH_INTERFACE  "com.canonical.dbusmenu"
+#define BENCH_STAMP      "x-bench-stamp"
+#define BENCH_EVENT      "x-bench-event"
+#define BENCH_TIMEOUT    60
+
+static gint count = 100;
+static gchar * json = NULL;
+static gint width = 10;
+static gint depth = 3;
+static gboolean server_mode = FALSE;
+
+static GOptionEntry entries[] = {
+	{ "count",  'c', 0, G_OPTION_ARG_INT,      &count,       "Number of times each method is called", "COUNT" },
+	{ "json",   'j', 0, G_OPTION_ARG_FILENAME, &json,        "Load the menu from a JSON file instead of generating one", "FILE" },
+	{ "width",  'w', 0, G_OPTION_ARG_INT,      &width,       "Children per submenu of the generated menu", "WIDTH" },
+	{ "depth",  'd', 0, G_OPTION_ARG_INT,      &depth,       "Submenu levels of the generated menu", "DEPTH" },
+	{ "server", 0,   G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &server_mode, NULL, NULL },
+	{ NULL }
+};
+
+/*
+ * Server side
+ */
+
+/* Builds WIDTH children under @parent and recurses until
+   we've got DEPTH levels */
+static void
+synthetic_fill (DbusmenuMenuitem * parent, gint level, gint * nextid)
+{
+	gint i;
+
+	for (i = 0; i < width; i++) {
+		DbusmenuMenuitem * mi = dbusmenu_menuitem_new_with_id((*nextid)++);
+
+		gchar * label = g_strdup_printf("Item %d", dbusmenu_menuitem_get_id(mi));
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, label);
+		g_free(label);
+
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_ICON_NAME, "document-open");
+
+		if (i % 5 == 4) {
+			dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_TYPE, DBUSMENU_MENUITEM_TOGGLE_CHECK);
+			dbusmenu_menuitem_property_set_int(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_STATE, DBUSMENU_MENUITEM_TOGGLE_STATE_CHECKED);
+		}
+
+		if (level + 1 < depth) {
+			dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+			synthetic_fill(mi, level + 1, nextid);
+		}
+
+		dbusmenu_menuitem_child_append(parent, mi);
+		g_object_unref(G_OBJECT(mi));
+	}
+
+	return;
+}
+
+/* Loads the menu through the JSON loader.  The files shipped
+   for dbusmenu-testapp have an array of top level items, others
+   have a single root object. */
+static DbusmenuMenuitem *
+json_root (const gchar * filename)
+{
+	JsonParser * parser = json_parser_new();
+	GError * error = NULL;
+
+	if (!json_parser_load_from_file(parser, filename, &error)) {
+		g_warning("Failed parsing file %s because: %s", filename, error->message);
+		g_error_free(error);
+		g_object_unref(parser);
+		return NULL;
+	}
+
+	DbusmenuMenuitem * root = NULL;
+	JsonNode * node = json_parser_get_root(parser);
+
+	if (JSON_NODE_TYPE(node) == JSON_NODE_ARRAY) {
+		JsonArray * array = json_node_get_array(node);
+		guint i;
+
+		root = dbusmenu_menuitem_new_with_id(0);
+		for (i = 0; i < json_array_get_length(array); i++) {
+			DbusmenuMenuitem * child = dbusmenu_json_build_from_node(json_array_get_element(array, i));
+			if (child != NULL) {
+				dbusmenu_menuitem_child_append(root, child);
+				g_object_unref(G_OBJECT(child));
+			}
+		}
+	} else {
+		root = dbusmenu_json_build_from_node(node);
+	}
+
+	g_object_unref(parser);
+	return root;
+}
+
+/* Stamps the root with the time right before we set it so the
+   client can see how long the change took to get to it */
+static void
+stamp_event (DbusmenuMenuitem * mi, gchar * name, GVariant * variant, guint timestamp, gpointer user_data)
+{
+	if (g_strcmp0(name, BENCH_STAMP) != 0) {
+		return;
+	}
+
+	gchar * stamp = g_strdup_printf("%" G_GINT64_FORMAT, g_get_monotonic_time());
+	dbusmenu_menuitem_property_set(mi, BENCH_STAMP, stamp);
+	g_free(stamp);
+
+	return;
+}
+
+static void
+server_on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	DbusmenuMenuitem * root = NULL;
+
+	if (json != NULL) {
+		root = json_root(json);
+	} else {
+		gint nextid = 1;
+		root = dbusmenu_menuitem_new_with_id(0);
+		synthetic_fill(root, 0, &nextid);
+	}
+
+	if (root == NULL) {
+		g_error("Unable to build a menu to benchmark");
+		return;
+	}
+
+	g_signal_connect(G_OBJECT(root), DBUSMENU_MENUITEM_SIGNAL_EVENT, G_CALLBACK(stamp_event), NULL);
+
+	DbusmenuServer * server = dbusmenu_server_new(BENCH_PATH);
+	dbusmenu_server_set_root(server, root);
+	g_object_unref(G_OBJECT(root));
+
+	return;
+}
+
+static void
+server_name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
+{
+	g_error("Unable to get name '%s' on DBus", name);
+	return;
+}
+
+/* Runs in the child we spawn on the private bus, the parent
+   kills us when it's done. */
+static int
+server_main (void)
+{
+	g_bus_own_name(G_BUS_TYPE_SESSION,
+	               BENCH_SERVICE,
+	               G_BUS_NAME_OWNER_FLAGS_NONE,
+	               server_on_bus,
+	               NULL,
+	               server_name_lost,
+	               NULL,
+	               NULL);
+
+	GMainLoop * loop = g_main_loop_new(NULL, FALSE);
+	g_main_loop_run(loop);
+	g_main_loop_unref(loop);
+
+	return 0;
+}
+
+/*
+ * Client side
+ */
+
+static GMainLoop * mainloop = NULL;
+static gboolean timed_out = FALSE;
+
+/* Sort helper for the samples */
+static gint
+sample_compare (gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *)a;
+	gint64 y = *(const gint64 *)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Nearest rank percentile of sorted samples */
+static gint64
+sample_percentile (GArray * samples, guint percent)
+{
+	if (samples->len == 0) {
+		return 0;
+	}
+
+	guint rank = (samples->len * percent + 99) / 100;
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	return g_array_index(samples, gint64, rank - 1);
+}
+
+/* Quotes @str for a JSON string.  g_strescape() uses octal
+   escapes, which JSON doesn't have, so control characters are
+   written as \uXXXX and everything else is left as UTF-8. */
+static gchar *
+json_escape (const gchar * str)
+{
+	GString * out = g_string_new(NULL);
+	const gchar * c;
+
+	for (c = str; *c != '\0'; c++) {
+		switch (*c) {
+		case '"':
+			g_string_append(out, "\\\"");
+			break;
+		case '\\':
+			g_string_append(out, "\\\\");
+			break;
+		default:
+			if ((guchar)*c < 0x20) {
+				g_string_append_printf(out, "\\u%04x", (guchar)*c);
+			} else {
+				g_string_append_c(out, *c);
+			}
+			break;
+		}
+	}
+
+	return g_string_free(out, FALSE);
+}
+
+/* Prints one probe as a JSON object, sorting the samples as
+   a side effect */
+static void
+print_samples (const gchar * name, GArray * samples, gint64 total, gboolean last)
+{
+	gint64 sum = 0;
+	guint i;
+
+	g_array_sort(samples, sample_compare);
+
+	for (i = 0; i < samples->len; i++) {
+		sum += g_array_index(samples, gint64, i);
+	}
+
+	g_print("    \"%s\": {\"calls\": %u, \"mean_usec\": %" G_GINT64_FORMAT ", \"p50_usec\": %" G_GINT64_FORMAT ", \"p95_usec\": %" G_GINT64_FORMAT ", \"p99_usec\": %" G_GINT64_FORMAT ", \"max_usec\": %" G_GINT64_FORMAT ", \"per_sec\": %.1f}%s\n",
+	        name,
+	        samples->len,
+	        samples->len > 0 ? sum / samples->len : 0,
+	        sample_percentile(samples, 50),
+	        sample_percentile(samples, 95),
+	        sample_percentile(samples, 99),
+	        samples->len > 0 ? g_array_index(samples, gint64, samples->len - 1) : 0,
+	        total > 0 ? (gdouble)samples->len * G_USEC_PER_SEC / total : 0.0,
+	        last ? "" : ",");
+
+	return;
+}
+
+/* Calls @method COUNT times, recording how long each one took */
+static GArray *
+probe (GDBusConnection * bus, const gchar * method, GVariant * params, gint64 * total)
+{
+	GArray * samples = g_array_sized_new(FALSE, FALSE, sizeof(gint64), count);
+	gint64 start = g_get_monotonic_time();
+	gint i;
+
+	g_variant_ref_sink(params);
+
+	for (i = 0; i < count; i++) {
+		GError * error = NULL;
+		gint64 before = g_get_monotonic_time();
+
+		GVariant * reply = g_dbus_connection_call_sync(bus,
+		                                               BENCH_SERVICE,
+		                                               BENCH_PATH,
+		                                               BENCH_INTERFACE,
+		                                               method,
+		                                               params,
+		                                               NULL,
+		                                               G_DBUS_CALL_FLAGS_NONE,
+		                                               -1,
+		                                               NULL,
+		                                               &error);
+
+		gint64 elapsed = g_get_monotonic_time() - before;
+
+		if (reply == NULL) {
+			g_warning("Unable to call %s: %s", method, error->message);
+			g_error_free(error);
+			break;
+		}
+
+		g_variant_unref(reply);
+		g_array_append_val(samples, elapsed);
+	}
+
+	*total = g_get_monotonic_time() - start;
+	g_variant_unref(params);
+
+	return samples;
+}
+
+/* Grabs all the IDs out of a layout */
+static void
+layout_ids (GVariant * layout, GArray * ids)
+{
+	gint32 id;
+	GVariant * children;
+
+	g_variant_get(layout, "(i@a{sv}@av)", &id, NULL, &children);
+	g_array_append_val(ids, id);
+
+	GVariantIter iter;
+	GVariant * child;
+	g_variant_iter_init(&iter, children);
+	while ((child = g_variant_iter_next_value(&iter)) != NULL) {
+		GVariant * inner = g_variant_get_variant(child);
+		layout_ids(inner, ids);
+		g_variant_unref(inner);
+		g_variant_unref(child);
+	}
+
+	g_variant_unref(children);
+	return;
+}
+
+/* Builds an "ai" out of the IDs we found */
+static GVariant *
+ids_variant (GArray * ids)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_variant_builder_init(&builder, G_VARIANT_TYPE("ai"));
+	for (i = 0; i < ids->len; i++) {
+		g_variant_builder_add(&builder, "i", g_array_index(ids, gint32, i));
+	}
+
+	return g_variant_builder_end(&builder);
+}
+
+/* Tracking the property set to property changed round */
+typedef struct _stamp_t stamp_t;
+struct _stamp_t {
+	GDBusConnection * bus;
+	DbusmenuMenuitem * root;
+	GArray * samples;
+	gint64 start;
+	gint64 total;
+};
+
+/* Ask the server to stamp the root again */
+static void
+stamp_request (stamp_t * stamp)
+{
+	g_dbus_connection_call(stamp->bus,
+	                       BENCH_SERVICE,
+	                       BENCH_PATH,
+	                       BENCH_INTERFACE,
+	                       "Event",
+	                       g_variant_new("(isvu)", 0, BENCH_STAMP, g_variant_new_int32(0), 0),
+	                       NULL,
+	                       G_DBUS_CALL_FLAGS_NONE,
+	                       -1,
+	                       NULL,
+	                       NULL,
+	                       NULL);
+	return;
+}
+
+/* The stamp is the server's monotonic time when it set the
+   property, which is shared between processes on Linux. */
+static void
+stamp_changed (DbusmenuMenuitem * mi, gchar * property, GVariant * value, gpointer user_data)
+{
+	stamp_t * stamp = (stamp_t *)user_data;
+
+	if (g_strcmp0(property, BENCH_STAMP) != 0 || value == NULL) {
+		return;
+	}
+
+	gint64 now = g_get_monotonic_time();
+	gint64 set = g_ascii_strtoll(g_variant_get_string(value, NULL), NULL, 10);
+	gint64 elapsed = now - set;
+
+	g_array_append_val(stamp->samples, elapsed);
+
+	if (stamp->samples->len >= (guint)count) {
+		stamp->total = now - stamp->start;
+		g_main_loop_quit(mainloop);
+	} else {
+		stamp_request(stamp);
+	}
+
+	return;
+}
+
+/* Start stamping once the client has a root to watch */
+static void
+stamp_root (DbusmenuClient * client, DbusmenuMenuitem * newroot, gpointer user_data)
+{
+	stamp_t * stamp = (stamp_t *)user_data;
+
+	if (newroot == NULL || stamp->root != NULL) {
+		return;
+	}
+
+	stamp->root = newroot;
+	g_signal_connect(G_OBJECT(newroot), DBUSMENU_MENUITEM_SIGNAL_PROPERTY_CHANGED, G_CALLBACK(stamp_changed), stamp);
+
+	stamp->start = g_get_monotonic_time();
+	stamp_request(stamp);
+
+	return;
+}
+
+static gboolean
+timer_func (gpointer user_data)
+{
+	g_warning("Benchmark took longer than %d seconds", BENCH_TIMEOUT);
+	timed_out = TRUE;
+	g_main_loop_quit(mainloop);
+	return FALSE;
+}
+
+static void
+server_appeared (GDBusConnection * connection, const gchar * name, const gchar * owner, gpointer user_data)
+{
+	g_main_loop_quit(mainloop);
+	return;
+}
+
+/* Runs every probe against the server and prints the results */
+static int
+client_main (GDBusConnection * bus)
+{
+	GArray * ids = g_array_new(FALSE, FALSE, sizeof(gint32));
+	GVariant * reply = g_dbus_connection_call_sync(bus,
+	                                               BENCH_SERVICE,
+	                                               BENCH_PATH,
+	                                               BENCH_INTERFACE,
+	                                               "GetLayout",
+	                                               g_variant_new("(iias)", 0, -1, NULL),
+	                                               G_VARIANT_TYPE("(u(ia{sv}av))"),
+	                                               G_DBUS_CALL_FLAGS_NONE,
+	                                               -1,
+	                                               NULL,
+	                                               NULL);
+
+	if (reply == NULL) {
+		g_warning("Unable to get the layout from the server");
+		g_array_free(ids, TRUE);
+		return 1;
+	}
+
+	GVariant * layout = g_variant_get_child_value(reply, 1);
+	layout_ids(layout, ids);
+	g_variant_unref(layout);
+	g_variant_unref(reply);
+
+	GVariantBuilder events;
+	guint i;
+	g_variant_builder_init(&events, G_VARIANT_TYPE("a(isvu)"));
+	for (i = 0; i < ids->len; i++) {
+		g_variant_builder_add(&events, "(isvu)", g_array_index(ids, gint32, i), BENCH_EVENT, g_variant_new_int32(0), 0);
+	}
+
+	gint64 layout_total, props_total, event_total, show_total;
+	GArray * layout_samples = probe(bus, "GetLayout", g_variant_new("(iias)", 0, -1, NULL), &layout_total);
+	GArray * props_samples = probe(bus, "GetGroupProperties", g_variant_new("(@aias)", ids_variant(ids), NULL), &props_total);
+	GArray * event_samples = probe(bus, "EventGroup", g_variant_new("(a(isvu))", &events), &event_total);
+	GArray * show_samples = probe(bus, "AboutToShowGroup", g_variant_new("(@ai)", ids_variant(ids)), &show_total);
+
+	/* End to end property changes go through a real client */
+	stamp_t stamp = {0};
+	stamp.bus = bus;
+	stamp.samples = g_array_sized_new(FALSE, FALSE, sizeof(gint64), count);
+
+	DbusmenuClient * client = dbusmenu_client_new(BENCH_SERVICE, BENCH_PATH);
+	g_signal_connect(G_OBJECT(client), DBUSMENU_CLIENT_SIGNAL_ROOT_CHANGED, G_CALLBACK(stamp_root), &stamp);
+
+	guint timer = g_timeout_add_seconds(BENCH_TIMEOUT, timer_func, NULL);
+	g_main_loop_run(mainloop);
+	if (!timed_out) {
+		g_source_remove(timer);
+	}
+
+	g_print("{\n");
+	gchar * menu = json_escape(json != NULL ? json : "synthetic");
+	g_print("  \"menu\": \"%s\",\n", menu);
+	g_free(menu);
+	g_print("  \"items\": %u,\n", ids->len);
+	g_print("  \"count\": %d,\n", count);
+	g_print("  \"probes\": {\n");
+	print_samples("GetLayout", layout_samples, layout_total, FALSE);
+	print_samples("GetGroupProperties", props_samples, props_total, FALSE);
+	print_samples("EventGroup", event_samples, event_total, FALSE);
+	print_samples("AboutToShowGroup", show_samples, show_total, FALSE);
+	print_samples("PropertyChanged", stamp.samples, stamp.total, TRUE);
+	g_print("  }\n");
+	g_print("}\n");
+
+	gboolean passed = !timed_out
+		&& layout_samples->len == (guint)count
+		&& props_samples->len == (guint)count
+		&& event_samples->len == (guint)count
+		&& show_samples->len == (guint)count;
+
+	g_object_unref(G_OBJECT(client));
+	g_array_free(layout_samples, TRUE);
+	g_array_free(props_samples, TRUE);
+	g_array_free(event_samples, TRUE);
+	g_array_free(show_samples, TRUE);
+	g_array_free(stamp.samples, TRUE);
+	g_array_free(ids, TRUE);
+
+	return passed ? 0 : 1;
+}
+
+/* Starts a dbus-daemon of our own so that nothing else on the
+   session bus gets in the way of the numbers */
+static gchar *
+bus_spawn (GPid * pid)
+{
+	gchar * argv[] = { "dbus-daemon", "--session", "--nofork", "--print-address", NULL };
+	gint out = -1;
+	GError * error = NULL;
+
+	if (!g_spawn_async_with_pipes(NULL, argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, pid, NULL, &out, NULL, &error)) {
+		g_warning("Unable to start dbus-daemon: %s", error->message);
+		g_error_free(error);
+		return NULL;
+	}
+
+	GIOChannel * channel = g_io_channel_unix_new(out);
+	g_io_channel_set_close_on_unref(channel, TRUE);
+
+	gchar * address = NULL;
+	if (g_io_channel_read_line(channel, &address, NULL, NULL, NULL) != G_IO_STATUS_NORMAL || address == NULL) {
+		g_warning("Unable to read the address of the dbus-daemon");
+		g_free(address);
+		address = NULL;
+	} else {
+		g_strstrip(address);
+	}
+
+	g_io_channel_unref(channel);
+	return address;
+}
+
+int
+main (int argc, char ** argv)
+{
+	GError * error = NULL;
+	GOptionContext * context = g_option_context_new("- time DBusMenu methods on a private bus");
+	g_option_context_add_main_entries(context, entries, NULL);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error)) {
+		g_printerr("%s\n", error->message);
+		g_error_free(error);
+		g_option_context_free(context);
+		return 1;
+	}
+	g_option_context_free(context);
+
+	if (server_mode) {
+		return server_main();
+	}
+
+	if (count < 1 || width < 1 || depth < 1) {
+		g_printerr("Count, width and depth must be positive\n");
+		return 1;
+	}
+
+	GPid bus_pid;
+	gchar * address = bus_spawn(&bus_pid);
+	if (address == NULL) {
+		return 1;
+	}
+
+	/* Both us and the server only see the private bus */
+	g_setenv("DBUS_SESSION_BUS_ADDRESS", address, TRUE);
+
+	gchar * width_str = g_strdup_printf("%d", width);
+	gchar * depth_str = g_strdup_printf("%d", depth);
+	gchar * server_argv[] = { argv[0], "--server", "--width", width_str, "--depth", depth_str,
+	                          json != NULL ? "--json" : NULL, json, NULL };
+	GPid server_pid;
+
+	int retval = 1;
+	if (!g_spawn_async(NULL, server_argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL, &server_pid, &error)) {
+		g_warning("Unable to start the benchmark server: %s", error->message);
+		g_error_free(error);
+	} else {
+		GDBusConnection * bus = g_bus_get_sync(G_BUS_TYPE_SESSION, NULL, NULL);
+		/* We take the bus down ourselves at the end */
+		g_dbus_connection_set_exit_on_close(bus, FALSE);
+		mainloop = g_main_loop_new(NULL, FALSE);
+
+		guint watch = g_bus_watch_name_on_connection(bus, BENCH_SERVICE, G_BUS_NAME_WATCHER_FLAGS_NONE, server_appeared, NULL, NULL, NULL);
+		guint timer = g_timeout_add_seconds(BENCH_TIMEOUT, timer_func, NULL);
+		g_main_loop_run(mainloop);
+		g_bus_unwatch_name(watch);
+
+		if (!timed_out) {
+			g_source_remove(timer);
+
+			retval = client_main(bus);
+		}
+
+		kill(server_pid, SIGTERM);
+		g_spawn_close_pid(server_pid);
+		g_object_unref(bus);
+		g_main_loop_unref(mainloop);
+	}
+
+	kill(bus_pid, SIGTERM);
+	g_spawn_close_pid(bus_pid);
+
+	g_free(width_str);
+	g_free(depth_str);
+	g_free(address);
+
+	return retval;
+}
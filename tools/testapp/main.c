@@ -25,6 +25,9 @@ You should have received a copy of both the GNU Lesser General Public
 License version 3 and version 2.1 along with this program.  If not, see 
 <http://www.gnu.org/licenses/>
 */
+#include <string.h>
+#include <sys/resource.h>
+
 #include <glib.h>
 #include <gio/gio.h>
 
@@ -33,7 +36,69 @@ License version 3 and version 2.1 along with this program.  If not, see
 #include <libdbusmenu-glib/server.h>
 #include <libdbusmenu-glib/menuitem.h>
 
-#define USAGE "dbusmenubench-glibapp <path/to/menu.json>"
+#define USAGE "[path/to/menu.json]"
+
+/* How often the load timers look at what they need to do */
+#define LOAD_TICK_MS    50
+
+/* Menu generation, used when no JSON file is given */
+static gint gen_depth = 3;
+static gint gen_fanout = 10;
+static gint gen_max = 0;
+static gint gen_props = 0;
+static gint gen_toggles = 20;
+static gint gen_icons = 50;
+static gint gen_icon_data = 0;
+
+/* Load */
+static gint seed = 0;
+static gint prop_rate = 0;
+static gint churn_interval = 0;
+static gint storm_interval = 0;
+static gint storm_size = 100;
+static gboolean stats = FALSE;
+
+static GOptionEntry gen_entries[] = {
+	{ "depth",      0, 0, G_OPTION_ARG_INT, &gen_depth,     "Submenu levels of the generated menu (3)", "N" },
+	{ "fanout",     0, 0, G_OPTION_ARG_INT, &gen_fanout,    "Children in each generated submenu (10)", "N" },
+	{ "max-items",  0, 0, G_OPTION_ARG_INT, &gen_max,       "Stop generating after this many items, 0 for no limit", "N" },
+	{ "props",      0, 0, G_OPTION_ARG_INT, &gen_props,     "Extra x-testapp-N string properties on each item", "N" },
+	{ "toggles",    0, 0, G_OPTION_ARG_INT, &gen_toggles,   "Percentage of leaf items that are check or radio items (20)", "PERCENT" },
+	{ "icons",      0, 0, G_OPTION_ARG_INT, &gen_icons,     "Percentage of items with an icon (50)", "PERCENT" },
+	{ "icon-data",  0, 0, G_OPTION_ARG_INT, &gen_icon_data, "Send icons as icon-data of this many bytes instead of icon-name", "BYTES" },
+	{ NULL }
+};
+
+static GOptionEntry load_entries[] = {
+	{ "seed",           0, 0, G_OPTION_ARG_INT,  &seed,           "Seed for the generator and the load, runs with the same seed match", "SEED" },
+	{ "prop-rate",      0, 0, G_OPTION_ARG_INT,  &prop_rate,      "Property changes per second", "N" },
+	{ "churn-interval", 0, 0, G_OPTION_ARG_INT,  &churn_interval, "Insert, remove or reorder a subtree every this many milliseconds", "MS" },
+	{ "storm-interval", 0, 0, G_OPTION_ARG_INT,  &storm_interval, "Flip a batch of toggles every this many milliseconds", "MS" },
+	{ "storm-size",     0, 0, G_OPTION_ARG_INT,  &storm_size,     "Toggles flipped in each storm (100)", "N" },
+	{ "stats",          0, 0, G_OPTION_ARG_NONE, &stats,          "Print CPU time and bus bytes every second as JSON", NULL },
+	{ NULL }
+};
+
+static GRand * generator = NULL;
+
+/* What we've done since the last stats line */
+typedef struct _load_stats_t load_stats_t;
+struct _load_stats_t {
+	guint changes;
+	guint inserts;
+	guint removes;
+	guint moves;
+	guint toggles;
+};
+
+static load_stats_t counts = {0};
+static gint generated = 0;
+
+/* Filled in by the connection filter, which runs on the GDBus
+   worker thread */
+G_LOCK_DEFINE_STATIC(bus_counts);
+static guint64 bus_bytes = 0;
+static guint bus_messages = 0;
 
 static void
 set_props (DbusmenuMenuitem * mi, JsonObject * node)
@@ -115,14 +180,319 @@ void init_menu(DbusmenuMenuitem *root, const char *filename)
 	}
 }
 
+/* Puts an icon on the item, either by name or as a blob of
+   the requested size */
+static void
+gen_icon (DbusmenuMenuitem * mi)
+{
+	if (gen_icon_data <= 0) {
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_ICON_NAME, "document-open");
+		return;
+	}
+
+	guchar * data = g_malloc(gen_icon_data);
+	gint i;
+	for (i = 0; i < gen_icon_data; i++) {
+		data[i] = g_rand_int_range(generator, 0, 256);
+	}
+
+	dbusmenu_menuitem_property_set_byte_array(mi, DBUSMENU_MENUITEM_PROP_ICON_DATA, data, gen_icon_data);
+	g_free(data);
+
+	return;
+}
+
+/* Builds a single item with the property mix that was asked
+   for, without any children */
+static DbusmenuMenuitem *
+gen_item (gboolean submenu)
+{
+	DbusmenuMenuitem * mi = dbusmenu_menuitem_new();
+	gint i;
+
+	gchar * label = g_strdup_printf("Item %d", dbusmenu_menuitem_get_id(mi));
+	dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, label);
+	g_free(label);
+
+	if (g_rand_int_range(generator, 0, 100) < gen_icons) {
+		gen_icon(mi);
+	}
+
+	if (submenu) {
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_CHILD_DISPLAY, DBUSMENU_MENUITEM_CHILD_DISPLAY_SUBMENU);
+	} else if (g_rand_int_range(generator, 0, 100) < gen_toggles) {
+		dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_TYPE,
+		                               g_rand_boolean(generator) ? DBUSMENU_MENUITEM_TOGGLE_CHECK : DBUSMENU_MENUITEM_TOGGLE_RADIO);
+		dbusmenu_menuitem_property_set_int(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_STATE,
+		                                   g_rand_boolean(generator) ? DBUSMENU_MENUITEM_TOGGLE_STATE_CHECKED : DBUSMENU_MENUITEM_TOGGLE_STATE_UNCHECKED);
+	}
+
+	for (i = 0; i < gen_props; i++) {
+		gchar * name = g_strdup_printf("x-testapp-%d", i);
+		gchar * value = g_strdup_printf("%08x", g_rand_int(generator));
+		dbusmenu_menuitem_property_set(mi, name, value);
+		g_free(value);
+		g_free(name);
+	}
+
+	generated++;
+	return mi;
+}
+
+/* Fills @parent with generated children until we're @levels
+   deep or out of items */
+static void
+gen_children (DbusmenuMenuitem * parent, gint levels)
+{
+	gint i;
+
+	for (i = 0; i < gen_fanout; i++) {
+		if (gen_max > 0 && generated >= gen_max) {
+			return;
+		}
+
+		DbusmenuMenuitem * mi = gen_item(levels > 1);
+		dbusmenu_menuitem_child_append(parent, mi);
+		g_object_unref(G_OBJECT(mi));
+
+		if (levels > 1) {
+			gen_children(mi, levels - 1);
+		}
+	}
+
+	return;
+}
+
+/* Finds an item by walking down from the root, stopping at
+   each level one time in @depth.  With @submenu we only stop
+   on items that have children. */
+static DbusmenuMenuitem *
+load_pick (DbusmenuMenuitem * root, gboolean submenu)
+{
+	DbusmenuMenuitem * mi = root;
+
+	while (TRUE) {
+		GList * children = dbusmenu_menuitem_get_children(mi);
+		guint length = g_list_length(children);
+
+		if (length == 0) {
+			return submenu ? dbusmenu_menuitem_get_parent(mi) : mi;
+		}
+
+		DbusmenuMenuitem * child = DBUSMENU_MENUITEM(g_list_nth_data(children, g_rand_int_range(generator, 0, length)));
+
+		if (mi != root && g_rand_int_range(generator, 0, gen_depth + 1) == 0) {
+			return mi;
+		}
+
+		if (submenu && !dbusmenu_menuitem_get_children(child)) {
+			return mi;
+		}
+
+		mi = child;
+	}
+
+	return NULL;
+}
+
+/* Changes a label, or one of the extra properties if there
+   are some */
+static gboolean
+load_props (gpointer user_data)
+{
+	DbusmenuMenuitem * root = DBUSMENU_MENUITEM(user_data);
+	static gint64 last = 0;
+	static gint64 owed = 0;
+
+	gint64 now = g_get_monotonic_time();
+	if (last == 0) {
+		last = now;
+	}
+
+	/* Keep the remainder so low rates still come out right */
+	owed += (now - last) * prop_rate;
+	last = now;
+
+	while (owed >= G_USEC_PER_SEC) {
+		owed -= G_USEC_PER_SEC;
+
+		DbusmenuMenuitem * mi = load_pick(root, FALSE);
+		if (mi == root) {
+			continue;
+		}
+
+		gchar * value = g_strdup_printf("Item %d (%08x)", dbusmenu_menuitem_get_id(mi), g_rand_int(generator));
+
+		if (gen_props > 0 && g_rand_boolean(generator)) {
+			gchar * name = g_strdup_printf("x-testapp-%d", g_rand_int_range(generator, 0, gen_props));
+			dbusmenu_menuitem_property_set(mi, name, value);
+			g_free(name);
+		} else {
+			dbusmenu_menuitem_property_set(mi, DBUSMENU_MENUITEM_PROP_LABEL, value);
+		}
+
+		g_free(value);
+		counts.changes++;
+	}
+
+	return TRUE;
+}
+
+/* Inserts a fresh subtree, removes one or moves one to another
+   spot in the same submenu */
+static gboolean
+load_churn (gpointer user_data)
+{
+	DbusmenuMenuitem * root = DBUSMENU_MENUITEM(user_data);
+	DbusmenuMenuitem * parent = load_pick(root, TRUE);
+	if (parent == NULL) {
+		parent = root;
+	}
+
+	GList * children = dbusmenu_menuitem_get_children(parent);
+	guint length = g_list_length(children);
+	gint action = length > 0 ? g_rand_int_range(generator, 0, 3) : 0;
+
+	switch (action) {
+	case 0: {
+		DbusmenuMenuitem * mi = gen_item(TRUE);
+		gint oldmax = gen_max;
+
+		gen_max = 0;
+		gen_children(mi, MAX(gen_depth - 1, 1));
+		gen_max = oldmax;
+
+		dbusmenu_menuitem_child_add_position(parent, mi, g_rand_int_range(generator, 0, length + 1));
+		g_object_unref(G_OBJECT(mi));
+		counts.inserts++;
+		break;
+	}
+	case 1: {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(g_list_nth_data(children, g_rand_int_range(generator, 0, length)));
+		dbusmenu_menuitem_child_delete(parent, mi);
+		counts.removes++;
+		break;
+	}
+	case 2: {
+		DbusmenuMenuitem * mi = DBUSMENU_MENUITEM(g_list_nth_data(children, g_rand_int_range(generator, 0, length)));
+		dbusmenu_menuitem_child_reorder(parent, mi, g_rand_int_range(generator, 0, length));
+		counts.moves++;
+		break;
+	}
+	}
+
+	return TRUE;
+}
+
+/* Flips a pile of toggles at once, like a radio group getting
+   rebuilt */
+static gboolean
+load_storm (gpointer user_data)
+{
+	DbusmenuMenuitem * root = DBUSMENU_MENUITEM(user_data);
+	gint i;
+
+	for (i = 0; i < storm_size; i++) {
+		DbusmenuMenuitem * mi = load_pick(root, FALSE);
+		if (mi == root || dbusmenu_menuitem_property_get(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_TYPE) == NULL) {
+			continue;
+		}
+
+		gint state = dbusmenu_menuitem_property_get_int(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_STATE);
+		dbusmenu_menuitem_property_set_int(mi, DBUSMENU_MENUITEM_PROP_TOGGLE_STATE,
+		                                   state == DBUSMENU_MENUITEM_TOGGLE_STATE_CHECKED ? DBUSMENU_MENUITEM_TOGGLE_STATE_UNCHECKED : DBUSMENU_MENUITEM_TOGGLE_STATE_CHECKED);
+		counts.toggles++;
+	}
+
+	return TRUE;
+}
+
+/* Counts everything we send on the bus */
+static GDBusMessage *
+bus_filter (GDBusConnection * connection, GDBusMessage * message, gboolean incoming, gpointer user_data)
+{
+	if (incoming) {
+		return message;
+	}
+
+	gsize size = 0;
+	guchar * blob = g_dbus_message_to_blob(message, &size, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+	g_free(blob);
+
+	G_LOCK(bus_counts);
+	bus_bytes += size;
+	bus_messages++;
+	G_UNLOCK(bus_counts);
+
+	return message;
+}
+
+/* Prints a line of what happened in the last second */
+static gboolean
+load_stats (gpointer user_data)
+{
+	static gint64 last_cpu = 0;
+	static guint seconds = 0;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	gint64 cpu = (gint64)usage.ru_utime.tv_sec * G_USEC_PER_SEC + usage.ru_utime.tv_usec
+	           + (gint64)usage.ru_stime.tv_sec * G_USEC_PER_SEC + usage.ru_stime.tv_usec;
+
+	G_LOCK(bus_counts);
+	guint64 bytes = bus_bytes;
+	guint messages = bus_messages;
+	bus_bytes = 0;
+	bus_messages = 0;
+	G_UNLOCK(bus_counts);
+
+	guint total = counts.changes + counts.inserts + counts.removes + counts.moves + counts.toggles;
+
+	g_print("{\"second\": %u, \"changes\": %u, \"inserts\": %u, \"removes\": %u, \"moves\": %u, \"toggles\": %u, \"cpu_usec\": %" G_GINT64_FORMAT ", \"bus_messages\": %u, \"bus_bytes\": %" G_GUINT64_FORMAT ", \"bytes_per_change\": %.1f}\n",
+	        ++seconds,
+	        counts.changes, counts.inserts, counts.removes, counts.moves, counts.toggles,
+	        cpu - last_cpu,
+	        messages, bytes,
+	        total > 0 ? (gdouble)bytes / total : 0.0);
+
+	last_cpu = cpu;
+	memset(&counts, 0, sizeof(counts));
+
+	return TRUE;
+}
+
 static void
 on_bus (GDBusConnection * connection, const gchar * name, gpointer user_data)
 {
+	const gchar * filename = (const gchar *)user_data;
 	DbusmenuServer *server = dbusmenu_server_new("/MenuBar");
 	DbusmenuMenuitem *root = dbusmenu_menuitem_new_with_id(0);
-	init_menu(root, (gchar *)user_data);
+
+	if (filename != NULL) {
+		init_menu(root, filename);
+	} else {
+		gen_children(root, gen_depth);
+	}
+
 	dbusmenu_server_set_root(server, root);
 
+	if (prop_rate > 0) {
+		g_timeout_add(LOAD_TICK_MS, load_props, root);
+	}
+
+	if (churn_interval > 0) {
+		g_timeout_add(churn_interval, load_churn, root);
+	}
+
+	if (storm_interval > 0) {
+		g_timeout_add(storm_interval, load_storm, root);
+	}
+
+	if (stats) {
+		g_dbus_connection_add_filter(connection, bus_filter, NULL, NULL);
+		g_timeout_add_seconds(1, load_stats, NULL);
+	}
+
 	return;
 }
 
@@ -135,11 +505,29 @@ name_lost (GDBusConnection * connection, const gchar * name, gpointer user_data)
 
 int main (int argc, char ** argv)
 {
-	if (argc != 2) {
-		g_warning(USAGE);
+	GError * error = NULL;
+	GOptionContext * context = g_option_context_new(USAGE);
+	g_option_context_set_summary(context, "Serves a menu from a JSON file, or a generated one when no file is given.");
+
+	GOptionGroup * group = g_option_group_new("generate", "Menu generation options:", "Show menu generation options", NULL, NULL);
+	g_option_group_add_entries(group, gen_entries);
+	g_option_context_add_group(context, group);
+
+	group = g_option_group_new("load", "Load options:", "Show load options", NULL, NULL);
+	g_option_group_add_entries(group, load_entries);
+	g_option_context_add_group(context, group);
+
+	if (!g_option_context_parse(context, &argc, &argv, &error) || argc > 2) {
+		g_warning("%s", error != NULL ? error->message : USAGE);
+		g_clear_error(&error);
+		g_option_context_free(context);
 		return 1;
 	}
-	const char *filename = argv[1];
+	g_option_context_free(context);
+
+	const char *filename = argc == 2 ? argv[1] : NULL;
+
+	generator = g_rand_new_with_seed(seed);
 
 	g_bus_own_name(G_BUS_TYPE_SESSION,
 	               "org.dbusmenu.test",